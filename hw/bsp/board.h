@@ -92,6 +92,14 @@ static inline uint32_t board_millis(void)
     return (((uint64_t)rt_tick_get()) * 1000 / RT_TICK_PER_SECOND);
   }
 
+#elif CFG_TUSB_OS == OPT_OS_POSIX
+  static inline uint32_t board_millis(void)
+  {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint32_t) (((uint64_t) ts.tv_sec) * 1000 + ts.tv_nsec / 1000000);
+  }
+
 #else
   #error "board_millis() is not implemented for this OS"
 #endif
@@ -87,6 +87,10 @@ typedef struct
 #if CFG_TUD_AUDIO_N_AS_INT
   uint8_t altSetting[CFG_TUD_AUDIO_N_AS_INT];   // We need to save the current alternate setting this way, because it is possible that there are AS interfaces which do not have an EP!
 #endif
+
+  // Index of the audio function built by audiod_open() - AS interfaces are numbered consecutively after the AC interface (grouped by IAD)
+  uint8_t itf_count;            // Number of AC and AS interfaces
+  uint8_t entity_map[32];       // Bitmap of entity IDs defined by the class specific AC descriptors
   /*------------- From this point, data is not cleared by bus reset -------------*/
 
   // Buffer for control requests
@@ -157,10 +161,11 @@ static bool audiod_tx_done_type_I_pcm_ff_cb(uint8_t rhport, audiod_interface_t*
 static bool audiod_get_interface(uint8_t rhport, tusb_control_request_t const * p_request);
 static bool audiod_set_interface(uint8_t rhport, tusb_control_request_t const * p_request);
 
-static bool audiod_get_AS_interface_index(uint8_t itf, uint8_t *idxDriver, uint8_t *idxItf, uint8_t const **pp_desc_int);
-static bool audiod_verify_entity_exists(uint8_t itf, uint8_t entityID, uint8_t *idxDriver);
-static bool audiod_verify_itf_exists(uint8_t itf, uint8_t *idxDriver);
-static bool audiod_verify_ep_exists(uint8_t ep, uint8_t *idxDriver);
+static bool audiod_get_driver_index(uint8_t rhport, uint8_t itf, uint8_t *idxDriver);
+static bool audiod_get_AS_interface_index(uint8_t rhport, uint8_t itf, uint8_t *idxDriver, uint8_t *idxItf, uint8_t const **pp_desc_int);
+static bool audiod_verify_entity_exists(uint8_t rhport, uint8_t itf, uint8_t entityID, uint8_t *idxDriver);
+static bool audiod_verify_itf_exists(uint8_t rhport, uint8_t itf, uint8_t *idxDriver);
+static bool audiod_verify_ep_exists(uint8_t rhport, uint8_t ep, uint8_t *idxDriver);
 
 bool tud_audio_n_mounted(uint8_t itf)
 {
@@ -203,7 +208,7 @@ bool tud_audio_n_mounted(uint8_t itf)
 
 #if CFG_TUD_AUDIO_EPSIZE_OUT && CFG_TUD_AUDIO_RX_FIFO_SIZE
 #if CFG_TUD_AUDIO_RX_FIFO_COUNT > 1
-uint16_t tud_audio_n_available(uint8_t itf, uint8_t channelId)
+uint32_t tud_audio_n_available(uint8_t itf, uint8_t channelId)
 {
   TU_VERIFY(channelId < CFG_TUD_AUDIO_N_CHANNELS_RX);
   return tu_fifo_count(&_audiod_itf[itf].rx_ff[channelId]);
@@ -221,7 +226,7 @@ void tud_audio_n_read_flush (uint8_t itf, uint8_t channelId)
   tu_fifo_clear(&_audiod_itf[itf].rx_ff[channelId]);
 }
 #else
-uint16_t tud_audio_n_available(uint8_t itf)
+uint32_t tud_audio_n_available(uint8_t itf)
 {
   return tu_fifo_count(&_audiod_itf[itf].rx_ff[0]);
 }
@@ -321,31 +326,15 @@ static bool audio_rx_done_type_I_pcm_ff_cb(uint8_t rhport, audiod_interface_t* a
     return false;
   }
 
-  uint8_t chId = 0;
-  uint16_t cnt;
-#if CFG_TUD_AUDIO_N_BYTES_PER_SAMPLE_RX == 1
-  uint8_t sample = 0;
-#elif CFG_TUD_AUDIO_N_BYTES_PER_SAMPLE_RX == 2
-  uint16_t sample = 0;
-#else
-  uint32_t sample = 0;
-#endif
-
-  for(cnt = 0; cnt < bufsize; cnt += CFG_TUD_AUDIO_N_BYTES_PER_SAMPLE_RX)
+  // Split frames into one FIFO per channel
+  tu_fifo_idx_t const nSamplesPerChannel = bufsize / (CFG_TUD_AUDIO_N_BYTES_PER_SAMPLE_RX * CFG_TUD_AUDIO_N_CHANNELS_RX);
+  if (tu_fifo_write_n_interleaved(audio->rx_ff, CFG_TUD_AUDIO_RX_FIFO_COUNT, buffer, nSamplesPerChannel,
+                                  CFG_TUD_AUDIO_RX_ITEMSIZE, CFG_TUD_AUDIO_N_BYTES_PER_SAMPLE_RX) != nSamplesPerChannel)
   {
-    // Let alignment problems be handled by memcpy
-    memcpy(&sample, &buffer[cnt], CFG_TUD_AUDIO_N_BYTES_PER_SAMPLE_RX);
-    if(tu_fifo_write_n(&audio->rx_ff[chId++], &sample, CFG_TUD_AUDIO_RX_ITEMSIZE) != CFG_TUD_AUDIO_RX_ITEMSIZE)
-    {
-      // Buffer overflow
-      return false;
-    }
-
-    if (chId == CFG_TUD_AUDIO_N_CHANNELS_RX)
-    {
-      chId = 0;
-    }
+    // Buffer overflow
+    return false;
   }
+
   return true;
 }
 #else
@@ -466,6 +455,73 @@ uint32_t tud_audio_int_ctr_n_write(uint8_t itf, uint8_t const* buffer, uint32_t
 }
 #endif
 
+#if CFG_TUSB_FIFO_STATS
+//--------------------------------------------------------------------+
+// FIFO STATISTICS API
+//--------------------------------------------------------------------+
+
+#if CFG_TUD_AUDIO_EPSIZE_OUT && CFG_TUD_AUDIO_RX_FIFO_SIZE
+bool tud_audio_n_rx_fifo_stats(uint8_t itf, uint8_t fifoId, tu_fifo_stats_t* stats)
+{
+  TU_VERIFY(fifoId < CFG_TUD_AUDIO_RX_FIFO_COUNT);
+  tu_fifo_get_stats(&_audiod_itf[itf].rx_ff[fifoId], stats);
+  return true;
+}
+#endif
+
+#if CFG_TUD_AUDIO_EPSIZE_IN && CFG_TUD_AUDIO_TX_FIFO_SIZE
+bool tud_audio_n_tx_fifo_stats(uint8_t itf, uint8_t fifoId, tu_fifo_stats_t* stats)
+{
+  TU_VERIFY(fifoId < CFG_TUD_AUDIO_TX_FIFO_COUNT);
+  tu_fifo_get_stats(&_audiod_itf[itf].tx_ff[fifoId], stats);
+  return true;
+}
+#endif
+
+void tud_audio_n_fifo_stats_reset(uint8_t itf)
+{
+  audiod_interface_t* audio = &_audiod_itf[itf];
+  (void) audio;
+
+#if CFG_TUD_AUDIO_EPSIZE_OUT && CFG_TUD_AUDIO_RX_FIFO_SIZE
+  for (uint8_t i = 0; i < CFG_TUD_AUDIO_RX_FIFO_COUNT; i++) tu_fifo_reset_stats(&audio->rx_ff[i]);
+#endif
+
+#if CFG_TUD_AUDIO_EPSIZE_IN && CFG_TUD_AUDIO_TX_FIFO_SIZE
+  for (uint8_t i = 0; i < CFG_TUD_AUDIO_TX_FIFO_COUNT; i++) tu_fifo_reset_stats(&audio->tx_ff[i]);
+#endif
+
+#if CFG_TUD_AUDIO_INT_CTR_EPSIZE_IN
+  tu_fifo_reset_stats(&audio->int_ctr_ff);
+#endif
+}
+#endif
+
+#if CFG_TUSB_FIFO_TAP
+//--------------------------------------------------------------------+
+// FIFO TAP API
+//--------------------------------------------------------------------+
+
+#if CFG_TUD_AUDIO_EPSIZE_OUT && CFG_TUD_AUDIO_RX_FIFO_SIZE
+bool tud_audio_n_rx_tap_attach(uint8_t itf, uint8_t fifoId, tu_fifo_tap_t* tap)
+{
+  TU_VERIFY(fifoId < CFG_TUD_AUDIO_RX_FIFO_COUNT);
+  tu_fifo_tap_attach(tap, &_audiod_itf[itf].rx_ff[fifoId]);
+  return true;
+}
+#endif
+
+#if CFG_TUD_AUDIO_EPSIZE_IN && CFG_TUD_AUDIO_TX_FIFO_SIZE
+bool tud_audio_n_tx_tap_attach(uint8_t itf, uint8_t fifoId, tu_fifo_tap_t* tap)
+{
+  TU_VERIFY(fifoId < CFG_TUD_AUDIO_TX_FIFO_COUNT);
+  tu_fifo_tap_attach(tap, &_audiod_itf[itf].tx_ff[fifoId]);
+  return true;
+}
+#endif
+
+#endif
+
 
 // This function is called once a transmit of an audio packet was successfully completed. Here, we encode samples and place it in IN EP's buffer for next transmission.
 // If you prefer your own (more efficient) implementation suiting your purpose set CFG_TUD_AUDIO_TX_FIFO_SIZE = 0 and use tud_audio_n_write_ep_in_buffer() (NOT IMPLEMENTED SO FAR).
@@ -481,7 +537,7 @@ static bool audiod_tx_done_cb(uint8_t rhport, audiod_interface_t* audio, uint16_
   if (tud_audio_tx_done_pre_load_cb || tud_audio_tx_done_post_load_cb)
   {
     // Find index of audio streaming interface and index of interface
-    TU_VERIFY(audiod_get_AS_interface_index(audio->ep_in_as_intf_num, &idxDriver, &idxItf, &dummy2));
+    TU_VERIFY(audiod_get_AS_interface_index(rhport, audio->ep_in_as_intf_num, &idxDriver, &idxItf, &dummy2));
   }
 
   // Call a weak callback here - a possibility for user to get informed former TX was completed and data gets now loaded into EP in buffer (in case FIFOs are used) or
@@ -558,56 +614,20 @@ static bool audiod_tx_done_type_I_pcm_ff_cb(uint8_t rhport, audiod_interface_t*
 
   // Determine amount of samples
   uint16_t const nEndpointSampleCapacity = CFG_TUD_AUDIO_EPSIZE_IN / CFG_TUD_AUDIO_N_CHANNELS_TX / CFG_TUD_AUDIO_N_BYTES_PER_SAMPLE_TX;
-  uint16_t nSamplesPerChannelToSend = tu_fifo_count(&audio->tx_ff[0]) / CFG_TUD_AUDIO_TX_ITEMSIZE;
-  uint16_t nBytesToSend;
-  uint8_t cntChannel;
-
-  for (cntChannel = 1; cntChannel < CFG_TUD_AUDIO_N_CHANNELS_TX; cntChannel++)
-  {
-    uint16_t const count = tu_fifo_count(&audio->tx_ff[cntChannel]);
-    if (count / CFG_TUD_AUDIO_TX_ITEMSIZE < nSamplesPerChannelToSend)
-    {
-      nSamplesPerChannelToSend = count * CFG_TUD_AUDIO_TX_ITEMSIZE;
-    }
-  }
-
-  // Check if there is enough
-  if (nSamplesPerChannelToSend == 0)
-  {
-    audio->epin_buf_cnt = 0;
-    return true;
-  }
 
-  // Limit to maximum sample number - THIS IS A POSSIBLE ERROR SOURCE IF TOO MANY SAMPLE WOULD NEED TO BE SENT BUT CAN NOT!
-  nSamplesPerChannelToSend = tu_min16(nSamplesPerChannelToSend, nEndpointSampleCapacity);
-  nBytesToSend = nSamplesPerChannelToSend * CFG_TUD_AUDIO_N_CHANNELS_TX * CFG_TUD_AUDIO_N_BYTES_PER_SAMPLE_TX;
-
-  // Encode
-  uint16_t cntSample;
-  uint8_t * pBuff = audio->epin_buf;
-#if CFG_TUD_AUDIO_N_BYTES_PER_SAMPLE_TX == 1
-  uint8_t sample;
-#elif CFG_TUD_AUDIO_N_BYTES_PER_SAMPLE_TX == 2
-  uint16_t sample;
+#if CFG_TUD_AUDIO_TX_FIFO_COUNT > 1
+  // One FIFO per channel, as many samples as all channels have are sent
+  tu_fifo_idx_t const nSamplesPerFifo = nEndpointSampleCapacity;
 #else
-  uint32_t sample;
+  // All channels in one FIFO, only complete frames are sent
+  tu_fifo_idx_t const nSamplesPerFifo = tu_min32(tu_fifo_count(&audio->tx_ff[0]) / CFG_TUD_AUDIO_TX_ITEMSIZE / CFG_TUD_AUDIO_N_CHANNELS_TX,
+                                                 nEndpointSampleCapacity) * CFG_TUD_AUDIO_N_CHANNELS_TX;
 #endif
 
-  // TODO: Big endianess handling
-  for (cntSample = 0; cntSample < nSamplesPerChannelToSend; cntSample++)
-  {
-    for (cntChannel = 0; cntChannel < CFG_TUD_AUDIO_N_CHANNELS_TX; cntChannel++)
-    {
-      // Get sample from buffer
-      tu_fifo_read_n(&audio->tx_ff[cntChannel], &sample, CFG_TUD_AUDIO_TX_ITEMSIZE);
-
-      // Put it into EP's buffer - Let alignment problems be handled by memcpy
-      memcpy(pBuff, &sample, CFG_TUD_AUDIO_N_BYTES_PER_SAMPLE_TX);
-
-      // Advance pointer
-      pBuff += CFG_TUD_AUDIO_N_BYTES_PER_SAMPLE_TX;
-    }
-  }
+  // Encode - TODO: Big endianess handling
+  tu_fifo_idx_t const nSamples = tu_fifo_read_n_interleaved(audio->tx_ff, CFG_TUD_AUDIO_TX_FIFO_COUNT, audio->epin_buf, nSamplesPerFifo,
+                                                            CFG_TUD_AUDIO_TX_ITEMSIZE, CFG_TUD_AUDIO_N_BYTES_PER_SAMPLE_TX);
+  uint16_t const nBytesToSend = nSamples * CFG_TUD_AUDIO_TX_FIFO_COUNT * CFG_TUD_AUDIO_N_BYTES_PER_SAMPLE_TX;
 
   audio->epin_buf_cnt = nBytesToSend;
 
@@ -621,9 +641,7 @@ static bool audiod_tx_done_type_I_pcm_ff_cb(uint8_t rhport, audiod_interface_t*
   TU_VERIFY(!usbd_edpt_busy(rhport, audio->ep_in));
 
   // Determine amount of samples
-  uint16_t nByteCount = tu_fifo_count(&audio->tx_ff[0]);
-
-  nByteCount = tu_min16(nByteCount, CFG_TUD_AUDIO_EPSIZE_IN);
+  uint16_t nByteCount = (uint16_t) tu_min32(tu_fifo_count(&audio->tx_ff[0]), CFG_TUD_AUDIO_EPSIZE_IN);
 
   // Check if there is enough
   if (nByteCount == 0)
@@ -758,11 +776,13 @@ void audiod_init(void)
 
 void audiod_reset(uint8_t rhport)
 {
-  (void) rhport;
-
   for(uint8_t i=0; i<CFG_TUD_AUDIO; i++)
   {
     audiod_interface_t* audio = &_audiod_itf[i];
+
+    // skip interface bound to the other device port
+    if ( audio->p_desc && (audio->rhport != rhport) ) continue;
+
     tu_memclr(audio, ITF_MEM_RESET_SIZE);
 
 #if CFG_TUD_AUDIO_EPSIZE_IN && CFG_TUD_AUDIO_TX_FIFO_SIZE
@@ -781,6 +801,35 @@ void audiod_reset(uint8_t rhport)
   }
 }
 
+// Count the interfaces of the audio function and collect the entity IDs defined in between the class specific AC descriptors
+static void audiod_build_index(audiod_interface_t* audio, uint16_t drv_len)
+{
+  uint8_t const *p_desc = audio->p_desc;
+  uint8_t const *p_desc_end = p_desc + drv_len;
+
+  audio->itf_count = 0;
+  tu_varclr(&audio->entity_map);
+
+  // Get pointers after class specific AC descriptors and end of AC descriptors - entities are defined in between
+  uint8_t const *p_cs_ac = tu_desc_next(p_desc);
+  uint8_t const *p_cs_ac_end = p_cs_ac + ((audio_desc_cs_ac_interface_t const *)p_cs_ac)->wTotalLength;
+
+  for (uint8_t const *p_entity = tu_desc_next(p_cs_ac); p_entity < p_cs_ac_end; p_entity = tu_desc_next(p_entity))
+  {
+    uint8_t const entityID = p_entity[3];  // Entity IDs are always at offset 3
+    audio->entity_map[entityID / 8] |= (uint8_t) TU_BIT(entityID % 8);
+  }
+
+  while (p_desc < p_desc_end)
+  {
+    if (tu_desc_type(p_desc) == TUSB_DESC_INTERFACE && ((tusb_desc_interface_t const *)p_desc)->bAlternateSetting == 0)
+    {
+      audio->itf_count++;
+    }
+    p_desc = tu_desc_next(p_desc);
+  }
+}
+
 uint16_t audiod_open(uint8_t rhport, tusb_desc_interface_t const * itf_desc, uint16_t max_len)
 {
   (void) max_len;
@@ -819,6 +868,9 @@ uint16_t audiod_open(uint8_t rhport, tusb_desc_interface_t const * itf_desc, uin
   // TODO: Find a way to find end of current audio function and avoid necessity of tud_audio_desc_lengths - since now max_length is available we could do this surely somehow
   uint16_t drv_len = tud_audio_desc_lengths[i] - TUD_AUDIO_DESC_IAD_LEN;    // - TUD_AUDIO_DESC_IAD_LEN since tinyUSB already handles the IAD descriptor
 
+  // Index interfaces and entities once, so that requests do not need to search through the descriptors
+  audiod_build_index(&_audiod_itf[i], drv_len);
+
   return drv_len;
 }
 
@@ -831,7 +883,7 @@ static bool audiod_get_interface(uint8_t rhport, tusb_control_request_t const *
   uint8_t idxDriver, idxItf;
   uint8_t const *dummy;
 
-  TU_VERIFY(audiod_get_AS_interface_index(itf, &idxDriver, &idxItf, &dummy));
+  TU_VERIFY(audiod_get_AS_interface_index(rhport, itf, &idxDriver, &idxItf, &dummy));
   TU_VERIFY(tud_control_xfer(rhport, p_request, &_audiod_itf[idxDriver].altSetting[idxItf], 1));
 
   TU_LOG2("  Get itf: %u - current alt: %u\r\n", itf, _audiod_itf[idxDriver].altSetting[idxItf]);
@@ -852,8 +904,8 @@ static bool audiod_set_interface(uint8_t rhport, tusb_control_request_t const *
   // Here we need to do the following:
 
   // 1. Find the audio driver assigned to the given interface to be set
-  // Since one audio driver interface has to be able to cover an unknown number of interfaces (AC, AS + its alternate settings), the best memory efficient way to solve this is to always search through the descriptors.
-  // The audio driver is mapped to an audio function by a reference pointer to the corresponding AC interface of this audio function which serves as a starting point for searching
+  // Since one audio driver interface has to be able to cover an unknown number of interfaces (AC, AS + its alternate settings), the audio function is found by its interface range
+  // and the alternate settings of the interface are looked up in the configuration index built by the stack at SET_CONFIGURATION
 
   // 2. Close EPs which are currently open
   // To do so it is not necessary to know the current active alternate interface since we already save the current EP addresses - we simply close them
@@ -868,7 +920,7 @@ static bool audiod_set_interface(uint8_t rhport, tusb_control_request_t const *
   // Find index of audio streaming interface and index of interface
   uint8_t idxDriver, idxItf;
   uint8_t const *p_desc;
-  TU_VERIFY(audiod_get_AS_interface_index(itf, &idxDriver, &idxItf, &p_desc));
+  TU_VERIFY(audiod_get_AS_interface_index(rhport, itf, &idxDriver, &idxItf, &p_desc));
 
   // Look if there is an EP to be closed - for this driver, there are only 3 possible EPs which may be closed (only AS related EPs can be closed, AC EP (if present) is always open)
 #if CFG_TUD_AUDIO_EPSIZE_IN > 0
@@ -903,8 +955,8 @@ static bool audiod_set_interface(uint8_t rhport, tusb_control_request_t const *
   _audiod_itf[idxDriver].altSetting[idxItf] = alt;
 
   // Open new EP if necessary - EPs are only to be closed or opened for AS interfaces - Look for AS interface with correct alternate interface
-  // Get pointer at end
-  uint8_t const *p_desc_end = _audiod_itf[idxDriver].p_desc + tud_audio_desc_lengths[idxDriver] - TUD_AUDIO_DESC_IAD_LEN;
+  // Get pointer at end of the alternate settings of this interface
+  uint8_t const *p_desc_end = p_desc + usbd_itf_desc_len(rhport, itf);
 
   // p_desc starts at required interface with alternate setting zero
   while (p_desc < p_desc_end)
@@ -1008,7 +1060,7 @@ static bool audiod_control_complete(uint8_t rhport, tusb_control_request_t const
         if (tud_audio_set_req_entity_cb)
         {
           // Check if entity is present and get corresponding driver index
-          TU_VERIFY(audiod_verify_entity_exists(itf, entityID, &idxDriver));
+          TU_VERIFY(audiod_verify_entity_exists(rhport, itf, entityID, &idxDriver));
 
           // Invoke callback
           return tud_audio_set_req_entity_cb(rhport, p_request, _audiod_itf[idxDriver].ctrl_buf);
@@ -1024,7 +1076,7 @@ static bool audiod_control_complete(uint8_t rhport, tusb_control_request_t const
         if (tud_audio_set_req_itf_cb)
         {
           // Find index of audio driver structure and verify interface really exists
-          TU_VERIFY(audiod_verify_itf_exists(itf, &idxDriver));
+          TU_VERIFY(audiod_verify_itf_exists(rhport, itf, &idxDriver));
 
           // Invoke callback
           return tud_audio_set_req_itf_cb(rhport, p_request, _audiod_itf[idxDriver].ctrl_buf);
@@ -1045,7 +1097,7 @@ static bool audiod_control_complete(uint8_t rhport, tusb_control_request_t const
       if (tud_audio_set_req_ep_cb)
       {
         // Check if entity is present and get corresponding driver index
-        TU_VERIFY(audiod_verify_ep_exists(ep, &idxDriver));
+        TU_VERIFY(audiod_verify_ep_exists(rhport, ep, &idxDriver));
 
         // Invoke callback
         return tud_audio_set_req_ep_cb(rhport, p_request, _audiod_itf[idxDriver].ctrl_buf);
@@ -1102,7 +1154,7 @@ static bool audiod_control_request(uint8_t rhport, tusb_control_request_t const
       if (entityID != 0)
       {
         // Find index of audio driver structure and verify entity really exists
-        TU_VERIFY(audiod_verify_entity_exists(itf, entityID, &idxDriver));
+        TU_VERIFY(audiod_verify_entity_exists(rhport, itf, entityID, &idxDriver));
 
         // In case we got a get request invoke callback - callback needs to answer as defined in UAC2 specification page 89 - 5. Requests
         if (p_request->bmRequestType_bit.direction == TUSB_DIR_IN)
@@ -1121,7 +1173,7 @@ static bool audiod_control_request(uint8_t rhport, tusb_control_request_t const
       else
       {
         // Find index of audio driver structure and verify interface really exists
-        TU_VERIFY(audiod_verify_itf_exists(itf, &idxDriver));
+        TU_VERIFY(audiod_verify_itf_exists(rhport, itf, &idxDriver));
 
         // In case we got a get request invoke callback - callback needs to answer as defined in UAC2 specification page 89 - 5. Requests
         if (p_request->bmRequestType_bit.direction == TUSB_DIR_IN)
@@ -1144,7 +1196,7 @@ static bool audiod_control_request(uint8_t rhport, tusb_control_request_t const
       uint8_t ep = TU_U16_LOW(p_request->wIndex);
 
       // Find index of audio driver structure and verify EP really exists
-      TU_VERIFY(audiod_verify_ep_exists(ep, &idxDriver));
+      TU_VERIFY(audiod_verify_ep_exists(rhport, ep, &idxDriver));
 
       // In case we got a get request invoke callback - callback needs to answer as defined in UAC2 specification page 89 - 5. Requests
       if (p_request->bmRequestType_bit.direction == TUSB_DIR_IN)
@@ -1295,12 +1347,12 @@ bool tud_audio_buffer_and_schedule_control_xfer(uint8_t rhport, tusb_control_req
     if (entityID != 0)
     {
       // Find index of audio driver structure and verify entity really exists
-      TU_VERIFY(audiod_verify_entity_exists(itf, entityID, &idxDriver));
+      TU_VERIFY(audiod_verify_entity_exists(rhport, itf, entityID, &idxDriver));
     }
     else
     {
       // Find index of audio driver structure and verify interface really exists
-      TU_VERIFY(audiod_verify_itf_exists(itf, &idxDriver));
+      TU_VERIFY(audiod_verify_itf_exists(rhport, itf, &idxDriver));
     }
     break;
 
@@ -1309,7 +1361,7 @@ bool tud_audio_buffer_and_schedule_control_xfer(uint8_t rhport, tusb_control_req
     uint8_t ep = TU_U16_LOW(p_request->wIndex);
 
     // Find index of audio driver structure and verify EP really exists
-    TU_VERIFY(audiod_verify_ep_exists(ep, &idxDriver));
+    TU_VERIFY(audiod_verify_ep_exists(rhport, ep, &idxDriver));
     break;
 
     // Unknown/Unsupported recipient
@@ -1326,39 +1378,22 @@ bool tud_audio_buffer_and_schedule_control_xfer(uint8_t rhport, tusb_control_req
   return tud_control_xfer(rhport, p_request, (void*)_audiod_itf[idxDriver].ctrl_buf, len);
 }
 
-// This helper function finds for a given AS interface number the index of the attached driver structure, the index of the interface in the audio function
-// (e.g. the std. AS interface with interface number 15 is the first AS interface for the given audio function and thus gets index zero), and
-// finally a pointer to the std. AS interface, where the pointer always points to the first alternate setting i.e. alternate interface zero.
-static bool audiod_get_AS_interface_index(uint8_t itf, uint8_t *idxDriver, uint8_t *idxItf, uint8_t const **pp_desc_int)
+// This helper function finds for a given interface number the index of the driver structure of the audio function the interface belongs to
+static bool audiod_get_driver_index(uint8_t rhport, uint8_t itf, uint8_t *idxDriver)
 {
-  // Loop over audio driver interfaces
-  uint8_t i;
-  for (i = 0; i < CFG_TUD_AUDIO; i++)
+  for (uint8_t i = 0; i < CFG_TUD_AUDIO; i++)
   {
-    if (_audiod_itf[i].p_desc)
-    {
-      // Get pointer at end
-      uint8_t const *p_desc_end = _audiod_itf[i].p_desc + tud_audio_desc_lengths[i] - TUD_AUDIO_DESC_IAD_LEN;
+    audiod_interface_t const *audio = &_audiod_itf[i];
 
-      // Advance past AC descriptors
-      uint8_t const *p_desc = tu_desc_next(_audiod_itf[i].p_desc);
-      p_desc += ((audio_desc_cs_ac_interface_t const *)p_desc)->wTotalLength;
+    if (audio->p_desc && audio->rhport == rhport)
+    {
+      // Interfaces of an audio function are consecutive starting with the AC interface
+      uint8_t const itf_ac = ((tusb_desc_interface_t const *)audio->p_desc)->bInterfaceNumber;
 
-      uint8_t tmp = 0;
-      while (p_desc < p_desc_end)
+      if (itf_ac <= itf && itf < itf_ac + audio->itf_count)
       {
-        // We assume the number of alternate settings is increasing thus we return the index of alternate setting zero!
-        if (tu_desc_type(p_desc) == TUSB_DESC_INTERFACE && ((tusb_desc_interface_t const * )p_desc)->bInterfaceNumber == itf)
-        {
-          *idxItf = tmp;
-          *idxDriver = i;
-          *pp_desc_int = p_desc;
-          return true;
-        }
-
-        // Increase index, bytes read, and pointer
-        tmp++;
-        p_desc = tu_desc_next(p_desc);
+        *idxDriver = i;
+        return true;
       }
     }
   }
@@ -1366,85 +1401,50 @@ static bool audiod_get_AS_interface_index(uint8_t itf, uint8_t *idxDriver, uint8
   return false;
 }
 
-// Verify an entity with the given ID exists and returns also the corresponding driver index
-static bool audiod_verify_entity_exists(uint8_t itf, uint8_t entityID, uint8_t *idxDriver)
+// This helper function finds for a given AS interface number the index of the attached driver structure, the index of the interface in the audio function
+// (e.g. the std. AS interface with interface number 15 is the first AS interface for the given audio function and thus gets index zero), and
+// finally a pointer to the std. AS interface, where the pointer always points to the first alternate setting i.e. alternate interface zero.
+static bool audiod_get_AS_interface_index(uint8_t rhport, uint8_t itf, uint8_t *idxDriver, uint8_t *idxItf, uint8_t const **pp_desc_int)
 {
-  uint8_t i;
-  for (i = 0; i < CFG_TUD_AUDIO; i++)
-  {
-    // Look for the correct driver by checking if the unique standard AC interface number fits
-    if (_audiod_itf[i].p_desc && ((tusb_desc_interface_t const *)_audiod_itf[i].p_desc)->bInterfaceNumber == itf)
-    {
-      // Get pointers after class specific AC descriptors and end of AC descriptors - entities are defined in between
-      uint8_t const *p_desc = tu_desc_next(_audiod_itf[i].p_desc);                                          // Points to CS AC descriptor
-      uint8_t const *p_desc_end = ((audio_desc_cs_ac_interface_t const *)p_desc)->wTotalLength + p_desc;
-      p_desc = tu_desc_next(p_desc);                                                                            // Get past CS AC descriptor
+  TU_VERIFY(audiod_get_driver_index(rhport, itf, idxDriver));
 
-      while (p_desc < p_desc_end)
-      {
-        if (p_desc[3] == entityID)  // Entity IDs are always at offset 3
-        {
-          *idxDriver = i;
-          return true;
-        }
-        p_desc = tu_desc_next(p_desc);
-      }
-    }
-  }
-  return false;
+  // AS interfaces follow the AC interface
+  uint8_t const itf_ac = ((tusb_desc_interface_t const *)_audiod_itf[*idxDriver].p_desc)->bInterfaceNumber;
+  TU_VERIFY(itf != itf_ac);
+
+  *idxItf = (uint8_t) (itf - itf_ac - 1);
+#if CFG_TUD_AUDIO_N_AS_INT
+  TU_VERIFY(*idxItf < CFG_TUD_AUDIO_N_AS_INT);
+#endif
+
+  *pp_desc_int = usbd_itf_desc(rhport, itf);
+  return *pp_desc_int != NULL;
 }
 
-static bool audiod_verify_itf_exists(uint8_t itf, uint8_t *idxDriver)
+// Verify an entity with the given ID exists and returns also the corresponding driver index
+static bool audiod_verify_entity_exists(uint8_t rhport, uint8_t itf, uint8_t entityID, uint8_t *idxDriver)
 {
-  uint8_t i;
-  for (i = 0; i < CFG_TUD_AUDIO; i++)
-  {
-    if (_audiod_itf[i].p_desc)
-    {
-      // Get pointer at beginning and end
-      uint8_t const *p_desc = _audiod_itf[i].p_desc;
-      uint8_t const *p_desc_end = _audiod_itf[i].p_desc + tud_audio_desc_lengths[i] - TUD_AUDIO_DESC_IAD_LEN;
+  TU_VERIFY(audiod_get_driver_index(rhport, itf, idxDriver));
 
-      while (p_desc < p_desc_end)
-      {
-        if (tu_desc_type(p_desc) == TUSB_DESC_INTERFACE && ((tusb_desc_interface_t const *)_audiod_itf[i].p_desc)->bInterfaceNumber == itf)
-        {
-          *idxDriver = i;
-          return true;
-        }
-        p_desc = tu_desc_next(p_desc);
-      }
-    }
-  }
-  return false;
+  // Entities are addressed through the AC interface
+  audiod_interface_t const *audio = &_audiod_itf[*idxDriver];
+  TU_VERIFY(((tusb_desc_interface_t const *)audio->p_desc)->bInterfaceNumber == itf);
+
+  return tu_bit_test(audio->entity_map[entityID / 8], entityID % 8);
 }
 
-static bool audiod_verify_ep_exists(uint8_t ep, uint8_t *idxDriver)
+static bool audiod_verify_itf_exists(uint8_t rhport, uint8_t itf, uint8_t *idxDriver)
 {
-  uint8_t i;
-  for (i = 0; i < CFG_TUD_AUDIO; i++)
-  {
-    if (_audiod_itf[i].p_desc)
-    {
-      // Get pointer at end
-      uint8_t const *p_desc_end = _audiod_itf[i].p_desc + tud_audio_desc_lengths[i];
+  return audiod_get_driver_index(rhport, itf, idxDriver);
+}
 
-      // Advance past AC descriptors - EP we look for are streaming EPs
-      uint8_t const *p_desc = tu_desc_next(_audiod_itf[i].p_desc);
-      p_desc += ((audio_desc_cs_ac_interface_t const *)p_desc)->wTotalLength;
+static bool audiod_verify_ep_exists(uint8_t rhport, uint8_t ep, uint8_t *idxDriver)
+{
+  uint8_t const itf = usbd_edpt_itf(rhport, ep);
+  TU_VERIFY(audiod_get_driver_index(rhport, itf, idxDriver));
 
-      while (p_desc < p_desc_end)
-      {
-        if (tu_desc_type(p_desc) == TUSB_DESC_ENDPOINT && ((tusb_desc_endpoint_t const * )p_desc)->bEndpointAddress == ep)
-        {
-          *idxDriver = i;
-          return true;
-        }
-        p_desc = tu_desc_next(p_desc);
-      }
-    }
-  }
-  return false;
+  // EP we look for are streaming EPs
+  return ((tusb_desc_interface_t const *)_audiod_itf[*idxDriver].p_desc)->bInterfaceNumber != itf;
 }
 
 #if CFG_TUD_AUDIO_ENABLE_FEEDBACK_EP
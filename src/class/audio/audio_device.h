@@ -30,6 +30,8 @@
 
 #include "assert.h"
 #include "common/tusb_common.h"
+#include "osal/osal.h"
+#include "common/tusb_fifo.h"
 #include "device/usbd.h"
 
 #include "audio.h"
@@ -172,11 +174,11 @@ bool     tud_audio_n_mounted    (uint8_t itf);
 
 #if CFG_TUD_AUDIO_EPSIZE_OUT && CFG_TUD_AUDIO_RX_FIFO_SIZE
 #if CFG_TUD_AUDIO_RX_FIFO_COUNT > 1
-uint16_t tud_audio_n_available  (uint8_t itf, uint8_t channelId);
+uint32_t tud_audio_n_available  (uint8_t itf, uint8_t channelId);
 uint16_t tud_audio_n_read       (uint8_t itf, uint8_t channelId, void* buffer, uint16_t bufsize);
 void     tud_audio_n_read_flush (uint8_t itf, uint8_t channelId);
 #else
-uint16_t tud_audio_n_available  (uint8_t itf);
+uint32_t tud_audio_n_available  (uint8_t itf);
 uint16_t tud_audio_n_read       (uint8_t itf, void* buffer, uint16_t bufsize);
 void     tud_audio_n_read_flush (uint8_t itf);
 #endif
@@ -201,6 +203,29 @@ uint16_t tud_audio_n_write      (uint8_t itf, const void * data, uint16_t len);
 uint16_t tud_audio_n_write_flush(uint8_t itf);
 #endif
 
+#if CFG_TUSB_FIFO_STATS
+// Get usage statistics of a FIFO, fifoId is the channel (or FIFO) index if CFG_TUD_AUDIO_RX/TX_FIFO_COUNT > 1, else 0
+#if CFG_TUD_AUDIO_EPSIZE_OUT && CFG_TUD_AUDIO_RX_FIFO_SIZE
+bool     tud_audio_n_rx_fifo_stats    (uint8_t itf, uint8_t fifoId, tu_fifo_stats_t* stats);
+#endif
+#if CFG_TUD_AUDIO_EPSIZE_IN && CFG_TUD_AUDIO_TX_FIFO_SIZE
+bool     tud_audio_n_tx_fifo_stats    (uint8_t itf, uint8_t fifoId, tu_fifo_stats_t* stats);
+#endif
+
+// Reset usage statistics of all FIFOs of this interface
+void     tud_audio_n_fifo_stats_reset (uint8_t itf);
+#endif
+
+#if CFG_TUSB_FIFO_TAP
+// Attach a tap to monitor the samples of a FIFO, fifoId as for the FIFO statistics
+#if CFG_TUD_AUDIO_EPSIZE_OUT && CFG_TUD_AUDIO_RX_FIFO_SIZE
+bool     tud_audio_n_rx_tap_attach    (uint8_t itf, uint8_t fifoId, tu_fifo_tap_t* tap);
+#endif
+#if CFG_TUD_AUDIO_EPSIZE_IN && CFG_TUD_AUDIO_TX_FIFO_SIZE
+bool     tud_audio_n_tx_tap_attach    (uint8_t itf, uint8_t fifoId, tu_fifo_tap_t* tap);
+#endif
+#endif
+
 #if CFG_TUD_AUDIO_INT_CTR_EPSIZE_IN > 0
 uint16_t    tud_audio_int_ctr_n_available   (uint8_t itf);
 uint16_t    tud_audio_int_ctr_n_read        (uint8_t itf, void* buffer, uint16_t bufsize);
@@ -215,7 +240,7 @@ uint16_t    tud_audio_int_ctr_n_write       (uint8_t itf, uint8_t const* buffer,
 static inline bool         tud_audio_mounted    (void);
 
 #if CFG_TUD_AUDIO_EPSIZE_OUT && CFG_TUD_AUDIO_RX_FIFO_SIZE
-static inline uint16_t     tud_audio_available  (void);
+static inline uint32_t     tud_audio_available  (void);
 static inline uint16_t     tud_audio_read       (void* buffer, uint16_t bufsize);
 static inline void         tud_audio_read_flush (void);
 #endif
@@ -327,7 +352,7 @@ static inline uint16_t tud_audio_write_flush (void)    // Short version if only
 
 #if CFG_TUD_AUDIO_EPSIZE_OUT && CFG_TUD_AUDIO_RX_FIFO_SIZE
 #if CFG_TUD_AUDIO_RX_FIFO_COUNT > 1
-static inline uint16_t tud_audio_available(uint8_t channelId)
+static inline uint32_t tud_audio_available(uint8_t channelId)
 {
   return tud_audio_n_available(0, channelId);
 }
@@ -342,7 +367,7 @@ static inline void tud_audio_read_flush(uint8_t channelId)
   tud_audio_n_read_flush(0, channelId);
 }
 #else
-static inline uint16_t tud_audio_available(void)
+static inline uint32_t tud_audio_available(void)
 {
   return tud_audio_n_available(0);
 }
@@ -40,6 +40,7 @@
 //--------------------------------------------------------------------+
 typedef struct
 {
+  uint8_t rhport;
   uint8_t itf_num;
   uint8_t ep_ev;
   uint8_t ep_acl_in;
@@ -61,9 +62,9 @@ CFG_TUSB_MEM_SECTION btd_interface_t _btd_itf;
 static bool bt_tx_data(uint8_t ep, void *data, uint16_t len)
 {
   // skip if previous transfer not complete
-  TU_VERIFY(!usbd_edpt_busy(TUD_OPT_RHPORT, ep));
+  TU_VERIFY(!usbd_edpt_busy(_btd_itf.rhport, ep));
 
-  TU_ASSERT(usbd_edpt_xfer(TUD_OPT_RHPORT, ep, data, len));
+  TU_ASSERT(usbd_edpt_xfer(_btd_itf.rhport, ep, data, len));
 
   return true;
 }
@@ -116,6 +117,7 @@ uint16_t btd_open(uint8_t rhport, tusb_desc_interface_t const *itf_desc, uint16_
   // Distinguish interface by number of endpoints, as both interface have same class, subclass and protocol
   if (itf_desc->bNumEndpoints == 3 && max_len >= hci_itf_size)
   {
+    _btd_itf.rhport  = rhport;
     _btd_itf.itf_num = itf_desc->bInterfaceNumber;
 
     desc_ep = (tusb_desc_endpoint_t const *) tu_desc_next(itf_desc);
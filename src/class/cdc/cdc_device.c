@@ -41,6 +41,7 @@ enum
 
 typedef struct
 {
+  uint8_t rhport;
   uint8_t itf_num;
   uint8_t ep_notif;
   uint8_t ep_in;
@@ -65,9 +66,11 @@ typedef struct
   osal_mutex_def_t tx_ff_mutex;
 #endif
 
+#if !CFG_TUD_EDPT_XFER_FIFO
   // Endpoint Transfer buffer
   CFG_TUSB_MEM_ALIGN uint8_t epout_buf[CFG_TUD_CDC_EP_BUFSIZE];
   CFG_TUSB_MEM_ALIGN uint8_t epin_buf[CFG_TUD_CDC_EP_BUFSIZE];
+#endif
 
 }cdcd_interface_t;
 
@@ -80,14 +83,14 @@ CFG_TUSB_MEM_SECTION static cdcd_interface_t _cdcd_itf[CFG_TUD_CDC];
 
 static void _prep_out_transaction (cdcd_interface_t* p_cdc)
 {
-  uint8_t const rhport = TUD_OPT_RHPORT;
-  uint16_t available = tu_fifo_remaining(&p_cdc->rx_ff);
+  uint8_t const rhport = p_cdc->rhport;
+  uint32_t available = tu_fifo_remaining(&p_cdc->rx_ff);
 
   // Prepare for incoming data but only allow what we can store in the ring buffer.
   // TODO Actually we can still carry out the transfer, keeping count of received bytes
   // and slowly move it to the FIFO when read().
   // This pre-check reduces endpoint claiming
-  TU_VERIFY(available >= sizeof(p_cdc->epout_buf), );
+  TU_VERIFY(available >= CFG_TUD_CDC_EP_BUFSIZE, );
 
   // claim endpoint
   TU_VERIFY(usbd_edpt_claim(rhport, p_cdc->ep_out), );
@@ -95,9 +98,14 @@ static void _prep_out_transaction (cdcd_interface_t* p_cdc)
   // fifo can be changed before endpoint is claimed
   available = tu_fifo_remaining(&p_cdc->rx_ff);
 
-  if ( available >= sizeof(p_cdc->epout_buf) )
+  if ( available >= CFG_TUD_CDC_EP_BUFSIZE )
   {
-    usbd_edpt_xfer(rhport, p_cdc->ep_out, p_cdc->epout_buf, sizeof(p_cdc->epout_buf));
+#if CFG_TUD_EDPT_XFER_FIFO
+    // received data is written to rx fifo directly
+    usbd_edpt_xfer_fifo(rhport, p_cdc->ep_out, &p_cdc->rx_ff, CFG_TUD_CDC_EP_BUFSIZE);
+#else
+    usbd_edpt_xfer(rhport, p_cdc->ep_out, p_cdc->epout_buf, CFG_TUD_CDC_EP_BUFSIZE);
+#endif
   }else
   {
     // Release endpoint since we don't make any transfer
@@ -111,7 +119,7 @@ static void _prep_out_transaction (cdcd_interface_t* p_cdc)
 bool tud_cdc_n_connected(uint8_t itf)
 {
   // DTR (bit 0) active  is considered as connected
-  return tud_ready() && tu_bit_test(_cdcd_itf[itf].line_state, 0);
+  return tud_ready_rhport(_cdcd_itf[itf].rhport) && tu_bit_test(_cdcd_itf[itf].line_state, 0);
 }
 
 uint8_t tud_cdc_n_get_line_state (uint8_t itf)
@@ -141,7 +149,7 @@ uint32_t tud_cdc_n_available(uint8_t itf)
 uint32_t tud_cdc_n_read(uint8_t itf, void* buffer, uint32_t bufsize)
 {
   cdcd_interface_t* p_cdc = &_cdcd_itf[itf];
-  uint32_t num_read = tu_fifo_read_n(&p_cdc->rx_ff, buffer, bufsize);
+  uint32_t num_read = tu_fifo_read_n(&p_cdc->rx_ff, buffer, (tu_fifo_idx_t) tu_min32(bufsize, TU_FIFO_IDX_MAX));
   _prep_out_transaction(p_cdc);
   return num_read;
 }
@@ -164,7 +172,7 @@ void tud_cdc_n_read_flush (uint8_t itf)
 uint32_t tud_cdc_n_write(uint8_t itf, void const* buffer, uint32_t bufsize)
 {
   cdcd_interface_t* p_cdc = &_cdcd_itf[itf];
-  uint16_t ret = tu_fifo_write_n(&p_cdc->tx_ff, buffer, bufsize);
+  uint32_t ret = tu_fifo_write_n(&p_cdc->tx_ff, buffer, (tu_fifo_idx_t) tu_min32(bufsize, TU_FIFO_IDX_MAX));
 
   // flush if queue more than packet size
   if ( tu_fifo_count(&p_cdc->tx_ff) >= BULK_PACKET_SIZE )
@@ -179,23 +187,32 @@ uint32_t tud_cdc_n_write_flush (uint8_t itf)
 {
   cdcd_interface_t* p_cdc = &_cdcd_itf[itf];
 
+  uint8_t const rhport = p_cdc->rhport;
+
   // Skip if usb is not ready yet
-  TU_VERIFY( tud_ready(), 0 );
+  TU_VERIFY( tud_ready_rhport(rhport), 0 );
 
   // No data to send
   if ( !tu_fifo_count(&p_cdc->tx_ff) ) return 0;
 
-  uint8_t const rhport = TUD_OPT_RHPORT;
-
   // Claim the endpoint
   TU_VERIFY( usbd_edpt_claim(rhport, p_cdc->ep_in), 0 );
 
+#if CFG_TUD_EDPT_XFER_FIFO
+  // Data is read from tx fifo directly while it is sent
+  uint16_t const count = (uint16_t) tu_min32(tu_fifo_count(&p_cdc->tx_ff), CFG_TUD_CDC_EP_BUFSIZE);
+#else
   // Pull data from FIFO
   uint16_t const count = tu_fifo_read_n(&p_cdc->tx_ff, p_cdc->epin_buf, sizeof(p_cdc->epin_buf));
+#endif
 
   if ( count )
   {
+#if CFG_TUD_EDPT_XFER_FIFO
+    TU_ASSERT( usbd_edpt_xfer_fifo(rhport, p_cdc->ep_in, &p_cdc->tx_ff, count), 0 );
+#else
     TU_ASSERT( usbd_edpt_xfer(rhport, p_cdc->ep_in, p_cdc->epin_buf, count), 0 );
+#endif
     return count;
   }else
   {
@@ -216,6 +233,37 @@ bool tud_cdc_n_write_clear (uint8_t itf)
   return tu_fifo_clear(&_cdcd_itf[itf].tx_ff);
 }
 
+#if CFG_TUSB_FIFO_STATS
+//--------------------------------------------------------------------+
+// FIFO STATISTICS API
+//--------------------------------------------------------------------+
+void tud_cdc_n_fifo_stats(uint8_t itf, tu_fifo_stats_t* rx_stats, tu_fifo_stats_t* tx_stats)
+{
+  cdcd_interface_t* p_cdc = &_cdcd_itf[itf];
+  if ( rx_stats ) tu_fifo_get_stats(&p_cdc->rx_ff, rx_stats);
+  if ( tx_stats ) tu_fifo_get_stats(&p_cdc->tx_ff, tx_stats);
+}
+
+void tud_cdc_n_fifo_stats_reset(uint8_t itf)
+{
+  cdcd_interface_t* p_cdc = &_cdcd_itf[itf];
+  tu_fifo_reset_stats(&p_cdc->rx_ff);
+  tu_fifo_reset_stats(&p_cdc->tx_ff);
+}
+#endif
+
+#if CFG_TUSB_FIFO_TAP
+//--------------------------------------------------------------------+
+// FIFO TAP API
+//--------------------------------------------------------------------+
+void tud_cdc_n_tap_attach(uint8_t itf, tu_fifo_tap_t* rx_tap, tu_fifo_tap_t* tx_tap)
+{
+  cdcd_interface_t* p_cdc = &_cdcd_itf[itf];
+  if ( rx_tap ) tu_fifo_tap_attach(rx_tap, &p_cdc->rx_ff);
+  if ( tx_tap ) tu_fifo_tap_attach(tx_tap, &p_cdc->tx_ff);
+}
+#endif
+
 //--------------------------------------------------------------------+
 // USBD Driver API
 //--------------------------------------------------------------------+
@@ -241,7 +289,9 @@ void cdcd_init(void)
     // Config TX fifo as overwritable at initialization and will be changed to non-overwritable
     // if terminal supports DTR bit. Without DTR we do not know if data is actually polled by terminal.
     // In this way, the most current data is prioritized.
-    tu_fifo_config(&p_cdc->tx_ff, p_cdc->tx_ff_buf, TU_ARRAY_SIZE(p_cdc->tx_ff_buf), 1, true);
+    // With CFG_TUD_EDPT_XFER_FIFO the DCD reads tx fifo while sending: it is never overwritable
+    // since overwriting moves the read index under the DCD.
+    tu_fifo_config(&p_cdc->tx_ff, p_cdc->tx_ff_buf, TU_ARRAY_SIZE(p_cdc->tx_ff_buf), 1, !CFG_TUD_EDPT_XFER_FIFO);
 
 #if CFG_FIFO_MUTEX
     tu_fifo_config_mutex(&p_cdc->rx_ff, osal_mutex_create(&p_cdc->rx_ff_mutex));
@@ -252,16 +302,19 @@ void cdcd_init(void)
 
 void cdcd_reset(uint8_t rhport)
 {
-  (void) rhport;
-
   for(uint8_t i=0; i<CFG_TUD_CDC; i++)
   {
     cdcd_interface_t* p_cdc = &_cdcd_itf[i];
 
+    // skip interface bound to the other device port
+    if ( p_cdc->ep_in && (p_cdc->rhport != rhport) ) continue;
+
     tu_memclr(p_cdc, ITF_MEM_RESET_SIZE);
     tu_fifo_clear(&p_cdc->rx_ff);
     tu_fifo_clear(&p_cdc->tx_ff);
+#if !CFG_TUD_EDPT_XFER_FIFO
     tu_fifo_set_overwritable(&p_cdc->tx_ff, true);
+#endif
   }
 }
 
@@ -287,6 +340,7 @@ uint16_t cdcd_open(uint8_t rhport, tusb_desc_interface_t const * itf_desc, uint1
   TU_ASSERT(p_cdc, 0);
 
   //------------- Control Interface -------------//
+  p_cdc->rhport  = rhport;
   p_cdc->itf_num = itf_desc->bInterfaceNumber;
 
   uint16_t drv_len = sizeof(tusb_desc_interface_t);
@@ -346,7 +400,7 @@ bool cdcd_control_xfer_cb(uint8_t rhport, uint8_t stage, tusb_control_request_t
   {
     if (itf >= TU_ARRAY_SIZE(_cdcd_itf)) return false;
 
-    if ( p_cdc->itf_num == request->wIndex ) break;
+    if ( (p_cdc->rhport == rhport) && (p_cdc->itf_num == request->wIndex) ) break;
   }
 
   switch ( request->bRequest )
@@ -388,8 +442,10 @@ bool cdcd_control_xfer_cb(uint8_t rhport, uint8_t stage, tusb_control_request_t
 
         p_cdc->line_state = (uint8_t) request->wValue;
         
+#if !CFG_TUD_EDPT_XFER_FIFO
         // Disable fifo overwriting if DTR bit is set
         tu_fifo_set_overwritable(&p_cdc->tx_ff, !dtr);
+#endif
 
         TU_LOG2("  Set Control Line State: DTR = %d, RTS = %d\r\n", dtr, rts);
 
@@ -426,18 +482,34 @@ bool cdcd_xfer_cb(uint8_t rhport, uint8_t ep_addr, xfer_result_t result, uint32_
   for (itf = 0; itf < CFG_TUD_CDC; itf++)
   {
     p_cdc = &_cdcd_itf[itf];
-    if ( ( ep_addr == p_cdc->ep_out ) || ( ep_addr == p_cdc->ep_in ) ) break;
+    if ( (p_cdc->rhport == rhport) && ( ( ep_addr == p_cdc->ep_out ) || ( ep_addr == p_cdc->ep_in ) ) ) break;
   }
   TU_ASSERT(itf < CFG_TUD_CDC);
 
   // Received new data
   if ( ep_addr == p_cdc->ep_out )
   {
+#if CFG_TUD_EDPT_XFER_FIFO
+    // data is already in rx fifo, received bytes are the last ones
+    tu_fifo_idx_t const count = tu_fifo_count(&p_cdc->rx_ff);
+    tu_fifo_idx_t const first = (count > xferred_bytes) ? (tu_fifo_idx_t) (count - xferred_bytes) : 0;
+#else
     tu_fifo_write_n(&p_cdc->rx_ff, &p_cdc->epout_buf, xferred_bytes);
+#endif
     
     // Check for wanted char and invoke callback if needed
     if ( tud_cdc_rx_wanted_cb && (((signed char) p_cdc->wanted_char) != -1) )
     {
+#if CFG_TUD_EDPT_XFER_FIFO
+      for ( tu_fifo_idx_t i = first; i < count; i++ )
+      {
+        char ch;
+        if ( tu_fifo_peek_at(&p_cdc->rx_ff, i, &ch) && (p_cdc->wanted_char == ch) )
+        {
+          tud_cdc_rx_wanted_cb(itf, p_cdc->wanted_char);
+        }
+      }
+#else
       for ( uint32_t i = 0; i < xferred_bytes; i++ )
       {
         if ( (p_cdc->wanted_char == p_cdc->epout_buf[i]) && !tu_fifo_empty(&p_cdc->rx_ff) )
@@ -445,6 +517,7 @@ bool cdcd_xfer_cb(uint8_t rhport, uint8_t ep_addr, xfer_result_t result, uint32_
           tud_cdc_rx_wanted_cb(itf, p_cdc->wanted_char);
         }
       }
+#endif
     }
     
     // invoke receive callback (if there is still data)
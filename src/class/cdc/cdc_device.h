@@ -28,6 +28,8 @@
 #define _TUSB_CDC_DEVICE_H_
 
 #include "common/tusb_common.h"
+#include "osal/osal.h"
+#include "common/tusb_fifo.h"
 #include "device/usbd.h"
 #include "cdc.h"
 
@@ -105,6 +107,19 @@ uint32_t tud_cdc_n_write_available (uint8_t itf);
 // Clear the transmit FIFO
 bool tud_cdc_n_write_clear (uint8_t itf);
 
+#if CFG_TUSB_FIFO_STATS
+// Get usage statistics of RX and TX FIFO, either pointer can be NULL
+void tud_cdc_n_fifo_stats       (uint8_t itf, tu_fifo_stats_t* rx_stats, tu_fifo_stats_t* tx_stats);
+
+// Reset usage statistics of RX and TX FIFO
+void tud_cdc_n_fifo_stats_reset (uint8_t itf);
+#endif
+
+#if CFG_TUSB_FIFO_TAP
+// Attach taps to mirror the received and/or transmitted stream, either pointer can be NULL
+void tud_cdc_n_tap_attach       (uint8_t itf, tu_fifo_tap_t* rx_tap, tu_fifo_tap_t* tx_tap);
+#endif
+
 //--------------------------------------------------------------------+
 // Application API (Single Port)
 //--------------------------------------------------------------------+
@@ -126,6 +141,15 @@ static inline uint32_t tud_cdc_write_flush     (void);
 static inline uint32_t tud_cdc_write_available (void);
 static inline bool     tud_cdc_write_clear     (void);
 
+#if CFG_TUSB_FIFO_STATS
+static inline void     tud_cdc_fifo_stats       (tu_fifo_stats_t* rx_stats, tu_fifo_stats_t* tx_stats);
+static inline void     tud_cdc_fifo_stats_reset (void);
+#endif
+
+#if CFG_TUSB_FIFO_TAP
+static inline void     tud_cdc_tap_attach       (tu_fifo_tap_t* rx_tap, tu_fifo_tap_t* tx_tap);
+#endif
+
 //--------------------------------------------------------------------+
 // Application Callback API (weak is optional)
 //--------------------------------------------------------------------+
@@ -242,6 +266,25 @@ static inline bool tud_cdc_write_clear(void)
   return tud_cdc_n_write_clear(0);
 }
 
+#if CFG_TUSB_FIFO_STATS
+static inline void tud_cdc_fifo_stats(tu_fifo_stats_t* rx_stats, tu_fifo_stats_t* tx_stats)
+{
+  tud_cdc_n_fifo_stats(0, rx_stats, tx_stats);
+}
+
+static inline void tud_cdc_fifo_stats_reset(void)
+{
+  tud_cdc_n_fifo_stats_reset(0);
+}
+#endif
+
+#if CFG_TUSB_FIFO_TAP
+static inline void tud_cdc_tap_attach(tu_fifo_tap_t* rx_tap, tu_fifo_tap_t* tx_tap)
+{
+  tud_cdc_n_tap_attach(0, rx_tap, tx_tap);
+}
+#endif
+
 /** @} */
 /** @} */
 
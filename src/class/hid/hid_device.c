@@ -40,6 +40,7 @@
 //--------------------------------------------------------------------+
 typedef struct
 {
+  uint8_t rhport;
   uint8_t itf_num;
   uint8_t ep_in;
   uint8_t ep_out;        // optional Out endpoint
@@ -57,11 +58,11 @@ typedef struct
 CFG_TUSB_MEM_SECTION static hidd_interface_t _hidd_itf[CFG_TUD_HID];
 
 /*------------- Helpers -------------*/
-static inline uint8_t get_index_by_itfnum(uint8_t itf_num)
+static inline uint8_t get_index_by_itfnum(uint8_t rhport, uint8_t itf_num)
 {
 	for (uint8_t i=0; i < CFG_TUD_HID; i++ )
 	{
-		if ( itf_num == _hidd_itf[i].itf_num ) return i;
+		if ( (rhport == _hidd_itf[i].rhport) && (itf_num == _hidd_itf[i].itf_num) ) return i;
 	}
 
 	return 0xFF;
@@ -72,14 +73,15 @@ static inline uint8_t get_index_by_itfnum(uint8_t itf_num)
 //--------------------------------------------------------------------+
 bool tud_hid_n_ready(uint8_t itf)
 {
+  uint8_t const rhport = _hidd_itf[itf].rhport;
   uint8_t const ep_in = _hidd_itf[itf].ep_in;
-  return tud_ready() && (ep_in != 0) && !usbd_edpt_busy(TUD_OPT_RHPORT, ep_in);
+  return tud_ready_rhport(rhport) && (ep_in != 0) && !usbd_edpt_busy(rhport, ep_in);
 }
 
 bool tud_hid_n_report(uint8_t itf, uint8_t report_id, void const* report, uint8_t len)
 {
-  uint8_t const rhport = 0;
   hidd_interface_t * p_hid = &_hidd_itf[itf];
+  uint8_t const rhport = p_hid->rhport;
 
   // claim endpoint
   TU_VERIFY( usbd_edpt_claim(rhport, p_hid->ep_in) );
@@ -99,7 +101,7 @@ bool tud_hid_n_report(uint8_t itf, uint8_t report_id, void const* report, uint8_
     memcpy(p_hid->epin_buf, report, len);
   }
 
-  return usbd_edpt_xfer(TUD_OPT_RHPORT, p_hid->ep_in, p_hid->epin_buf, len);
+  return usbd_edpt_xfer(rhport, p_hid->ep_in, p_hid->epin_buf, len);
 }
 
 bool tud_hid_n_boot_mode(uint8_t itf)
@@ -162,13 +164,18 @@ bool tud_hid_n_gamepad_report(uint8_t itf, uint8_t report_id,
 //--------------------------------------------------------------------+
 void hidd_init(void)
 {
-  hidd_reset(TUD_OPT_RHPORT);
+  tu_memclr(_hidd_itf, sizeof(_hidd_itf));
 }
 
 void hidd_reset(uint8_t rhport)
 {
-  (void) rhport;
-  tu_memclr(_hidd_itf, sizeof(_hidd_itf));
+  for(uint8_t i=0; i<CFG_TUD_HID; i++)
+  {
+    // skip interface bound to the other device port
+    if ( _hidd_itf[i].ep_in && (_hidd_itf[i].rhport != rhport) ) continue;
+
+    tu_memclr(&_hidd_itf[i], sizeof(hidd_interface_t));
+  }
 }
 
 uint16_t hidd_open(uint8_t rhport, tusb_desc_interface_t const * desc_itf, uint16_t max_len)
@@ -206,6 +213,7 @@ uint16_t hidd_open(uint8_t rhport, tusb_desc_interface_t const * desc_itf, uint1
   if ( desc_itf->bInterfaceSubClass == HID_SUBCLASS_BOOT ) p_hid->boot_protocol = desc_itf->bInterfaceProtocol;
 
   p_hid->boot_mode = false; // default mode is REPORT
+  p_hid->rhport    = rhport;
   p_hid->itf_num   = desc_itf->bInterfaceNumber;
 
   // Use offsetof to avoid pointer to the odd/misaligned address
@@ -231,7 +239,7 @@ bool hidd_control_xfer_cb (uint8_t rhport, uint8_t stage, tusb_control_request_t
 {
   TU_VERIFY(request->bmRequestType_bit.recipient == TUSB_REQ_RCPT_INTERFACE);
 
-  uint8_t const hid_itf = get_index_by_itfnum((uint8_t) request->wIndex);
+  uint8_t const hid_itf = get_index_by_itfnum(rhport, (uint8_t) request->wIndex);
   TU_VERIFY(hid_itf < CFG_TUD_HID);
 
   hidd_interface_t* p_hid = &_hidd_itf[hid_itf];
@@ -361,7 +369,7 @@ bool hidd_xfer_cb(uint8_t rhport, uint8_t ep_addr, xfer_result_t result, uint32_
   for (itf = 0; itf < CFG_TUD_HID; itf++)
   {
     p_hid = &_hidd_itf[itf];
-    if ( (ep_addr == p_hid->ep_out) || (ep_addr == p_hid->ep_in) ) break;
+    if ( (p_hid->rhport == rhport) && ((ep_addr == p_hid->ep_out) || (ep_addr == p_hid->ep_in)) ) break;
   }
   TU_ASSERT(itf < CFG_TUD_HID);
 
@@ -39,6 +39,13 @@
 // MACRO CONSTANT TYPEDEF
 //--------------------------------------------------------------------+
 
+// FIFOs hold whole 4-byte event packets
+TU_VERIFY_STATIC( (CFG_TUD_MIDI_RX_BUFSIZE % 4) == 0 && (CFG_TUD_MIDI_TX_BUFSIZE % 4) == 0 &&
+                  (CFG_TUD_MIDI_EP_BUFSIZE % 4) == 0, "MIDI buffer sizes must be multiple of 4");
+
+TU_FIFO_TYPED_DECLARE(midid_rx_ff, uint32_t, CFG_TUD_MIDI_RX_BUFSIZE/4);
+TU_FIFO_TYPED_DECLARE(midid_tx_ff, uint32_t, CFG_TUD_MIDI_TX_BUFSIZE/4);
+
 typedef struct
 {
   uint8_t buffer[4];
@@ -48,6 +55,7 @@ typedef struct
 
 typedef struct
 {
+  uint8_t rhport;
   uint8_t itf_num;
   uint8_t ep_in;
   uint8_t ep_out;
@@ -59,20 +67,15 @@ typedef struct
   midid_stream_t stream_read;
 
   /*------------- From this point, data is not cleared by bus reset -------------*/
-  // FIFO
-  tu_fifo_t rx_ff;
-  tu_fifo_t tx_ff;
-  uint8_t rx_ff_buf[CFG_TUD_MIDI_RX_BUFSIZE];
-  uint8_t tx_ff_buf[CFG_TUD_MIDI_TX_BUFSIZE];
-
-  #if CFG_FIFO_MUTEX
-  osal_mutex_def_t rx_ff_mutex;
-  osal_mutex_def_t tx_ff_mutex;
-  #endif
+  // FIFO of event packets, single producer and single consumer each:
+  // rx is written by the usbd task and read by the application, tx is written by
+  // the application and read by whoever claimed ep_in.
+  midid_rx_ff_t rx_ff;
+  midid_tx_ff_t tx_ff;
 
   // Endpoint Transfer buffer
-  CFG_TUSB_MEM_ALIGN uint8_t epout_buf[CFG_TUD_MIDI_EP_BUFSIZE];
-  CFG_TUSB_MEM_ALIGN uint8_t epin_buf[CFG_TUD_MIDI_EP_BUFSIZE];
+  CFG_TUSB_MEM_ALIGN uint32_t epout_buf[CFG_TUD_MIDI_EP_BUFSIZE/4];
+  CFG_TUSB_MEM_ALIGN uint32_t epin_buf[CFG_TUD_MIDI_EP_BUFSIZE/4];
 
 } midid_interface_t;
 
@@ -91,8 +94,8 @@ bool tud_midi_n_mounted (uint8_t itf)
 
 static void _prep_out_transaction (midid_interface_t* p_midi)
 {
-  uint8_t const rhport = TUD_OPT_RHPORT;
-  uint16_t available = tu_fifo_remaining(&p_midi->rx_ff);
+  uint8_t const rhport = p_midi->rhport;
+  uint32_t available = 4u*midid_rx_ff_remaining(&p_midi->rx_ff);
 
   // Prepare for incoming data but only allow what we can store in the ring buffer.
   // TODO Actually we can still carry out the transfer, keeping count of received bytes
@@ -104,10 +107,10 @@ static void _prep_out_transaction (midid_interface_t* p_midi)
   TU_VERIFY(usbd_edpt_claim(rhport, p_midi->ep_out), );
 
   // fifo can be changed before endpoint is claimed
-  available = tu_fifo_remaining(&p_midi->rx_ff);
+  available = 4u*midid_rx_ff_remaining(&p_midi->rx_ff);
 
   if ( available >= sizeof(p_midi->epout_buf) )  {
-    usbd_edpt_xfer(rhport, p_midi->ep_out, p_midi->epout_buf, sizeof(p_midi->epout_buf));
+    usbd_edpt_xfer(rhport, p_midi->ep_out, (uint8_t*) p_midi->epout_buf, sizeof(p_midi->epout_buf));
   }else
   {
     // Release endpoint since we don't make any transfer
@@ -121,7 +124,7 @@ static void _prep_out_transaction (midid_interface_t* p_midi)
 uint32_t tud_midi_n_available(uint8_t itf, uint8_t cable_num)
 {
   (void) cable_num;
-  return tu_fifo_count(&_midid_itf[itf].rx_ff);
+  return 4u*midid_rx_ff_count(&_midid_itf[itf].rx_ff);
 }
 
 uint32_t tud_midi_n_stream_read(uint8_t itf, uint8_t cable_num, void* buffer, uint32_t bufsize)
@@ -197,9 +200,11 @@ uint32_t tud_midi_n_stream_read(uint8_t itf, uint8_t cable_num, void* buffer, ui
 bool tud_midi_n_packet_read (uint8_t itf, uint8_t packet[4])
 {
   midid_interface_t* p_midi = &_midid_itf[itf];
-  uint32_t num_read = tu_fifo_read_n(&p_midi->rx_ff, packet, 4);
+  uint32_t event;
+  bool const ret = midid_rx_ff_read(&p_midi->rx_ff, &event);
+  if ( ret ) memcpy(packet, &event, 4);
   _prep_out_transaction(p_midi);
-  return (num_read == 4);
+  return ret;
 }
 
 //--------------------------------------------------------------------+
@@ -209,18 +214,18 @@ bool tud_midi_n_packet_read (uint8_t itf, uint8_t packet[4])
 static uint32_t write_flush(midid_interface_t* midi)
 {
   // No data to send
-  if ( !tu_fifo_count(&midi->tx_ff) ) return 0;
+  if ( midid_tx_ff_empty(&midi->tx_ff) ) return 0;
 
-  uint8_t const rhport = TUD_OPT_RHPORT;
+  uint8_t const rhport = midi->rhport;
 
   // skip if previous transfer not complete
   TU_VERIFY( usbd_edpt_claim(rhport, midi->ep_in), 0 );
 
-  uint16_t count = tu_fifo_read_n(&midi->tx_ff, midi->epin_buf, CFG_TUD_MIDI_EP_BUFSIZE);
+  uint16_t count = 4u*midid_tx_ff_read_n(&midi->tx_ff, midi->epin_buf, CFG_TUD_MIDI_EP_BUFSIZE/4);
 
   if (count)
   {
-    TU_ASSERT( usbd_edpt_xfer(rhport, midi->ep_in, midi->epin_buf, count), 0 );
+    TU_ASSERT( usbd_edpt_xfer(rhport, midi->ep_in, (uint8_t*) midi->epin_buf, count), 0 );
     return count;
   }else
   {
@@ -327,13 +332,15 @@ uint32_t tud_midi_n_stream_write(uint8_t itf, uint8_t cable_num, uint8_t const*
       // zeroes unused bytes
       for(uint8_t idx = stream->total; idx < 4; idx++) stream->buffer[idx] = 0;
 
-      uint16_t const count = tu_fifo_write_n(&midi->tx_ff, stream->buffer, 4);
+      uint32_t event;
+      memcpy(&event, stream->buffer, 4);
+      bool const ok = midid_tx_ff_write(&midi->tx_ff, &event);
 
       // complete current event packet, reset stream
       stream->index = stream->total = 0;
 
-      // fifo overflow, here we assume FIFO is multiple of 4 and didn't check remaining before writing
-      if ( count != 4 ) break;
+      // fifo overflow
+      if ( !ok ) break;
 
       // updated written if succeeded
       total_written = i;
@@ -354,46 +361,55 @@ bool tud_midi_n_packet_write (uint8_t itf, uint8_t const packet[4])
     return 0;
   }
 
-  if (tu_fifo_remaining(&midi->tx_ff) < 4) return false;
+  uint32_t event;
+  memcpy(&event, packet, 4);
+  if ( !midid_tx_ff_write(&midi->tx_ff, &event) ) return false;
 
-  tu_fifo_write_n(&midi->tx_ff, packet, 4);
   write_flush(midi);
 
   return true;
 }
 
+#if CFG_TUSB_FIFO_STATS
+//--------------------------------------------------------------------+
+// FIFO Statistics API
+//--------------------------------------------------------------------+
+void tud_midi_n_fifo_stats (uint8_t itf, tu_fifo_stats_t* rx_stats, tu_fifo_stats_t* tx_stats)
+{
+  midid_interface_t* midi = &_midid_itf[itf];
+  if ( rx_stats ) midid_rx_ff_get_stats(&midi->rx_ff, rx_stats);
+  if ( tx_stats ) midid_tx_ff_get_stats(&midi->tx_ff, tx_stats);
+}
+
+void tud_midi_n_fifo_stats_reset (uint8_t itf)
+{
+  midid_interface_t* midi = &_midid_itf[itf];
+  midid_rx_ff_reset_stats(&midi->rx_ff);
+  midid_tx_ff_reset_stats(&midi->tx_ff);
+}
+#endif
+
 //--------------------------------------------------------------------+
 // USBD Driver API
 //--------------------------------------------------------------------+
 void midid_init(void)
 {
+  // also configures both fifos as not overwritable
   tu_memclr(_midid_itf, sizeof(_midid_itf));
-
-  for(uint8_t i=0; i<CFG_TUD_MIDI; i++)
-  {
-    midid_interface_t* midi = &_midid_itf[i];
-
-    // config fifo
-    tu_fifo_config(&midi->rx_ff, midi->rx_ff_buf, CFG_TUD_MIDI_RX_BUFSIZE, 1, false); // true, true
-    tu_fifo_config(&midi->tx_ff, midi->tx_ff_buf, CFG_TUD_MIDI_TX_BUFSIZE, 1, false); // OBVS.
-
-    #if CFG_FIFO_MUTEX
-    tu_fifo_config_mutex(&midi->rx_ff, osal_mutex_create(&midi->rx_ff_mutex));
-    tu_fifo_config_mutex(&midi->tx_ff, osal_mutex_create(&midi->tx_ff_mutex));
-    #endif
-  }
 }
 
 void midid_reset(uint8_t rhport)
 {
-  (void) rhport;
-
   for(uint8_t i=0; i<CFG_TUD_MIDI; i++)
   {
     midid_interface_t* midi = &_midid_itf[i];
+
+    // skip interface bound to the other device port
+    if ( (midi->ep_in || midi->ep_out) && (midi->rhport != rhport) ) continue;
+
     tu_memclr(midi, ITF_MEM_RESET_SIZE);
-    tu_fifo_clear(&midi->rx_ff);
-    tu_fifo_clear(&midi->tx_ff);
+    midid_rx_ff_clear(&midi->rx_ff);
+    midid_tx_ff_clear(&midi->tx_ff);
   }
 }
 
@@ -433,6 +449,7 @@ uint16_t midid_open(uint8_t rhport, tusb_desc_interface_t const * desc_itf, uint
     }
   }
 
+  p_midi->rhport  = rhport;
   p_midi->itf_num = desc_midi->bInterfaceNumber;
 
   // next descriptor
@@ -488,7 +505,6 @@ bool midid_control_xfer_cb(uint8_t rhport, uint8_t stage, tusb_control_request_t
 bool midid_xfer_cb(uint8_t rhport, uint8_t ep_addr, xfer_result_t result, uint32_t xferred_bytes)
 {
   (void) result;
-  (void) rhport;
 
   uint8_t itf;
   midid_interface_t* p_midi;
@@ -497,14 +513,15 @@ bool midid_xfer_cb(uint8_t rhport, uint8_t ep_addr, xfer_result_t result, uint32
   for (itf = 0; itf < CFG_TUD_MIDI; itf++)
   {
     p_midi = &_midid_itf[itf];
-    if ( ( ep_addr == p_midi->ep_out ) || ( ep_addr == p_midi->ep_in ) ) break;
+    if ( (p_midi->rhport == rhport) && ( ( ep_addr == p_midi->ep_out ) || ( ep_addr == p_midi->ep_in ) ) ) break;
   }
   TU_ASSERT(itf < CFG_TUD_MIDI);
 
   // receive new data
   if ( ep_addr == p_midi->ep_out )
   {
-    tu_fifo_write_n(&p_midi->rx_ff, p_midi->epout_buf, xferred_bytes);
+    // event packets are always 4 bytes, drop any incomplete trailing one
+    midid_rx_ff_write_n(&p_midi->rx_ff, p_midi->epout_buf, (tu_fifo_idx_t) (xferred_bytes / 4));
 
     // invoke receive callback if available
     if (tud_midi_rx_cb) tud_midi_rx_cb(itf);
@@ -520,7 +537,7 @@ bool midid_xfer_cb(uint8_t rhport, uint8_t ep_addr, xfer_result_t result, uint32
     {
       // If there is no data left, a ZLP should be sent if
       // xferred_bytes is multiple of EP size and not zero
-      if ( !tu_fifo_count(&p_midi->tx_ff) && xferred_bytes && (0 == (xferred_bytes % CFG_TUD_MIDI_EP_BUFSIZE)) )
+      if ( midid_tx_ff_empty(&p_midi->tx_ff) && xferred_bytes && (0 == (xferred_bytes % CFG_TUD_MIDI_EP_BUFSIZE)) )
       {
         if ( usbd_edpt_claim(rhport, p_midi->ep_in) )
         {
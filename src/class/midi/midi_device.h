@@ -28,6 +28,8 @@
 #define _TUSB_MIDI_DEVICE_H_
 
 #include "common/tusb_common.h"
+#include "osal/osal.h"
+#include "common/tusb_fifo.h"
 #include "device/usbd.h"
 
 #include "class/audio/audio.h"
@@ -46,6 +48,10 @@
   #define CFG_TUD_MIDI_EP_BUFSIZE     (TUD_OPT_HIGH_SPEED ? 512 : 64)
 #endif
 
+// CFG_TUD_MIDI_RX_BUFSIZE and CFG_TUD_MIDI_TX_BUFSIZE are in bytes and must be a power of two
+// (and at least 4). FIFOs are lock-free: each direction supports one reader and one writer
+// task, e.g application calls tud_midi_packet_write()/tud_midi_stream_write() from a single task.
+
 #ifdef __cplusplus
  extern "C" {
 #endif
@@ -78,6 +84,15 @@ bool     tud_midi_n_packet_read  (uint8_t itf, uint8_t packet[4]);
 // Write event packet            (4 bytes)
 bool     tud_midi_n_packet_write (uint8_t itf, uint8_t const packet[4]);
 
+#if CFG_TUSB_FIFO_STATS
+// Get usage statistics of RX and TX FIFO, either pointer can be NULL.
+// Counts are in 4-byte event packets
+void     tud_midi_n_fifo_stats       (uint8_t itf, tu_fifo_stats_t* rx_stats, tu_fifo_stats_t* tx_stats);
+
+// Reset usage statistics of RX and TX FIFO
+void     tud_midi_n_fifo_stats_reset (uint8_t itf);
+#endif
+
 //--------------------------------------------------------------------+
 // Application API (Single Interface)
 //--------------------------------------------------------------------+
@@ -90,6 +105,11 @@ static inline uint32_t tud_midi_stream_write (uint8_t cable_num, uint8_t const*
 static inline bool     tud_midi_packet_read  (uint8_t packet[4]);
 static inline bool     tud_midi_packet_write (uint8_t const packet[4]);
 
+#if CFG_TUSB_FIFO_STATS
+static inline void     tud_midi_fifo_stats       (tu_fifo_stats_t* rx_stats, tu_fifo_stats_t* tx_stats);
+static inline void     tud_midi_fifo_stats_reset (void);
+#endif
+
 //------------- Deprecated API name  -------------//
 // TODO remove after 0.10.0 release
 
@@ -157,6 +177,18 @@ static inline bool tud_midi_packet_write (uint8_t const packet[4])
   return tud_midi_n_packet_write(0, packet);
 }
 
+#if CFG_TUSB_FIFO_STATS
+static inline void tud_midi_fifo_stats (tu_fifo_stats_t* rx_stats, tu_fifo_stats_t* tx_stats)
+{
+  tud_midi_n_fifo_stats(0, rx_stats, tx_stats);
+}
+
+static inline void tud_midi_fifo_stats_reset (void)
+{
+  tud_midi_n_fifo_stats_reset(0);
+}
+#endif
+
 //--------------------------------------------------------------------+
 // Internal Class Driver API
 //--------------------------------------------------------------------+
@@ -75,6 +75,7 @@
 #include "tusb_error.h" // TODO remove
 #include "tusb_timeout.h"
 #include "tusb_types.h"
+#include "tusb_trace.h"
 
 //--------------------------------------------------------------------+
 // Inline Functions
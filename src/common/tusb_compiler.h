@@ -81,6 +81,12 @@
   #define TU_BSWAP16(u16) (__builtin_bswap16(u16))
   #define TU_BSWAP32(u32) (__builtin_bswap32(u32))
 
+  // Load with acquire / store with release semantics, also ordered between cores
+  #define TU_ATOMIC_LOAD_ACQUIRE(ptr)        __atomic_load_n(ptr, __ATOMIC_ACQUIRE)
+  #define TU_ATOMIC_STORE_RELEASE(ptr, val)  __atomic_store_n(ptr, val, __ATOMIC_RELEASE)
+  #define TU_ATOMIC_FENCE_ACQUIRE()          __atomic_thread_fence(__ATOMIC_ACQUIRE)
+  #define TU_ATOMIC_FENCE_RELEASE()          __atomic_thread_fence(__ATOMIC_RELEASE)
+
 #elif defined(__TI_COMPILER_VERSION__)
   #define TU_ATTR_ALIGNED(Bytes)        __attribute__ ((aligned(Bytes)))
   #define TU_ATTR_SECTION(sec_name)     __attribute__ ((section(#sec_name)))
@@ -125,6 +131,15 @@
   #error "Compiler attribute porting is required"
 #endif
 
+// Fallback for compilers without memory ordering support: plain volatile access,
+// only sufficient for single core targets
+#ifndef TU_ATOMIC_LOAD_ACQUIRE
+  #define TU_ATOMIC_LOAD_ACQUIRE(ptr)        (*(ptr))
+  #define TU_ATOMIC_STORE_RELEASE(ptr, val)  (*(ptr) = (val))
+  #define TU_ATOMIC_FENCE_ACQUIRE()
+  #define TU_ATOMIC_FENCE_RELEASE()
+#endif
+
 #if (TU_BYTE_ORDER == TU_LITTLE_ENDIAN)
 
   #define tu_htons(u16)  (TU_BSWAP16(u16))
@@ -62,9 +62,9 @@ static void tu_fifo_unlock(tu_fifo_t *f)
 
 #endif
 
-bool tu_fifo_config(tu_fifo_t *f, void* buffer, uint16_t depth, uint16_t item_size, bool overwritable)
+bool tu_fifo_config(tu_fifo_t *f, void* buffer, tu_fifo_idx_t depth, uint16_t item_size, bool overwritable)
 {
-  if (depth > 0x8000) return false;               // Maximum depth is 2^15 items
+  if (depth > TU_FIFO_DEPTH_MAX) return false;    // Maximum depth is 2^15 items (2^31 with CFG_TUSB_FIFO_WIDE_INDEX)
 
   tu_fifo_lock(f);
 
@@ -73,11 +73,19 @@ bool tu_fifo_config(tu_fifo_t *f, void* buffer, uint16_t depth, uint16_t item_si
   f->item_size = item_size;
   f->overwritable = overwritable;
 
-  f->max_pointer_idx = 2*depth - 1;               // Limit index space to 2*depth - this allows for a fast "modulo" calculation but limits the maximum depth to 2^16/2 = 2^15 and buffer overflows are detectable only if overflow happens once (important for unsupervised DMA applications)
-  f->non_used_index_space = UINT16_MAX - f->max_pointer_idx;
+  f->max_pointer_idx = 2*depth - 1;               // Limit index space to 2*depth - this allows for a fast "modulo" calculation but limits the maximum depth to half of the index space (2^15 or 2^31) and buffer overflows are detectable only if overflow happens once (important for unsupervised DMA applications)
+  f->non_used_index_space = TU_FIFO_IDX_MAX - f->max_pointer_idx;
 
   f->rd_idx = f->wr_idx = 0;
 
+#if CFG_TUSB_FIFO_TAP
+  f->wr_claim = 0;
+#endif
+
+#if CFG_TUSB_FIFO_STATS
+  memset(&f->stats, 0, sizeof(f->stats));
+#endif
+
   tu_fifo_unlock(f);
 
   return true;
@@ -85,20 +93,20 @@ bool tu_fifo_config(tu_fifo_t *f, void* buffer, uint16_t depth, uint16_t item_si
 
 // Static functions are intended to work on local variables
 
-static inline uint16_t _ff_mod(uint16_t idx, uint16_t depth)
+static inline tu_fifo_idx_t _ff_mod(tu_fifo_idx_t idx, tu_fifo_idx_t depth)
 {
   while ( idx >= depth) idx -= depth;
   return idx;
 }
 
 // send one item to FIFO WITHOUT updating write pointer
-static inline void _ff_push(tu_fifo_t* f, void const * data, uint16_t wRel)
+static inline void _ff_push(tu_fifo_t* f, void const * data, tu_fifo_idx_t wRel)
 {
   memcpy(f->buffer + (wRel * f->item_size), data, f->item_size);
 }
 
 // send n items to FIFO WITHOUT updating write pointer
-static void _ff_push_n(tu_fifo_t* f, void const * data, uint16_t n, uint16_t wRel)
+static void _ff_push_n(tu_fifo_t* f, void const * data, tu_fifo_idx_t n, tu_fifo_idx_t wRel)
 {
   if(wRel + n <= f->depth)  // Linear mode only
   {
@@ -106,7 +114,7 @@ static void _ff_push_n(tu_fifo_t* f, void const * data, uint16_t n, uint16_t wRe
   }
   else      // Wrap around
   {
-    uint16_t nLin = f->depth - wRel;
+    tu_fifo_idx_t nLin = f->depth - wRel;
 
     // Write data to linear part of buffer
     memcpy(f->buffer + (wRel * f->item_size), data, nLin*f->item_size);
@@ -117,13 +125,13 @@ static void _ff_push_n(tu_fifo_t* f, void const * data, uint16_t n, uint16_t wRe
 }
 
 // get one item from FIFO WITHOUT updating read pointer
-static inline void _ff_pull(tu_fifo_t* f, void * p_buffer, uint16_t rRel)
+static inline void _ff_pull(tu_fifo_t* f, void * p_buffer, tu_fifo_idx_t rRel)
 {
   memcpy(p_buffer, f->buffer + (rRel * f->item_size), f->item_size);
 }
 
 // get n items from FIFO WITHOUT updating read pointer
-static void _ff_pull_n(tu_fifo_t* f, void * p_buffer, uint16_t n, uint16_t rRel)
+static void _ff_pull_n(tu_fifo_t* f, void * p_buffer, tu_fifo_idx_t n, tu_fifo_idx_t rRel)
 {
   if(rRel + n <= f->depth)       // Linear mode only
   {
@@ -131,7 +139,7 @@ static void _ff_pull_n(tu_fifo_t* f, void * p_buffer, uint16_t n, uint16_t rRel)
   }
   else      // Wrap around
   {
-    uint16_t nLin = f->depth - rRel;
+    tu_fifo_idx_t nLin = f->depth - rRel;
 
     // Read data from linear part of buffer
     memcpy(p_buffer, f->buffer + (rRel * f->item_size), nLin*f->item_size);
@@ -141,14 +149,246 @@ static void _ff_pull_n(tu_fifo_t* f, void * p_buffer, uint16_t n, uint16_t rRel)
   }
 }
 
+// Partially transferred 32-bit word of a fixed address register
+typedef struct
+{
+  uint32_t word;
+  uint8_t  cnt;   // number of bytes left in word (register to memory) or filled (memory to register)
+} _ff_word_t;
+
+// stream len bytes from a fixed address 32-bit register into linear memory, dst = NULL discards them.
+// Bytes of a word not fully consumed are kept in pend for the next call.
+static void _ff_reg_to_mem(uint8_t* dst, volatile uint32_t const* reg, uint32_t len, _ff_word_t* pend)
+{
+  // Use up bytes of previous word first
+  while ( len && pend->cnt )
+  {
+    if (dst) *dst++ = ((uint8_t const*) &pend->word)[4 - pend->cnt];
+    pend->cnt--;
+    len--;
+  }
+
+  // Full words
+  for(uint32_t nwords = len >> 2; nwords; nwords--)
+  {
+    uint32_t const tmp32 = *reg;
+    if (dst)
+    {
+      memcpy(dst, &tmp32, 4);
+      dst += 4;
+    }
+  }
+
+  // Remaining bytes, keep the rest of the word
+  len &= 3;
+  if (len)
+  {
+    pend->word = *reg;
+    pend->cnt  = (uint8_t) (4 - len);
+    if (dst) memcpy(dst, &pend->word, len);
+  }
+}
+
+// stream len bytes from linear memory into a fixed address 32-bit register.
+// Bytes not making up a complete word are kept in pend for the next call.
+static void _ff_mem_to_reg(volatile uint32_t* reg, uint8_t const* src, uint32_t len, _ff_word_t* pend)
+{
+  // Complete previous word first
+  if ( pend->cnt )
+  {
+    while ( len && (pend->cnt < 4) )
+    {
+      ((uint8_t*) &pend->word)[pend->cnt++] = *src++;
+      len--;
+    }
+
+    if ( pend->cnt < 4 ) return;
+
+    *reg = pend->word;
+    pend->cnt = 0;
+  }
+
+  // Full words
+  for(uint32_t nwords = len >> 2; nwords; nwords--)
+  {
+    uint32_t tmp32;
+    memcpy(&tmp32, src, 4);
+    *reg = tmp32;
+    src += 4;
+  }
+
+  // Remaining bytes
+  len &= 3;
+  if (len)
+  {
+    pend->word = 0;
+    memcpy(&pend->word, src, len);
+    pend->cnt = (uint8_t) len;
+  }
+}
+
+// send n items from a fixed address register to FIFO WITHOUT updating write pointer, skip leading bytes
+static void _ff_push_const_addr(tu_fifo_t* f, volatile uint32_t const* reg, tu_fifo_idx_t n, tu_fifo_idx_t wRel, uint32_t skip_bytes)
+{
+  _ff_word_t pend = { .word = 0, .cnt = 0 };
+  tu_fifo_idx_t const nLin = tu_min32(n, f->depth - wRel);
+
+  _ff_reg_to_mem(NULL, reg, skip_bytes, &pend);
+  _ff_reg_to_mem(f->buffer + (wRel * f->item_size), reg, nLin*f->item_size, &pend);
+  _ff_reg_to_mem(f->buffer, reg, (n - nLin)*f->item_size, &pend);
+}
+
+// get n items from FIFO to a fixed address register WITHOUT updating read pointer
+static void _ff_pull_const_addr(tu_fifo_t* f, volatile uint32_t* reg, tu_fifo_idx_t n, tu_fifo_idx_t rRel)
+{
+  _ff_word_t pend = { .word = 0, .cnt = 0 };
+  tu_fifo_idx_t const nLin = tu_min32(n, f->depth - rRel);
+
+  _ff_mem_to_reg(reg, f->buffer + (rRel * f->item_size), nLin*f->item_size, &pend);
+  _ff_mem_to_reg(reg, f->buffer, (n - nLin)*f->item_size, &pend);
+
+  // Last incomplete word, padded with zeros
+  if ( pend.cnt ) *reg = pend.word;
+}
+
+// Copy n samples of size bytes, source and destination advance by their own stride. Extra pad
+// bytes after each destination sample are zeroed. Sample sizes of common PCM formats are copied
+// with word accesses, memcpy() with constant size takes care of alignment.
+static void _ff_copy_strided(uint8_t* dst, uint16_t dst_stride, uint8_t const* src, uint16_t src_stride,
+                             uint8_t size, uint8_t pad, tu_fifo_idx_t n)
+{
+  switch (size)
+  {
+    case 1:
+      for(; n; n--, dst += dst_stride, src += src_stride)
+      {
+        *dst = *src;
+        if (pad) memset(dst + 1, 0, pad);
+      }
+    break;
+
+    case 2:
+      for(; n; n--, dst += dst_stride, src += src_stride)
+      {
+        uint16_t tmp16;
+        memcpy(&tmp16, src, 2);
+        memcpy(dst, &tmp16, 2);
+        if (pad) memset(dst + 2, 0, pad);
+      }
+    break;
+
+    case 3:
+      for(; n; n--, dst += dst_stride, src += src_stride)
+      {
+        uint16_t tmp16;
+        memcpy(&tmp16, src, 2);
+        memcpy(dst, &tmp16, 2);
+        dst[2] = src[2];
+        if (pad) memset(dst + 3, 0, pad);
+      }
+    break;
+
+    case 4:
+      for(; n; n--, dst += dst_stride, src += src_stride)
+      {
+        uint32_t tmp32;
+        memcpy(&tmp32, src, 4);
+        memcpy(dst, &tmp32, 4);
+        if (pad) memset(dst + 4, 0, pad);
+      }
+    break;
+
+    default:
+      for(; n; n--, dst += dst_stride, src += src_stride)
+      {
+        memcpy(dst, src, size);
+        if (pad) memset(dst + size, 0, pad);
+      }
+    break;
+  }
+}
+
+// get n samples (ff_size bytes each) from FIFO into every dst_stride bytes of a linear buffer
+// WITHOUT updating read pointer, only the first size bytes of each sample are copied
+static void _ff_pull_strided(tu_fifo_t* f, uint8_t* dst, uint16_t dst_stride, tu_fifo_idx_t n, tu_fifo_idx_t rRel,
+                             uint8_t ff_size, uint8_t size)
+{
+  uint32_t const total = (uint32_t) f->depth * f->item_size;
+  uint32_t offset      = (uint32_t) rRel * f->item_size;
+  tu_fifo_idx_t const nLin = (tu_fifo_idx_t) tu_min32(n, (total - offset) / ff_size);
+
+  _ff_copy_strided(dst, dst_stride, f->buffer + offset, ff_size, size, 0, nLin);
+
+  n -= nLin;
+  if (!n) return;
+
+  dst    += nLin * dst_stride;
+  offset += nLin * ff_size;
+
+  // Sample split by the wrap around
+  uint8_t const head = (uint8_t) (total - offset);
+  uint8_t const* src = f->buffer;
+
+  if (head)
+  {
+    for(uint8_t i = 0; i < size; i++) dst[i] = (i < head) ? f->buffer[offset + i] : f->buffer[i - head];
+
+    dst += dst_stride;
+    src += ff_size - head;
+    n--;
+  }
+
+  _ff_copy_strided(dst, dst_stride, src, ff_size, size, 0, n);
+}
+
+// send n samples from every src_stride bytes of a linear buffer to FIFO WITHOUT updating write
+// pointer, each sample is zero padded from size to ff_size bytes
+static void _ff_push_strided(tu_fifo_t* f, uint8_t const* src, uint16_t src_stride, tu_fifo_idx_t n, tu_fifo_idx_t wRel,
+                             uint8_t ff_size, uint8_t size)
+{
+  uint32_t const total = (uint32_t) f->depth * f->item_size;
+  uint32_t offset      = (uint32_t) wRel * f->item_size;
+  uint8_t const pad    = (uint8_t) (ff_size - size);
+  tu_fifo_idx_t const nLin = (tu_fifo_idx_t) tu_min32(n, (total - offset) / ff_size);
+
+  _ff_copy_strided(f->buffer + offset, ff_size, src, src_stride, size, pad, nLin);
+
+  n -= nLin;
+  if (!n) return;
+
+  src    += nLin * src_stride;
+  offset += nLin * ff_size;
+
+  // Sample split by the wrap around
+  uint8_t const head = (uint8_t) (total - offset);
+  uint8_t* dst = f->buffer;
+
+  if (head)
+  {
+    for(uint8_t i = 0; i < ff_size; i++)
+    {
+      uint8_t const b = (i < size) ? src[i] : 0;
+      if (i < head) f->buffer[offset + i] = b;
+      else          f->buffer[i - head]   = b;
+    }
+
+    src += src_stride;
+    dst += ff_size - head;
+    n--;
+  }
+
+  _ff_copy_strided(dst, ff_size, src, src_stride, size, pad, n);
+}
+
 // Advance an absolute pointer
-static uint16_t advance_pointer(tu_fifo_t* f, uint16_t p, uint16_t offset)
+static tu_fifo_idx_t advance_pointer(tu_fifo_t* f, tu_fifo_idx_t p, tu_fifo_idx_t offset)
 {
   // We limit the index space of p such that a correct wrap around happens
   // Check for a wrap around or if we are in unused index space - This has to be checked first!! We are exploiting the wrap around to the correct index
-  if ((p > p + offset) || (p + offset > f->max_pointer_idx))
+  tu_fifo_idx_t const next = (tu_fifo_idx_t) (p + offset);
+  if ((p > next) || (next > f->max_pointer_idx))
   {
-    p = (p + offset) + f->non_used_index_space;
+    p = next + f->non_used_index_space;
   }
   else
   {
@@ -158,13 +398,14 @@ static uint16_t advance_pointer(tu_fifo_t* f, uint16_t p, uint16_t offset)
 }
 
 // Backward an absolute pointer
-static uint16_t backward_pointer(tu_fifo_t* f, uint16_t p, uint16_t offset)
+static tu_fifo_idx_t backward_pointer(tu_fifo_t* f, tu_fifo_idx_t p, tu_fifo_idx_t offset)
 {
   // We limit the index space of p such that a correct wrap around happens
   // Check for a wrap around or if we are in unused index space - This has to be checked first!! We are exploiting the wrap around to the correct index
-  if ((p < p - offset) || (p - offset > f->max_pointer_idx))
+  tu_fifo_idx_t const prev = (tu_fifo_idx_t) (p - offset);
+  if ((p < prev) || (prev > f->max_pointer_idx))
   {
-    p = (p - offset) - f->non_used_index_space;
+    p = prev - f->non_used_index_space;
   }
   else
   {
@@ -174,15 +415,15 @@ static uint16_t backward_pointer(tu_fifo_t* f, uint16_t p, uint16_t offset)
 }
 
 // get relative from absolute pointer
-static uint16_t get_relative_pointer(tu_fifo_t* f, uint16_t p, uint16_t offset)
+static tu_fifo_idx_t get_relative_pointer(tu_fifo_t* f, tu_fifo_idx_t p, tu_fifo_idx_t offset)
 {
   return _ff_mod(advance_pointer(f, p, offset), f->depth);
 }
 
 // Works on local copies of w and r
-static inline uint16_t _tu_fifo_count(tu_fifo_t* f, uint16_t wAbs, uint16_t rAbs)
+static inline tu_fifo_idx_t _tu_fifo_count(tu_fifo_t* f, tu_fifo_idx_t wAbs, tu_fifo_idx_t rAbs)
 {
-  uint16_t cnt = wAbs-rAbs;
+  tu_fifo_idx_t cnt = wAbs-rAbs;
 
   // In case we have non-power of two depth we need a further modification
   if (rAbs > wAbs) cnt -= f->non_used_index_space;
@@ -191,13 +432,13 @@ static inline uint16_t _tu_fifo_count(tu_fifo_t* f, uint16_t wAbs, uint16_t rAbs
 }
 
 // Works on local copies of w and r
-static inline bool _tu_fifo_empty(uint16_t wAbs, uint16_t rAbs)
+static inline bool _tu_fifo_empty(tu_fifo_idx_t wAbs, tu_fifo_idx_t rAbs)
 {
   return wAbs == rAbs;
 }
 
 // Works on local copies of w and r
-static inline bool _tu_fifo_full(tu_fifo_t* f, uint16_t wAbs, uint16_t rAbs)
+static inline bool _tu_fifo_full(tu_fifo_t* f, tu_fifo_idx_t wAbs, tu_fifo_idx_t rAbs)
 {
   return (_tu_fifo_count(f, wAbs, rAbs) == f->depth);
 }
@@ -208,35 +449,36 @@ static inline bool _tu_fifo_full(tu_fifo_t* f, uint16_t wAbs, uint16_t rAbs)
 // write more than 2*depth-1 items in one rush without updating write pointer. Otherwise
 // write pointer wraps and you pointer states are messed up. This can only happen if you
 // use DMAs, write functions do not allow such an error.
-static inline bool _tu_fifo_overflowed(tu_fifo_t* f, uint16_t wAbs, uint16_t rAbs)
+static inline bool _tu_fifo_overflowed(tu_fifo_t* f, tu_fifo_idx_t wAbs, tu_fifo_idx_t rAbs)
 {
   return (_tu_fifo_count(f, wAbs, rAbs) > f->depth);
 }
 
 // Works on local copies of w
 // For more details see _tu_fifo_overflow()!
-static inline void _tu_fifo_correct_read_pointer(tu_fifo_t* f, uint16_t wAbs)
+static inline void _tu_fifo_correct_read_pointer(tu_fifo_t* f, tu_fifo_idx_t wAbs)
 {
-  f->rd_idx = backward_pointer(f, wAbs, f->depth);
+  tu_fifo_idx_store(&f->rd_idx, backward_pointer(f, wAbs, f->depth));
 }
 
 // Works on local copies of w and r
 // Must be protected by mutexes since in case of an overflow read pointer gets modified
-static bool _tu_fifo_peek_at(tu_fifo_t* f, uint16_t offset, void * p_buffer, uint16_t wAbs, uint16_t rAbs)
+static bool _tu_fifo_peek_at(tu_fifo_t* f, tu_fifo_idx_t offset, void * p_buffer, tu_fifo_idx_t wAbs, tu_fifo_idx_t rAbs)
 {
-  uint16_t cnt = _tu_fifo_count(f, wAbs, rAbs);
+  tu_fifo_idx_t cnt = _tu_fifo_count(f, wAbs, rAbs);
 
   // Check overflow and correct if required
   if (cnt > f->depth)
   {
     _tu_fifo_correct_read_pointer(f, wAbs);
+    rAbs = f->rd_idx;
     cnt = f->depth;
   }
 
   // Skip beginning of buffer
   if (cnt == 0 || offset >= cnt) return false;
 
-  uint16_t rRel = get_relative_pointer(f, rAbs, offset);
+  tu_fifo_idx_t rRel = get_relative_pointer(f, rAbs, offset);
 
   // Peek data
   _ff_pull(f, p_buffer, rRel);
@@ -246,9 +488,9 @@ static bool _tu_fifo_peek_at(tu_fifo_t* f, uint16_t offset, void * p_buffer, uin
 
 // Works on local copies of w and r
 // Must be protected by mutexes since in case of an overflow read pointer gets modified
-static uint16_t _tu_fifo_peek_at_n(tu_fifo_t* f, uint16_t offset, void * p_buffer, uint16_t n, uint16_t wAbs, uint16_t rAbs)
+static tu_fifo_idx_t _tu_fifo_peek_at_n(tu_fifo_t* f, tu_fifo_idx_t offset, void * p_buffer, tu_fifo_idx_t n, tu_fifo_idx_t wAbs, tu_fifo_idx_t rAbs)
 {
-  uint16_t cnt = _tu_fifo_count(f, wAbs, rAbs);
+  tu_fifo_idx_t cnt = _tu_fifo_count(f, wAbs, rAbs);
 
   // Check overflow and correct if required
   if (cnt > f->depth)
@@ -268,7 +510,7 @@ static uint16_t _tu_fifo_peek_at_n(tu_fifo_t* f, uint16_t offset, void * p_buffe
     n = cnt;
   }
 
-  uint16_t rRel = get_relative_pointer(f, rAbs, offset);
+  tu_fifo_idx_t rRel = get_relative_pointer(f, rAbs, offset);
 
   // Peek data
   _ff_pull_n(f, p_buffer, n, rRel);
@@ -277,11 +519,51 @@ static uint16_t _tu_fifo_peek_at_n(tu_fifo_t* f, uint16_t offset, void * p_buffe
 }
 
 // Works on local copies of w and r
-static inline uint16_t _tu_fifo_remaining(tu_fifo_t* f, uint16_t wAbs, uint16_t rAbs)
+static inline tu_fifo_idx_t _tu_fifo_remaining(tu_fifo_t* f, tu_fifo_idx_t wAbs, tu_fifo_idx_t rAbs)
 {
   return f->depth - _tu_fifo_count(f, wAbs, rAbs);
 }
 
+#if CFG_TUSB_FIFO_STATS
+// Update write side statistics: n out of requested items were written to a FIFO holding cnt items
+static void _ff_stats_write(tu_fifo_t* f, tu_fifo_idx_t cnt, tu_fifo_idx_t n, tu_fifo_idx_t requested)
+{
+  uint32_t level = (uint32_t) cnt + n;
+
+  f->stats.written += n;
+  if ( n < requested ) f->stats.rejected++;
+
+  // unread items got overwritten
+  if ( level > f->depth )
+  {
+    f->stats.overflows++;
+    level = f->depth;
+  }
+
+  if ( level > f->stats.peak_count ) f->stats.peak_count = (tu_fifo_idx_t) level;
+}
+
+#define _ff_stats_read(_f, _n)    do { (_f)->stats.read += (_n); } while(0)
+
+#else
+
+#define _ff_stats_write(_f, _cnt, _n, _requested)
+#define _ff_stats_read(_f, _n)
+
+#endif
+
+#if CFG_TUSB_FIFO_TAP
+// Announce to taps that n items starting at wAbs are about to be written. A tap copying
+// these slots (holding items of the previous lap) at the same time discards them.
+static inline void _ff_claim(tu_fifo_t* f, tu_fifo_idx_t wAbs, tu_fifo_idx_t n)
+{
+  f->wr_claim = advance_pointer(f, wAbs, n);
+  TU_ATOMIC_FENCE_RELEASE();
+}
+#else
+#define _ff_claim(_f, _wAbs, _n)
+#endif
+
 /******************************************************************************/
 /*!
     @brief Get number of items in FIFO.
@@ -295,9 +577,9 @@ static inline uint16_t _tu_fifo_remaining(tu_fifo_t* f, uint16_t wAbs, uint16_t
     @returns Number of items in FIFO
  */
 /******************************************************************************/
-uint16_t tu_fifo_count(tu_fifo_t* f)
+tu_fifo_idx_t tu_fifo_count(tu_fifo_t* f)
 {
-  return _tu_fifo_count(f, f->wr_idx, f->rd_idx);
+  return _tu_fifo_count(f, tu_fifo_idx_load(&f->wr_idx), tu_fifo_idx_load(&f->rd_idx));
 }
 
 /******************************************************************************/
@@ -315,7 +597,7 @@ uint16_t tu_fifo_count(tu_fifo_t* f)
 /******************************************************************************/
 bool tu_fifo_empty(tu_fifo_t* f)
 {
-  return _tu_fifo_empty(f->wr_idx, f->rd_idx);
+  return _tu_fifo_empty(tu_fifo_idx_load(&f->wr_idx), tu_fifo_idx_load(&f->rd_idx));
 }
 
 /******************************************************************************/
@@ -333,7 +615,7 @@ bool tu_fifo_empty(tu_fifo_t* f)
 /******************************************************************************/
 bool tu_fifo_full(tu_fifo_t* f)
 {
-  return _tu_fifo_full(f, f->wr_idx, f->rd_idx);
+  return _tu_fifo_full(f, tu_fifo_idx_load(&f->wr_idx), tu_fifo_idx_load(&f->rd_idx));
 }
 
 /******************************************************************************/
@@ -349,9 +631,9 @@ bool tu_fifo_full(tu_fifo_t* f)
     @returns Number of items in FIFO
  */
 /******************************************************************************/
-uint16_t tu_fifo_remaining(tu_fifo_t* f)
+tu_fifo_idx_t tu_fifo_remaining(tu_fifo_t* f)
 {
-  return _tu_fifo_remaining(f, f->wr_idx, f->rd_idx);
+  return _tu_fifo_remaining(f, tu_fifo_idx_load(&f->wr_idx), tu_fifo_idx_load(&f->rd_idx));
 }
 
 /******************************************************************************/
@@ -377,14 +659,14 @@ uint16_t tu_fifo_remaining(tu_fifo_t* f)
 /******************************************************************************/
 bool tu_fifo_overflowed(tu_fifo_t* f)
 {
-  return _tu_fifo_overflowed(f, f->wr_idx, f->rd_idx);
+  return _tu_fifo_overflowed(f, tu_fifo_idx_load(&f->wr_idx), tu_fifo_idx_load(&f->rd_idx));
 }
 
 // Only use in case tu_fifo_overflow() returned true!
 void tu_fifo_correct_read_pointer(tu_fifo_t* f)
 {
   tu_fifo_lock(f);
-  _tu_fifo_correct_read_pointer(f, f->wr_idx);
+  _tu_fifo_correct_read_pointer(f, tu_fifo_idx_load(&f->wr_idx));
   tu_fifo_unlock(f);
 }
 
@@ -409,10 +691,11 @@ bool tu_fifo_read(tu_fifo_t* f, void * buffer)
   tu_fifo_lock(f);                                          // TODO: Here we may distinguish for read and write pointer mutexes!
 
   // Peek the data
-  bool ret = _tu_fifo_peek_at(f, 0, buffer, f->wr_idx, f->rd_idx);    // f->rd_idx might get modified in case of an overflow so we can not use a local variable
+  bool ret = _tu_fifo_peek_at(f, 0, buffer, tu_fifo_idx_load(&f->wr_idx), f->rd_idx);    // f->rd_idx might get modified in case of an overflow so we can not use a local variable
 
   // Advance pointer
-  f->rd_idx = advance_pointer(f, f->rd_idx, ret);
+  tu_fifo_idx_store(&f->rd_idx, advance_pointer(f, f->rd_idx, ret));
+  _ff_stats_read(f, ret);
 
   tu_fifo_unlock(f);
   return ret;
@@ -434,15 +717,16 @@ bool tu_fifo_read(tu_fifo_t* f, void * buffer)
     @returns number of items read from the FIFO
  */
 /******************************************************************************/
-uint16_t tu_fifo_read_n(tu_fifo_t* f, void * buffer, uint16_t count)
+tu_fifo_idx_t tu_fifo_read_n(tu_fifo_t* f, void * buffer, tu_fifo_idx_t count)
 {
   tu_fifo_lock(f);                                          // TODO: Here we may distinguish for read and write pointer mutexes!
 
   // Peek the data
-  count = _tu_fifo_peek_at_n(f, 0, buffer, count, f->wr_idx, f->rd_idx);        // f->rd_idx might get modified in case of an overflow so we can not use a local variable
+  count = _tu_fifo_peek_at_n(f, 0, buffer, count, tu_fifo_idx_load(&f->wr_idx), f->rd_idx);        // f->rd_idx might get modified in case of an overflow so we can not use a local variable
 
   // Advance read pointer
-  f->rd_idx = advance_pointer(f, f->rd_idx, count);
+  tu_fifo_idx_store(&f->rd_idx, advance_pointer(f, f->rd_idx, count));
+  _ff_stats_read(f, count);
 
   tu_fifo_unlock(f);
   return count;
@@ -463,10 +747,10 @@ uint16_t tu_fifo_read_n(tu_fifo_t* f, void * buffer, uint16_t count)
     @returns TRUE if the queue is not empty
  */
 /******************************************************************************/
-bool tu_fifo_peek_at(tu_fifo_t* f, uint16_t offset, void * p_buffer)
+bool tu_fifo_peek_at(tu_fifo_t* f, tu_fifo_idx_t offset, void * p_buffer)
 {
   tu_fifo_lock(f);                                          // TODO: Here we may distinguish for read and write pointer mutexes!
-  bool ret = _tu_fifo_peek_at(f, offset, p_buffer, f->wr_idx, f->rd_idx);
+  bool ret = _tu_fifo_peek_at(f, offset, p_buffer, tu_fifo_idx_load(&f->wr_idx), f->rd_idx);
   tu_fifo_unlock(f);
   return ret;
 }
@@ -488,10 +772,10 @@ bool tu_fifo_peek_at(tu_fifo_t* f, uint16_t offset, void * p_buffer)
     @returns Number of bytes written to p_buffer
  */
 /******************************************************************************/
-uint16_t tu_fifo_peek_at_n(tu_fifo_t* f, uint16_t offset, void * p_buffer, uint16_t n)
+tu_fifo_idx_t tu_fifo_peek_at_n(tu_fifo_t* f, tu_fifo_idx_t offset, void * p_buffer, tu_fifo_idx_t n)
 {
   tu_fifo_lock(f);                                          // TODO: Here we may distinguish for read and write pointer mutexes!
-  bool ret = _tu_fifo_peek_at_n(f, offset, p_buffer, n, f->wr_idx, f->rd_idx);
+  tu_fifo_idx_t ret = _tu_fifo_peek_at_n(f, offset, p_buffer, n, tu_fifo_idx_load(&f->wr_idx), f->rd_idx);
   tu_fifo_unlock(f);
   return ret;
 }
@@ -516,17 +800,25 @@ bool tu_fifo_write(tu_fifo_t* f, const void * data)
 {
   tu_fifo_lock(f);
 
-  uint16_t w = f->wr_idx;
+  tu_fifo_idx_t w = f->wr_idx;
+  tu_fifo_idx_t const cnt = _tu_fifo_count(f, w, tu_fifo_idx_load(&f->rd_idx));
 
-  if ( _tu_fifo_full(f, w, f->rd_idx) && !f->overwritable ) return false;
+  if ( (cnt >= f->depth) && !f->overwritable )
+  {
+    _ff_stats_write(f, cnt, 0, 1);
+    tu_fifo_unlock(f);
+    return false;
+  }
 
-  uint16_t wRel = get_relative_pointer(f, w, 0);
+  tu_fifo_idx_t wRel = get_relative_pointer(f, w, 0);
 
   // Write data
+  _ff_claim(f, w, 1);
   _ff_push(f, data, wRel);
 
   // Advance pointer
-  f->wr_idx = advance_pointer(f, w, 1);
+  tu_fifo_idx_store(&f->wr_idx, advance_pointer(f, w, 1));
+  _ff_stats_write(f, cnt, 1, 1);
 
   tu_fifo_unlock(f);
 
@@ -547,19 +839,23 @@ bool tu_fifo_write(tu_fifo_t* f, const void * data)
     @return Number of written elements
  */
 /******************************************************************************/
-uint16_t tu_fifo_write_n(tu_fifo_t* f, const void * data, uint16_t count)
+tu_fifo_idx_t tu_fifo_write_n(tu_fifo_t* f, const void * data, tu_fifo_idx_t count)
 {
   if ( count == 0 ) return 0;
 
   tu_fifo_lock(f);
 
-  uint16_t w = f->wr_idx, r = f->rd_idx;
+  tu_fifo_idx_t w = f->wr_idx, r = tu_fifo_idx_load(&f->rd_idx);
+#if CFG_TUSB_FIFO_STATS
+  tu_fifo_idx_t const requested = count, cnt = _tu_fifo_count(f, w, r);
+#endif
   uint8_t const* buf8 = (uint8_t const*) data;
 
   if (!f->overwritable)
   {
     // Not overwritable limit up to full
-    count = tu_min16(count, _tu_fifo_remaining(f, w, r));
+    tu_fifo_idx_t const remain = _tu_fifo_remaining(f, w, r);
+    if (count > remain) count = remain;
   }
   else if (count > f->depth)
   {
@@ -570,22 +866,282 @@ uint16_t tu_fifo_write_n(tu_fifo_t* f, const void * data, uint16_t count)
     // We start writing at the read pointer's position since we fill the complete
     // buffer and we do not want to modify the read pointer within a write function!
     // This would end up in a race condition with read functions!
-    f->wr_idx = r;
+    w = r;
   }
 
-  uint16_t wRel = get_relative_pointer(f, w, 0);
+  tu_fifo_idx_t wRel = get_relative_pointer(f, w, 0);
 
   // Write data
+  _ff_claim(f, w, count);
   _ff_push_n(f, buf8, count, wRel);
 
   // Advance pointer
-  f->wr_idx = advance_pointer(f, w, count);
+  tu_fifo_idx_store(&f->wr_idx, advance_pointer(f, w, count));
+  _ff_stats_write(f, cnt, count, requested);
+
+  tu_fifo_unlock(f);
+
+  return count;
+}
+
+/******************************************************************************/
+/*!
+    @brief This function will write n elements read from a fixed address (e.g
+    a hardware FIFO register) into the array index specified by the write
+    pointer and increment the write index. The register is read in 32-bit
+    words, bytes of a word are stored in memory order. The linear and wrapped
+    part of the buffer are filled as one byte stream, if n*item_size is not a
+    multiple of four the unused bytes of the last word read are dropped.
+
+    In overwritable mode the leading items exceeding the depth are read from
+    the register and discarded.
+
+    @param[in]  f
+                Pointer to the FIFO buffer to manipulate
+    @param[in]  data
+                Fixed address to read from, must be 32-bit aligned
+    @param[in]  count
+                Number of element
+    @return Number of written elements
+ */
+/******************************************************************************/
+tu_fifo_idx_t tu_fifo_write_n_const_addr(tu_fifo_t* f, const void * data, tu_fifo_idx_t count)
+{
+  if ( count == 0 ) return 0;
+
+  tu_fifo_lock(f);
+
+  tu_fifo_idx_t w = f->wr_idx, r = tu_fifo_idx_load(&f->rd_idx);
+#if CFG_TUSB_FIFO_STATS
+  tu_fifo_idx_t const requested = count, cnt = _tu_fifo_count(f, w, r);
+#endif
+  uint32_t skip_bytes = 0;
+
+  if (!f->overwritable)
+  {
+    // Not overwritable limit up to full
+    tu_fifo_idx_t const remain = _tu_fifo_remaining(f, w, r);
+    if (count > remain) count = remain;
+  }
+  else if (count > f->depth)
+  {
+    // Only keep last part, but the register still has to be drained
+    skip_bytes = (uint32_t) (count - f->depth) * f->item_size;
+    count = f->depth;
+
+    // Same as tu_fifo_write_n(), refill complete buffer from the read pointer's position
+    w = r;
+  }
+
+  tu_fifo_idx_t wRel = get_relative_pointer(f, w, 0);
+
+  // Write data
+  _ff_claim(f, w, count);
+  _ff_push_const_addr(f, (volatile uint32_t const*) data, count, wRel, skip_bytes);
+
+  // Advance pointer
+  tu_fifo_idx_store(&f->wr_idx, advance_pointer(f, w, count));
+  _ff_stats_write(f, cnt, count, requested);
+
+  tu_fifo_unlock(f);
+
+  return count;
+}
+
+/******************************************************************************/
+/*!
+    @brief This function will read n elements from the array index specified by
+    the read pointer, write them to a fixed address (e.g a hardware FIFO
+    register) and increment the read index. The register is written in 32-bit
+    words made up from the bytes in memory order, across the wrap around of the
+    buffer. If n*item_size is not a multiple of four the last word is padded
+    with zeros.
+
+    This function checks for an overflow and corrects read pointer if required.
+
+    @param[in]  f
+                Pointer to the FIFO buffer to manipulate
+    @param[in]  buffer
+                Fixed address to write to, must be 32-bit aligned
+    @param[in]  count
+                Number of element
+    @returns number of items read from the FIFO
+ */
+/******************************************************************************/
+tu_fifo_idx_t tu_fifo_read_n_const_addr(tu_fifo_t* f, void * buffer, tu_fifo_idx_t count)
+{
+  tu_fifo_lock(f);
+
+  tu_fifo_idx_t const w = tu_fifo_idx_load(&f->wr_idx);
+  tu_fifo_idx_t r = f->rd_idx;
+  tu_fifo_idx_t cnt = _tu_fifo_count(f, w, r);
+
+  // Check overflow and correct if required
+  if (cnt > f->depth)
+  {
+    _tu_fifo_correct_read_pointer(f, w);
+    r = f->rd_idx;
+    cnt = f->depth;
+  }
+
+  if (count > cnt) count = cnt;
+
+  if (count)
+  {
+    _ff_pull_const_addr(f, (volatile uint32_t*) buffer, count, get_relative_pointer(f, r, 0));
+
+    // Advance read pointer
+    tu_fifo_idx_store(&f->rd_idx, advance_pointer(f, r, count));
+    _ff_stats_read(f, count);
+  }
 
   tu_fifo_unlock(f);
 
   return count;
 }
 
+/******************************************************************************/
+/*!
+    @brief Read samples from several FIFOs, one per channel, and interleave them
+    into a linear buffer: sample i of FIFO c is placed at position i*n_ff + c.
+    Only as many samples as every FIFO can supply are read, so all channels
+    stay in sync. This function checks for an overflow and corrects read
+    pointer if required.
+
+    @param[in]  ff
+                Array of n_ff FIFOs
+    @param[in]  n_ff
+                Number of FIFOs (channels)
+    @param[out] buffer
+                Pointer to the interleaved data
+    @param[in]  n_samples
+                Maximum number of samples read from each FIFO
+    @param[in]  ff_sample_size
+                Number of bytes a sample occupies in a FIFO, must be a multiple
+                of the item size
+    @param[in]  sample_size
+                Number of bytes per sample in buffer, the first sample_size bytes
+                of each FIFO sample are copied. Sizes 1 to 4 are optimized.
+
+    @returns number of samples read from each FIFO
+ */
+/******************************************************************************/
+tu_fifo_idx_t tu_fifo_read_n_interleaved(tu_fifo_t ff[], uint8_t n_ff, void * buffer, tu_fifo_idx_t n_samples,
+                                         uint8_t ff_sample_size, uint8_t sample_size)
+{
+  if ( (sample_size == 0) || (sample_size > ff_sample_size) ) return 0;
+
+  // Samples available in all FIFOs
+  for(uint8_t c = 0; c < n_ff; c++)
+  {
+    if ( ff_sample_size % ff[c].item_size ) return 0;
+
+    uint32_t const avail = (uint32_t) tu_fifo_count(&ff[c]) * ff[c].item_size / ff_sample_size;
+    if (avail < n_samples) n_samples = (tu_fifo_idx_t) avail;
+  }
+
+  if (n_samples == 0) return 0;
+
+  uint16_t const frame_size = (uint16_t) (n_ff * sample_size);
+
+  for(uint8_t c = 0; c < n_ff; c++)
+  {
+    tu_fifo_t* f = &ff[c];
+    tu_fifo_idx_t const n_items = (tu_fifo_idx_t) ((uint32_t) n_samples * ff_sample_size / f->item_size);
+
+    tu_fifo_lock(f);
+
+    tu_fifo_idx_t const w = tu_fifo_idx_load(&f->wr_idx);
+
+    // Check overflow and correct if required
+    if (_tu_fifo_count(f, w, f->rd_idx) > f->depth) _tu_fifo_correct_read_pointer(f, w);
+
+    tu_fifo_idx_t const r = f->rd_idx;
+
+    _ff_pull_strided(f, ((uint8_t*) buffer) + c*sample_size, frame_size, n_samples, get_relative_pointer(f, r, 0),
+                     ff_sample_size, sample_size);
+
+    // Advance read pointer
+    tu_fifo_idx_store(&f->rd_idx, advance_pointer(f, r, n_items));
+    _ff_stats_read(f, n_items);
+
+    tu_fifo_unlock(f);
+  }
+
+  return n_samples;
+}
+
+/******************************************************************************/
+/*!
+    @brief Split interleaved samples of a linear buffer into several FIFOs, one
+    per channel: sample at position i*n_ff + c is written to FIFO c. Only as
+    many samples as every FIFO can take are written, an overwritable FIFO takes
+    up to its depth overwriting the oldest samples.
+
+    @param[in]  ff
+                Array of n_ff FIFOs
+    @param[in]  n_ff
+                Number of FIFOs (channels)
+    @param[in]  buffer
+                Pointer to the interleaved data
+    @param[in]  n_samples
+                Number of samples written to each FIFO
+    @param[in]  ff_sample_size
+                Number of bytes a sample occupies in a FIFO, must be a multiple
+                of the item size. Bytes exceeding sample_size are zeroed.
+    @param[in]  sample_size
+                Number of bytes per sample in buffer. Sizes 1 to 4 are optimized.
+
+    @returns number of samples written to each FIFO
+ */
+/******************************************************************************/
+tu_fifo_idx_t tu_fifo_write_n_interleaved(tu_fifo_t ff[], uint8_t n_ff, void const * buffer, tu_fifo_idx_t n_samples,
+                                          uint8_t ff_sample_size, uint8_t sample_size)
+{
+  if ( (sample_size == 0) || (sample_size > ff_sample_size) ) return 0;
+
+#if CFG_TUSB_FIFO_STATS
+  tu_fifo_idx_t const requested = n_samples;
+#endif
+
+  // Samples fitting into all FIFOs
+  for(uint8_t c = 0; c < n_ff; c++)
+  {
+    if ( ff_sample_size % ff[c].item_size ) return 0;
+
+    tu_fifo_idx_t const space = ff[c].overwritable ? ff[c].depth : tu_fifo_remaining(&ff[c]);
+    uint32_t const avail = (uint32_t) space * ff[c].item_size / ff_sample_size;
+    if (avail < n_samples) n_samples = (tu_fifo_idx_t) avail;
+  }
+
+  if (n_samples == 0) return 0;
+
+  uint16_t const frame_size = (uint16_t) (n_ff * sample_size);
+
+  for(uint8_t c = 0; c < n_ff; c++)
+  {
+    tu_fifo_t* f = &ff[c];
+    tu_fifo_idx_t const n_items = (tu_fifo_idx_t) ((uint32_t) n_samples * ff_sample_size / f->item_size);
+
+    tu_fifo_lock(f);
+
+    tu_fifo_idx_t const w = f->wr_idx;
+
+    _ff_claim(f, w, n_items);
+    _ff_push_strided(f, ((uint8_t const*) buffer) + c*sample_size, frame_size, n_samples, get_relative_pointer(f, w, 0),
+                     ff_sample_size, sample_size);
+
+    // Advance pointer
+    tu_fifo_idx_store(&f->wr_idx, advance_pointer(f, w, n_items));
+    _ff_stats_write(f, _tu_fifo_count(f, w, tu_fifo_idx_load(&f->rd_idx)), n_items,
+                    (n_samples < requested) ? (tu_fifo_idx_t) (n_items + 1) : n_items);
+
+    tu_fifo_unlock(f);
+  }
+
+  return n_samples;
+}
+
 /******************************************************************************/
 /*!
     @brief Clear the fifo read and write pointers
@@ -598,8 +1154,13 @@ bool tu_fifo_clear(tu_fifo_t *f)
 {
   tu_fifo_lock(f);
   f->rd_idx = f->wr_idx = 0;
+#if CFG_TUSB_FIFO_TAP
+  // attached taps restart from the beginning
+  f->wr_claim = 0;
+  f->clear_count++;
+#endif
   f->max_pointer_idx = 2*f->depth-1;
-  f->non_used_index_space = UINT16_MAX - f->max_pointer_idx;
+  f->non_used_index_space = TU_FIFO_IDX_MAX - f->max_pointer_idx;
   tu_fifo_unlock(f);
 
   return true;
@@ -642,9 +1203,18 @@ bool tu_fifo_set_overwritable(tu_fifo_t *f, bool overwritable)
                 Number of items the write pointer moves forward
  */
 /******************************************************************************/
-void tu_fifo_advance_write_pointer(tu_fifo_t *f, uint16_t n)
+void tu_fifo_advance_write_pointer(tu_fifo_t *f, tu_fifo_idx_t n)
 {
-  f->wr_idx = advance_pointer(f, f->wr_idx, n);
+#if CFG_TUSB_FIFO_STATS
+  _ff_stats_write(f, _tu_fifo_count(f, f->wr_idx, tu_fifo_idx_load(&f->rd_idx)), n, n);
+#endif
+
+#if CFG_TUSB_FIFO_TAP
+  // Items not announced by tu_fifo_get_write_info()
+  if ( _tu_fifo_count(f, f->wr_claim, f->wr_idx) < n ) _ff_claim(f, f->wr_idx, n);
+#endif
+
+  tu_fifo_idx_store(&f->wr_idx, advance_pointer(f, f->wr_idx, n));
 }
 
 /******************************************************************************/
@@ -663,7 +1233,293 @@ void tu_fifo_advance_write_pointer(tu_fifo_t *f, uint16_t n)
                 Number of items the read pointer moves forward
  */
 /******************************************************************************/
-void tu_fifo_advance_read_pointer(tu_fifo_t *f, uint16_t n)
+void tu_fifo_advance_read_pointer(tu_fifo_t *f, tu_fifo_idx_t n)
+{
+  tu_fifo_idx_store(&f->rd_idx, advance_pointer(f, f->rd_idx, n));
+  _ff_stats_read(f, n);
+}
+
+/******************************************************************************/
+/*!
+    @brief Get linear read info - intended to be used in combination with DMA
+    or an endpoint transfer reading straight out of the FIFO memory. Returns
+    the length and pointer of the linear part and, in case the data wraps
+    around, the length and pointer of the wrapped part. After the data was
+    processed the read pointer must be advanced with
+    tu_fifo_advance_read_pointer() by the number of items consumed.
+    This function checks for an overflow and corrects read pointer if required.
+
+    @param[in]  f
+                Pointer to the FIFO buffer to manipulate
+    @param[out] info
+                Pointer to the info struct to be filled. Lengths are zero and
+                pointers are NULL if the FIFO is empty.
+ */
+/******************************************************************************/
+void tu_fifo_get_read_info(tu_fifo_t *f, tu_fifo_buffer_info_t *info)
+{
+  // Operate on temporary values in case they change in between
+  tu_fifo_idx_t w = tu_fifo_idx_load(&f->wr_idx), r = f->rd_idx;
+
+  tu_fifo_idx_t cnt = _tu_fifo_count(f, w, r);
+
+  // Check overflow and correct if required - may happen in case a DMA wrote too fast
+  if (cnt > f->depth)
+  {
+    tu_fifo_lock(f);
+    _tu_fifo_correct_read_pointer(f, w);
+    tu_fifo_unlock(f);
+    r = f->rd_idx;
+    cnt = f->depth;
+  }
+
+  // Check if FIFO is empty
+  if (cnt == 0)
+  {
+    info->len_lin  = 0;
+    info->len_wrap = 0;
+    info->ptr_lin  = NULL;
+    info->ptr_wrap = NULL;
+    return;
+  }
+
+  // Get relative pointers
+  w = get_relative_pointer(f, w, 0);
+  r = get_relative_pointer(f, r, 0);
+
+  // Copy pointer to buffer to start reading from
+  info->ptr_lin = &f->buffer[r * f->item_size];
+
+  // Check if there is a wrap around necessary
+  if (w > r)
+  {
+    // Non wrapping case
+    info->len_lin  = cnt;
+    info->len_wrap = 0;
+    info->ptr_wrap = NULL;
+  }
+  else
+  {
+    info->len_lin  = f->depth - r;        // Also the case if FIFO was full
+    info->len_wrap = cnt - info->len_lin;
+    info->ptr_wrap = info->len_wrap ? f->buffer : NULL;
+  }
+}
+
+/******************************************************************************/
+/*!
+    @brief Get linear write info - intended to be used in combination with DMA
+    or an endpoint transfer writing straight into the FIFO memory. Returns the
+    length and pointer of the free linear part and, in case the free space wraps
+    around, the length and pointer of the wrapped part. After the data was
+    written the write pointer must be advanced with
+    tu_fifo_advance_write_pointer() by the number of items produced.
+
+    Only the free space is reported, an overwritable FIFO is not overwritten
+    through this interface.
+
+    @param[in]  f
+                Pointer to the FIFO buffer to manipulate
+    @param[out] info
+                Pointer to the info struct to be filled. Lengths are zero and
+                pointers are NULL if the FIFO is full.
+ */
+/******************************************************************************/
+void tu_fifo_get_write_info(tu_fifo_t *f, tu_fifo_buffer_info_t *info)
+{
+  // Operate on temporary values in case they change in between
+  tu_fifo_idx_t w = f->wr_idx, r = tu_fifo_idx_load(&f->rd_idx);
+
+  tu_fifo_idx_t cnt = _tu_fifo_count(f, w, r);
+
+  // An overflowed FIFO has no free space either
+  tu_fifo_idx_t free = (cnt >= f->depth) ? 0 : (f->depth - cnt);
+
+  if (free == 0)
+  {
+    info->len_lin  = 0;
+    info->len_wrap = 0;
+    info->ptr_lin  = NULL;
+    info->ptr_wrap = NULL;
+    return;
+  }
+
+  // Free space may be written from now on
+  _ff_claim(f, w, free);
+
+  // Get relative pointers
+  w = get_relative_pointer(f, w, 0);
+  r = get_relative_pointer(f, r, 0);
+
+  // Copy pointer to buffer to start writing to
+  info->ptr_lin = &f->buffer[w * f->item_size];
+
+  // Check if there is a wrap around necessary
+  if (w < r)
+  {
+    // Non wrapping case
+    info->len_lin  = free;
+    info->len_wrap = 0;
+    info->ptr_wrap = NULL;
+  }
+  else
+  {
+    info->len_lin  = f->depth - w;        // Also the case if FIFO was empty
+    info->len_wrap = free - info->len_lin;
+    info->ptr_wrap = info->len_wrap ? f->buffer : NULL;
+  }
+}
+
+#if CFG_TUSB_FIFO_TAP
+
+// FIFO was cleared since last access, restart from its beginning
+static inline void _ff_tap_sync(tu_fifo_tap_t* tap)
+{
+  if ( tap->clear_count != tap->ff->clear_count )
+  {
+    tap->clear_count = tap->ff->clear_count;
+    tap->rd_idx = 0;
+  }
+}
+
+/******************************************************************************/
+/*!
+    @brief Attach an additional reader (tap) to a FIFO. The tap starts at the
+    read position of the primary reader, thereby it sees all items not read
+    yet and everything written afterwards.
+
+    @param[in]  tap
+                Pointer to the tap
+    @param[in]  f
+                Pointer to the FIFO buffer to be tapped
+ */
+/******************************************************************************/
+void tu_fifo_tap_attach(tu_fifo_tap_t* tap, tu_fifo_t* f)
+{
+  tu_fifo_lock(f);
+  tap->ff          = f;
+  tap->rd_idx      = tu_fifo_idx_load(&f->rd_idx);
+  tap->clear_count = f->clear_count;
+  tap->lost        = 0;
+  tu_fifo_unlock(f);
+}
+
+/******************************************************************************/
+/*!
+    @brief Get number of items available for a tap, at most the FIFO depth.
+
+    @param[in]  tap
+                Pointer to the tap
+
+    @returns Number of items
+ */
+/******************************************************************************/
+tu_fifo_idx_t tu_fifo_tap_count(tu_fifo_tap_t* tap)
+{
+  tu_fifo_t* f = tap->ff;
+  _ff_tap_sync(tap);
+  return tu_min32(_tu_fifo_count(f, tu_fifo_idx_load(&f->wr_idx), tap->rd_idx), f->depth);
+}
+
+/******************************************************************************/
+/*!
+    @brief Read n items for a tap. Neither the writer nor the primary reader
+    are blocked, hence no locking takes place. Items overwritten before or while
+    the tap copies them are dropped and counted in tap->lost, the remaining
+    items are returned in order.
+
+    Only writes announced to taps are detected, i.e DMA transfers must use
+    tu_fifo_get_write_info() before writing into the FIFO.
+
+    @param[in]  tap
+                Pointer to the tap
+    @param[out] buffer
+                The pointer to data location
+    @param[in]  count
+                Number of element that buffer can afford
+
+    @returns number of items read
+ */
+/******************************************************************************/
+tu_fifo_idx_t tu_fifo_tap_read_n(tu_fifo_tap_t* tap, void * buffer, tu_fifo_idx_t count)
 {
-  f->rd_idx = advance_pointer(f, f->rd_idx, n);
+  tu_fifo_t* f = tap->ff;
+  _ff_tap_sync(tap);
+
+  tu_fifo_idx_t const w = tu_fifo_idx_load(&f->wr_idx);
+  tu_fifo_idx_t r = tap->rd_idx;
+  tu_fifo_idx_t cnt = _tu_fifo_count(f, w, r);
+
+  // Tap lagged more than a whole FIFO behind, skip to the oldest item
+  if (cnt > f->depth)
+  {
+    tap->lost += cnt - f->depth;
+    r = backward_pointer(f, w, f->depth);
+    cnt = f->depth;
+  }
+
+  if (count > cnt) count = cnt;
+
+  _ff_pull_n(f, buffer, count, get_relative_pointer(f, r, 0));
+
+  // Items the writer claimed a slot for since then may be corrupted
+  TU_ATOMIC_FENCE_ACQUIRE();
+  tu_fifo_idx_t const claim_dist = _tu_fifo_count(f, f->wr_claim, r);
+
+  if (claim_dist > f->depth)
+  {
+    tu_fifo_idx_t const drop = (tu_fifo_idx_t) tu_min32(claim_dist - f->depth, count);
+
+    memmove(buffer, ((uint8_t*) buffer) + drop*f->item_size, (count - drop)*f->item_size);
+
+    tap->lost += drop;
+    r = advance_pointer(f, r, drop);
+    count -= drop;
+  }
+
+  tap->rd_idx = advance_pointer(f, r, count);
+
+  return count;
+}
+
+#endif
+
+#if CFG_TUSB_FIFO_STATS
+
+/******************************************************************************/
+/*!
+    @brief Get usage statistics of the FIFO, e.g to find out if the FIFO is
+    sized too small (overflows, rejected writes) or too large (peak count well
+    below depth). Counters wrap around silently.
+
+    @param[in]  f
+                Pointer to the FIFO buffer
+    @param[out] stats
+                Pointer to the stats struct to be filled
+ */
+/******************************************************************************/
+void tu_fifo_get_stats(tu_fifo_t *f, tu_fifo_stats_t *stats)
+{
+  tu_fifo_lock(f);
+  *stats = f->stats;
+  tu_fifo_unlock(f);
+}
+
+/******************************************************************************/
+/*!
+    @brief Reset usage statistics of the FIFO. Peak count restarts from the
+    current number of items.
+
+    @param[in]  f
+                Pointer to the FIFO buffer
+ */
+/******************************************************************************/
+void tu_fifo_reset_stats(tu_fifo_t *f)
+{
+  tu_fifo_lock(f);
+  memset(&f->stats, 0, sizeof(f->stats));
+  f->stats.peak_count = tu_fifo_count(f);
+  tu_fifo_unlock(f);
 }
+
+#endif
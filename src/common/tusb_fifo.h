@@ -31,6 +31,9 @@
 #ifndef _TUSB_FIFO_H_
 #define _TUSB_FIFO_H_
 
+// configuration below must be seen before the defaults, fifo layout depends on it
+#include "tusb_option.h"
+
 // Due to the use of unmasked pointers, this FIFO does not suffer from loosing
 // one item slice. Furthermore, write and read operations are completely
 // decoupled as write and read functions do not modify a common state. Henceforth,
@@ -40,44 +43,129 @@
 // read pointers can be updated from within a DMA ISR. Overflows are detectable
 // within a certain number (see tu_fifo_overflow()).
 
+// Single producer / single consumer mode: FIFOs are not mutex protected even
+// with an RTOS. Instead write and read indices are published with release and
+// observed with acquire semantics, which is also safe across cores. Each FIFO
+// must then only be written by one context and read by one context at a time.
+// tu_fifo_clear() and tu_fifo_set_overwritable() require both sides to be idle.
+#ifndef CFG_TUSB_FIFO_SPSC
+#define CFG_TUSB_FIFO_SPSC  0
+#endif
+
+// Usage statistics (peak count, items written/read, overflows, rejected writes)
+// for each FIFO, see tu_fifo_get_stats()
+#ifndef CFG_TUSB_FIFO_STATS
+#define CFG_TUSB_FIFO_STATS 0
+#endif
+
+// Additional readers (taps) per FIFO, each with its own read index, e.g to mirror
+// a stream to a logger. Taps neither block the writer nor the primary reader, a
+// slow tap detects the items it lost. See tu_fifo_tap_read_n()
+#ifndef CFG_TUSB_FIFO_TAP
+#define CFG_TUSB_FIFO_TAP   0
+#endif
+
 // mutex is only needed for RTOS
 // for OS None, we don't get preempted
-#define CFG_FIFO_MUTEX      (CFG_TUSB_OS != OPT_OS_NONE)
+#define CFG_FIFO_MUTEX      ((CFG_TUSB_OS != OPT_OS_NONE) && !CFG_TUSB_FIFO_SPSC)
 
 #include <stdint.h>
 #include <stdbool.h>
+#include <string.h>
+
+#include "common/tusb_compiler.h"
 
 #ifdef __cplusplus
 extern "C" {
 #endif
 
+// Index width: 16-bit indices limit a FIFO to 2^15 items. Enable 32-bit indices
+// for large buffers (e.g elastic buffers in external RAM) of up to 2^31 items.
+#ifndef CFG_TUSB_FIFO_WIDE_INDEX
+#define CFG_TUSB_FIFO_WIDE_INDEX  0
+#endif
+
+#if CFG_TUSB_FIFO_WIDE_INDEX
+typedef uint32_t tu_fifo_idx_t;
+#define TU_FIFO_IDX_MAX     UINT32_MAX
+#else
+typedef uint16_t tu_fifo_idx_t;
+#define TU_FIFO_IDX_MAX     UINT16_MAX
+#endif
+
+// Maximum depth: half of index space, required for overflow detection
+#define TU_FIFO_DEPTH_MAX   ((TU_FIFO_IDX_MAX >> 1) + 1)
+
+// Access to an index owned by the other side (load) or published to it (store)
+#if CFG_TUSB_FIFO_SPSC
+#define tu_fifo_idx_load(_ptr)          TU_ATOMIC_LOAD_ACQUIRE(_ptr)
+#define tu_fifo_idx_store(_ptr, _val)   TU_ATOMIC_STORE_RELEASE(_ptr, _val)
+#else
+#define tu_fifo_idx_load(_ptr)          (*(_ptr))
+#define tu_fifo_idx_store(_ptr, _val)   (*(_ptr) = (_val))
+#endif
+
 #if CFG_FIFO_MUTEX
+#include "osal/osal.h"
 #define tu_fifo_mutex_t  osal_mutex_t
 #endif
 
 
+/** \struct tu_fifo_stats_t
+ * \brief FIFO usage statistics
+ */
+typedef struct
+{
+  tu_fifo_idx_t peak_count     ; ///< maximum number of items in FIFO
+  uint32_t written             ; ///< total items written
+  uint32_t read                ; ///< total items read
+  uint32_t overflows           ; ///< number of writes overwriting unread items
+  uint32_t rejected            ; ///< number of writes not (completely) stored since FIFO was full
+} tu_fifo_stats_t;
+
 /** \struct tu_fifo_t
  * \brief Simple Circular FIFO
  */
 typedef struct
 {
   uint8_t* buffer                        ; ///< buffer pointer
-  uint16_t depth                         ; ///< max items
+  tu_fifo_idx_t depth                    ; ///< max items
   uint16_t item_size                     ; ///< size of each item
   bool overwritable                      ;
 
-  uint16_t max_pointer_idx               ; ///< maximum absolute pointer index
-  uint16_t non_used_index_space          ; ///< required for non-power-of-two buffer length
+  tu_fifo_idx_t max_pointer_idx          ; ///< maximum absolute pointer index
+  tu_fifo_idx_t non_used_index_space     ; ///< required for non-power-of-two buffer length
 
-  volatile uint16_t wr_idx               ; ///< write pointer
-  volatile uint16_t rd_idx               ; ///< read pointer
+  volatile tu_fifo_idx_t wr_idx          ; ///< write pointer
+  volatile tu_fifo_idx_t rd_idx          ; ///< read pointer
+#if CFG_TUSB_FIFO_TAP
+  volatile tu_fifo_idx_t wr_claim        ; ///< end of items being written, used by taps
+  volatile uint8_t clear_count           ; ///< incremented by tu_fifo_clear(), used by taps
+#endif
 
 #if CFG_FIFO_MUTEX
   tu_fifo_mutex_t mutex;
 #endif
 
+#if CFG_TUSB_FIFO_STATS
+  tu_fifo_stats_t stats;
+#endif
+
 } tu_fifo_t;
 
+#if CFG_TUSB_FIFO_TAP
+/** \struct tu_fifo_tap_t
+ * \brief Additional reader of a FIFO
+ */
+typedef struct
+{
+  tu_fifo_t* ff                          ; ///< FIFO tapped
+  tu_fifo_idx_t rd_idx                   ; ///< read pointer of this tap
+  uint8_t clear_count                    ; ///< FIFO clear count seen
+  uint32_t lost                          ; ///< number of items overwritten before this tap read them
+} tu_fifo_tap_t;
+#endif
+
 #define TU_FIFO_INIT(_buffer, _depth, _type, _overwritable) \
 {                                                           \
   .buffer               = _buffer,                          \
@@ -85,16 +173,27 @@ typedef struct
   .item_size            = sizeof(_type),                    \
   .overwritable         = _overwritable,                    \
   .max_pointer_idx      = 2*(_depth)-1,                     \
-  .non_used_index_space = UINT16_MAX - (2*(_depth)-1)       \
+  .non_used_index_space = TU_FIFO_IDX_MAX - (2*(_depth)-1)  \
 }
 
 #define TU_FIFO_DEF(_name, _depth, _type, _overwritable)                      \
     uint8_t _name##_buf[_depth*sizeof(_type)];                                \
     tu_fifo_t _name = TU_FIFO_INIT(_name##_buf, _depth, _type, _overwritable)
 
+/** \struct tu_fifo_buffer_info_t
+ * \brief Linear regions of the FIFO memory, used for zero-copy access
+ */
+typedef struct
+{
+  tu_fifo_idx_t len_lin          ; ///< linear length in items
+  tu_fifo_idx_t len_wrap         ; ///< wrapped length in items
+  void * ptr_lin                 ; ///< linear part start pointer
+  void * ptr_wrap                ; ///< wrapped part start pointer
+} tu_fifo_buffer_info_t;
+
 bool tu_fifo_set_overwritable(tu_fifo_t *f, bool overwritable);
 bool tu_fifo_clear(tu_fifo_t *f);
-bool tu_fifo_config(tu_fifo_t *f, void* buffer, uint16_t depth, uint16_t item_size, bool overwritable);
+bool tu_fifo_config(tu_fifo_t *f, void* buffer, tu_fifo_idx_t depth, uint16_t item_size, bool overwritable);
 
 #if CFG_FIFO_MUTEX
 static inline void tu_fifo_config_mutex(tu_fifo_t *f, tu_fifo_mutex_t mutex_hdl)
@@ -103,37 +202,276 @@ static inline void tu_fifo_config_mutex(tu_fifo_t *f, tu_fifo_mutex_t mutex_hdl)
 }
 #endif
 
-bool     tu_fifo_write                  (tu_fifo_t* f, void const * p_data);
-uint16_t tu_fifo_write_n                (tu_fifo_t* f, void const * p_data, uint16_t count);
+bool          tu_fifo_write                  (tu_fifo_t* f, void const * p_data);
+tu_fifo_idx_t tu_fifo_write_n                (tu_fifo_t* f, void const * p_data, tu_fifo_idx_t count);
 
-bool     tu_fifo_read                   (tu_fifo_t* f, void * p_buffer);
-uint16_t tu_fifo_read_n                 (tu_fifo_t* f, void * p_buffer, uint16_t count);
+bool          tu_fifo_read                   (tu_fifo_t* f, void * p_buffer);
+tu_fifo_idx_t tu_fifo_read_n                 (tu_fifo_t* f, void * p_buffer, tu_fifo_idx_t count);
 
-bool     tu_fifo_peek_at                (tu_fifo_t* f, uint16_t pos, void * p_buffer);
-uint16_t tu_fifo_peek_at_n              (tu_fifo_t* f, uint16_t pos, void * p_buffer, uint16_t n);
+// Transfer to/from a fixed address e.g a 32-bit hardware FIFO register, handles wrap around and
+// lengths not multiple of 4 bytes. Intended to let a DCD move data between a FIFO and hardware directly.
+tu_fifo_idx_t tu_fifo_write_n_const_addr     (tu_fifo_t* f, void const * data, tu_fifo_idx_t count);
+tu_fifo_idx_t tu_fifo_read_n_const_addr      (tu_fifo_t* f, void * buffer, tu_fifo_idx_t count);
 
-uint16_t tu_fifo_count                  (tu_fifo_t* f);
-bool     tu_fifo_empty                  (tu_fifo_t* f);
-bool     tu_fifo_full                   (tu_fifo_t* f);
-uint16_t tu_fifo_remaining              (tu_fifo_t* f);
-bool     tu_fifo_overflowed               (tu_fifo_t* f);
-void     tu_fifo_correct_read_pointer   (tu_fifo_t* f);
+// Multi-channel transfer between several FIFOs (one per channel) and a linear buffer of interleaved
+// samples e.g PCM audio frames. A sample occupies ff_sample_size bytes in a FIFO and sample_size bytes
+// in the buffer, sample sizes of 1 to 4 bytes are copied with word accesses.
+tu_fifo_idx_t tu_fifo_read_n_interleaved     (tu_fifo_t ff[], uint8_t n_ff, void * buffer, tu_fifo_idx_t n_samples, uint8_t ff_sample_size, uint8_t sample_size);
+tu_fifo_idx_t tu_fifo_write_n_interleaved    (tu_fifo_t ff[], uint8_t n_ff, void const * buffer, tu_fifo_idx_t n_samples, uint8_t ff_sample_size, uint8_t sample_size);
+
+bool          tu_fifo_peek_at                (tu_fifo_t* f, tu_fifo_idx_t pos, void * p_buffer);
+tu_fifo_idx_t tu_fifo_peek_at_n              (tu_fifo_t* f, tu_fifo_idx_t pos, void * p_buffer, tu_fifo_idx_t n);
+
+tu_fifo_idx_t tu_fifo_count                  (tu_fifo_t* f);
+bool          tu_fifo_empty                  (tu_fifo_t* f);
+bool          tu_fifo_full                   (tu_fifo_t* f);
+tu_fifo_idx_t tu_fifo_remaining              (tu_fifo_t* f);
+bool          tu_fifo_overflowed             (tu_fifo_t* f);
+void          tu_fifo_correct_read_pointer   (tu_fifo_t* f);
 
 // Pointer modifications intended to be used in combinations with DMAs.
 // USE WITH CARE - NO SAFTY CHECKS CONDUCTED HERE! NOT MUTEX PROTECTED!
-void     tu_fifo_advance_write_pointer  (tu_fifo_t *f, uint16_t n);
-void     tu_fifo_advance_read_pointer   (tu_fifo_t *f, uint16_t n);
+void          tu_fifo_advance_write_pointer  (tu_fifo_t *f, tu_fifo_idx_t n);
+void          tu_fifo_advance_read_pointer   (tu_fifo_t *f, tu_fifo_idx_t n);
+
+// Get the linear regions to read from / write into the FIFO memory directly (e.g by DMA or
+// an endpoint transfer). Commit the processed items with tu_fifo_advance_read_pointer()
+// or tu_fifo_advance_write_pointer() respectively.
+void          tu_fifo_get_read_info          (tu_fifo_t *f, tu_fifo_buffer_info_t *info);
+void          tu_fifo_get_write_info         (tu_fifo_t *f, tu_fifo_buffer_info_t *info);
+
+#if CFG_TUSB_FIFO_TAP
+// Additional lock-free readers: a tap sees the same items as the primary reader unless
+// they were overwritten before the tap read them. A tap is owned by one context and
+// must be re-attached after tu_fifo_config()
+void          tu_fifo_tap_attach             (tu_fifo_tap_t* tap, tu_fifo_t* f);
+tu_fifo_idx_t tu_fifo_tap_count              (tu_fifo_tap_t* tap);
+tu_fifo_idx_t tu_fifo_tap_read_n             (tu_fifo_tap_t* tap, void * buffer, tu_fifo_idx_t count);
+
+static inline uint32_t tu_fifo_tap_lost(tu_fifo_tap_t* tap)
+{
+  return tap->lost;
+}
+#endif
+
+#if CFG_TUSB_FIFO_STATS
+void          tu_fifo_get_stats              (tu_fifo_t *f, tu_fifo_stats_t *stats);
+void          tu_fifo_reset_stats            (tu_fifo_t *f);
+#endif
 
 static inline bool tu_fifo_peek(tu_fifo_t* f, void * p_buffer)
 {
   return tu_fifo_peek_at(f, 0, p_buffer);
 }
 
-static inline uint16_t tu_fifo_depth(tu_fifo_t* f)
+static inline tu_fifo_idx_t tu_fifo_depth(tu_fifo_t* f)
 {
   return f->depth;
 }
 
+//--------------------------------------------------------------------+
+// Typed FIFO
+// Compile-time specialized variant for a constant item type and a power-of-two
+// depth. Indices are free running tu_fifo_idx_t counters, relative positions are
+// obtained by masking and items are copied by assignment, which the compiler
+// can turn into a few loads/stores. Semantics (overwritable mode, overflow
+// correction on read) are the same as the tu_fifo_xxx() counterparts.
+//
+// Typed FIFOs are not mutex protected: they are safe for one producer and one
+// consumer (e.g ISR and task, or two cores with CFG_TUSB_FIFO_SPSC), other
+// usages need external locking.
+//
+// TU_FIFO_TYPED_DECLARE(_name, _type, _depth) generates type _name##_t and
+//   _name##_clear/write/write_n/read/read_n/peek_at/count/empty/full/remaining
+//   (and _name##_get_stats/reset_stats with CFG_TUSB_FIFO_STATS)
+// TU_FIFO_TYPED_DEF(_name, _type, _depth, _overwritable) also defines instance _name
+//
+// e.g TU_FIFO_TYPED_DEF(evt_ff, dcd_event_t, 16, false);
+//     evt_ff_write(&evt_ff, &event);
+//--------------------------------------------------------------------+
+
+#if CFG_TUSB_FIFO_STATS
+// Same accounting as tu_fifo, cnt is the number of items before writing n of requested items
+static inline void tu_fifo_typed_stats_write(tu_fifo_stats_t* stats, tu_fifo_idx_t depth, tu_fifo_idx_t cnt,
+                                             tu_fifo_idx_t n, tu_fifo_idx_t requested)
+{
+  uint32_t level = (uint32_t) cnt + n;
+
+  stats->written += n;
+  if ( n < requested ) stats->rejected++;
+
+  if ( level > depth )
+  {
+    stats->overflows++;
+    level = depth;
+  }
+
+  if ( level > stats->peak_count ) stats->peak_count = (tu_fifo_idx_t) level;
+}
+
+#define _TU_FIFO_TYPED_STATS_MEMBER                  tu_fifo_stats_t stats;
+#define _tu_fifo_typed_stats_write(_f, _depth, _cnt, _n, _requested) \
+  tu_fifo_typed_stats_write(&(_f)->stats, _depth, _cnt, _n, _requested)
+#define _tu_fifo_typed_stats_read(_f, _n)            do { (_f)->stats.read += (_n); } while(0)
+
+#define _TU_FIFO_TYPED_STATS_API(_name)                                                       \
+  static inline void _name##_get_stats(_name##_t* f, tu_fifo_stats_t* stats)                 \
+  {                                                                                           \
+    *stats = f->stats;                                                                        \
+  }                                                                                           \
+                                                                                              \
+  static inline void _name##_reset_stats(_name##_t* f)                                       \
+  {                                                                                           \
+    memset(&f->stats, 0, sizeof(f->stats));                                                   \
+    f->stats.peak_count = _name##_count(f);                                                   \
+  }
+#else
+#define _TU_FIFO_TYPED_STATS_MEMBER
+#define _tu_fifo_typed_stats_write(_f, _depth, _cnt, _n, _requested)
+#define _tu_fifo_typed_stats_read(_f, _n)
+#define _TU_FIFO_TYPED_STATS_API(_name)
+#endif
+
+#define TU_FIFO_TYPED_DECLARE(_name, _type, _depth)                                           \
+  TU_VERIFY_STATIC( (_depth) > 0 && (_depth) <= TU_FIFO_DEPTH_MAX &&                          \
+                    ((_depth) & ((_depth)-1)) == 0,                                           \
+                    "Typed FIFO depth must be a power of two and at most TU_FIFO_DEPTH_MAX"); \
+                                                                                              \
+  typedef struct                                                                              \
+  {                                                                                           \
+    _type buffer[_depth];                                                                     \
+    volatile tu_fifo_idx_t wr_idx;                                                            \
+    volatile tu_fifo_idx_t rd_idx;                                                            \
+    bool overwritable;                                                                        \
+    _TU_FIFO_TYPED_STATS_MEMBER                                                               \
+  } _name##_t;                                                                                \
+                                                                                              \
+  static inline void _name##_clear(_name##_t* f)                                              \
+  {                                                                                           \
+    f->rd_idx = f->wr_idx = 0;                                                                \
+  }                                                                                           \
+                                                                                              \
+  static inline tu_fifo_idx_t _name##_count(_name##_t* f)                                     \
+  {                                                                                           \
+    tu_fifo_idx_t const w = tu_fifo_idx_load(&f->wr_idx);                                     \
+    return (tu_fifo_idx_t) (w - tu_fifo_idx_load(&f->rd_idx));                                \
+  }                                                                                           \
+                                                                                              \
+  static inline bool _name##_empty(_name##_t* f)                                              \
+  {                                                                                           \
+    tu_fifo_idx_t const w = tu_fifo_idx_load(&f->wr_idx);                                     \
+    return w == tu_fifo_idx_load(&f->rd_idx);                                                 \
+  }                                                                                           \
+                                                                                              \
+  static inline bool _name##_full(_name##_t* f)                                               \
+  {                                                                                           \
+    return _name##_count(f) >= (_depth);                                                      \
+  }                                                                                           \
+                                                                                              \
+  static inline tu_fifo_idx_t _name##_remaining(_name##_t* f)                                 \
+  {                                                                                           \
+    tu_fifo_idx_t const cnt = _name##_count(f);                                               \
+    return (cnt >= (_depth)) ? 0 : (tu_fifo_idx_t) ((_depth) - cnt);                          \
+  }                                                                                           \
+                                                                                              \
+  /* Get read index, skip overwritten items in case of an overflow */                         \
+  static inline tu_fifo_idx_t _name##_rd_idx(_name##_t* f, tu_fifo_idx_t w,                   \
+                                             tu_fifo_idx_t* cnt)                              \
+  {                                                                                           \
+    tu_fifo_idx_t r = f->rd_idx;                                                              \
+    *cnt = (tu_fifo_idx_t) (w - r);                                                           \
+    if ( *cnt > (_depth) )                                                                    \
+    {                                                                                         \
+      r = (tu_fifo_idx_t) (w - (_depth));                                                     \
+      *cnt = (_depth);                                                                        \
+      tu_fifo_idx_store(&f->rd_idx, r);                                                       \
+    }                                                                                         \
+    return r;                                                                                 \
+  }                                                                                           \
+                                                                                              \
+  static inline bool _name##_write(_name##_t* f, _type const* data)                           \
+  {                                                                                           \
+    tu_fifo_idx_t const w = f->wr_idx;                                                        \
+    tu_fifo_idx_t const cnt = (tu_fifo_idx_t) (w - tu_fifo_idx_load(&f->rd_idx));             \
+    if ( !f->overwritable && (cnt >= (_depth)) )                                              \
+    {                                                                                         \
+      _tu_fifo_typed_stats_write(f, _depth, cnt, 0, 1);                                       \
+      return false;                                                                           \
+    }                                                                                         \
+    f->buffer[w & ((_depth)-1)] = *data;                                                      \
+    tu_fifo_idx_store(&f->wr_idx, (tu_fifo_idx_t) (w + 1));                                   \
+    _tu_fifo_typed_stats_write(f, _depth, cnt, 1, 1);                                         \
+    return true;                                                                              \
+  }                                                                                           \
+                                                                                              \
+  static inline tu_fifo_idx_t _name##_write_n(_name##_t* f, _type const* data,                \
+                                              tu_fifo_idx_t n)                                \
+  {                                                                                           \
+    tu_fifo_idx_t w = f->wr_idx;                                                              \
+    tu_fifo_idx_t const cnt = (tu_fifo_idx_t) (w - tu_fifo_idx_load(&f->rd_idx));             \
+    tu_fifo_idx_t const requested = n;                                                        \
+    (void) requested;                                                                         \
+    if ( !f->overwritable )                                                                   \
+    {                                                                                         \
+      tu_fifo_idx_t const rem = (cnt >= (_depth)) ? 0 : (tu_fifo_idx_t) ((_depth) - cnt);     \
+      if ( n > rem ) n = rem;                                                                 \
+    }                                                                                         \
+    else if ( n > (_depth) )                                                                  \
+    {                                                                                         \
+      /* Only copy last part, older items would be overwritten anyway */                      \
+      w = (tu_fifo_idx_t) (w + (n - (_depth)));                                               \
+      data += n - (_depth);                                                                   \
+      n = (_depth);                                                                           \
+    }                                                                                         \
+    tu_fifo_idx_t const wRel = w & ((_depth)-1);                                              \
+    tu_fifo_idx_t const nLin = (n < (_depth) - wRel) ? n : (tu_fifo_idx_t) ((_depth) - wRel); \
+    memcpy(&f->buffer[wRel], data, nLin*sizeof(_type));                                       \
+    memcpy(f->buffer, data + nLin, (n - nLin)*sizeof(_type));                                 \
+    tu_fifo_idx_store(&f->wr_idx, (tu_fifo_idx_t) (w + n));                                   \
+    _tu_fifo_typed_stats_write(f, _depth, cnt, n, requested);                                 \
+    return n;                                                                                 \
+  }                                                                                           \
+                                                                                              \
+  static inline bool _name##_peek_at(_name##_t* f, tu_fifo_idx_t pos, _type* data)            \
+  {                                                                                           \
+    tu_fifo_idx_t cnt;                                                                        \
+    tu_fifo_idx_t const r = _name##_rd_idx(f, tu_fifo_idx_load(&f->wr_idx), &cnt);            \
+    if ( pos >= cnt ) return false;                                                           \
+    *data = f->buffer[(tu_fifo_idx_t) (r + pos) & ((_depth)-1)];                              \
+    return true;                                                                              \
+  }                                                                                           \
+                                                                                              \
+  static inline bool _name##_read(_name##_t* f, _type* data)                                  \
+  {                                                                                           \
+    tu_fifo_idx_t cnt;                                                                        \
+    tu_fifo_idx_t const r = _name##_rd_idx(f, tu_fifo_idx_load(&f->wr_idx), &cnt);            \
+    if ( cnt == 0 ) return false;                                                             \
+    *data = f->buffer[r & ((_depth)-1)];                                                      \
+    tu_fifo_idx_store(&f->rd_idx, (tu_fifo_idx_t) (r + 1));                                   \
+    _tu_fifo_typed_stats_read(f, 1);                                                          \
+    return true;                                                                              \
+  }                                                                                           \
+                                                                                              \
+  static inline tu_fifo_idx_t _name##_read_n(_name##_t* f, _type* data, tu_fifo_idx_t n)      \
+  {                                                                                           \
+    tu_fifo_idx_t cnt;                                                                        \
+    tu_fifo_idx_t const r = _name##_rd_idx(f, tu_fifo_idx_load(&f->wr_idx), &cnt);            \
+    if ( n > cnt ) n = cnt;                                                                   \
+    tu_fifo_idx_t const rRel = r & ((_depth)-1);                                              \
+    tu_fifo_idx_t const nLin = (n < (_depth) - rRel) ? n : (tu_fifo_idx_t) ((_depth) - rRel); \
+    memcpy(data, &f->buffer[rRel], nLin*sizeof(_type));                                       \
+    memcpy(data + nLin, f->buffer, (n - nLin)*sizeof(_type));                                 \
+    tu_fifo_idx_store(&f->rd_idx, (tu_fifo_idx_t) (r + n));                                   \
+    _tu_fifo_typed_stats_read(f, n);                                                          \
+    return n;                                                                                 \
+  }                                                                                           \
+                                                                                              \
+  _TU_FIFO_TYPED_STATS_API(_name)
+
+#define TU_FIFO_TYPED_DEF(_name, _type, _depth, _overwritable)                                \
+  TU_FIFO_TYPED_DECLARE(_name, _type, _depth)                                                 \
+  _name##_t _name = { .wr_idx = 0, .rd_idx = 0, .overwritable = _overwritable }
+
 #ifdef __cplusplus
 }
 #endif
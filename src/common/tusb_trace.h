@@ -0,0 +1,131 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2021 Ha Thach (tinyusb.org)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ * This file is part of the TinyUSB stack.
+ */
+
+/** \ingroup Group_Common
+ *  \defgroup Group_Trace Binary trace
+ *  @{ */
+
+#ifndef _TUSB_TRACE_H_
+#define _TUSB_TRACE_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "tusb_option.h"
+#include "tusb_compiler.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+//--------------------------------------------------------------------+
+// Binary trace of the stack hot path: fixed-size timestamped records written to a RAM ring
+// without any formatting, cheap enough to stay enabled while measuring throughput.
+// The ring (tu_trace_ring) is dumped e.g with a debugger and decoded by tools/trace_decode.py
+//--------------------------------------------------------------------+
+
+// Enable binary trace
+#ifndef CFG_TUSB_TRACE
+  #define CFG_TUSB_TRACE        0
+#endif
+
+// Number of records kept in the ring, older ones are overwritten
+#ifndef CFG_TUSB_TRACE_DEPTH
+  #define CFG_TUSB_TRACE_DEPTH  256
+#endif
+
+// Marks start of the ring in a memory dump: "TUTR"
+#define TU_TRACE_MAGIC          0x52545554UL
+
+// Record ID. Keep in sync with tools/trace_decode.py
+typedef enum
+{
+  TU_TRACE_NONE = 0,
+  TU_TRACE_EVENT_ISR,      // dcd event queued      : arg8 = event id, addr = endpoint/bRequest, arg32 = length/wLength
+  TU_TRACE_EVENT_TASK,     // event popped by task  : same as TU_TRACE_EVENT_ISR
+  TU_TRACE_XFER_SUBMIT,    // usbd_edpt_xfer*()     : addr = endpoint, arg8 = tu_trace_xfer_kind_t, arg32 = length
+  TU_TRACE_XFER_CB_DONE,   // class xfer_cb returned: addr = endpoint, arg8 = result, arg32 = length
+  TU_TRACE_CONTROL_STAGE,  // control stage reached: addr = bRequest, arg8 = stage, arg32 = wLength (setup) or transferred bytes
+  TU_TRACE_USER,           // application defined
+}tu_trace_id_t;
+
+// Kind of submitted transfer
+typedef enum
+{
+  TU_TRACE_XFER_BUFFER = 0, // usbd_edpt_xfer()
+  TU_TRACE_XFER_SG,         // usbd_edpt_xfer_sg() handled by dcd
+  TU_TRACE_XFER_FIFO,       // usbd_edpt_xfer_fifo()
+}tu_trace_xfer_kind_t;
+
+typedef struct
+{
+  uint32_t timestamp; // tusb_trace_timestamp_cb(), 0 if not implemented
+  uint8_t  id;        // tu_trace_id_t
+  uint8_t  rhport;
+  uint8_t  addr;
+  uint8_t  arg8;
+  uint32_t arg32;
+}tu_trace_rec_t;
+
+TU_VERIFY_STATIC(sizeof(tu_trace_rec_t) == 12, "trace record layout is fixed for the decoder");
+
+typedef struct
+{
+  uint32_t magic;             // TU_TRACE_MAGIC
+  uint16_t depth;             // number of records
+  uint16_t rec_size;          // sizeof(tu_trace_rec_t)
+  volatile uint32_t wr_count; // total records written, next one goes to rec[wr_count % depth]
+  tu_trace_rec_t rec[CFG_TUSB_TRACE_DEPTH];
+}tu_trace_ring_t;
+
+#if CFG_TUSB_TRACE
+
+extern tu_trace_ring_t tu_trace_ring;
+
+// Timestamp of records e.g a cycle counter or free running us timer, implemented by application.
+// Must be callable from interrupt.
+uint32_t tusb_trace_timestamp_cb(void) TU_ATTR_WEAK;
+
+// Write a record, callable from interrupt and thread context
+void tu_trace_write(uint8_t id, uint8_t rhport, uint8_t addr, uint8_t arg8, uint32_t arg32);
+
+// Discard all records
+void tu_trace_clear(void);
+
+#define TU_TRACE(_id, _rhport, _addr, _arg8, _arg32)   tu_trace_write(_id, _rhport, _addr, _arg8, _arg32)
+
+#else
+
+#define TU_TRACE(_id, _rhport, _addr, _arg8, _arg32)
+
+#endif
+
+#ifdef __cplusplus
+ }
+#endif
+
+#endif /* _TUSB_TRACE_H_ */
+
+/** @} */
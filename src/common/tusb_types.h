@@ -226,6 +226,13 @@ typedef enum
   XFER_RESULT_STALLED,
 }xfer_result_t;
 
+// A segment of scatter-gather transfer
+typedef struct
+{
+  uint8_t* buffer;
+  uint16_t len;
+}tusb_xfer_seg_t;
+
 enum // TODO remove
 {
   DESC_OFFSET_LEN  = 0,
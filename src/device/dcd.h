@@ -32,6 +32,7 @@
 #define _TUSB_DCD_H_
 
 #include "common/tusb_common.h"
+#include "common/tusb_fifo.h"
 
 #ifdef __cplusplus
  extern "C" {
@@ -67,6 +68,11 @@ typedef struct TU_ATTR_ALIGNED(4)
       tusb_speed_t speed;
     } bus_reset;
 
+    // SOF
+    struct {
+      uint32_t count; // number of SOFs coalesced into this event, filled in by usbd
+    }sof;
+
     // SETUP_RECEIVED
     tusb_control_request_t setup_received;
 
@@ -115,6 +121,11 @@ void dcd_connect(uint8_t rhport) TU_ATTR_WEAK;
 // Disconnect by disabling internal pull-up resistor on D+/D-
 void dcd_disconnect(uint8_t rhport) TU_ATTR_WEAK;
 
+// Enable/Disable Start-of-frame interrupt, SOF should be disabled after dcd_init().
+// Invoked by usbd with dcd interrupt disabled. Ports without it keep SOF as is, and
+// unneeded SOF events are dropped by usbd.
+void dcd_sof_enable(uint8_t rhport, bool en) TU_ATTR_WEAK;
+
 //--------------------------------------------------------------------+
 // Endpoint API
 //--------------------------------------------------------------------+
@@ -133,6 +144,17 @@ void dcd_edpt_close        (uint8_t rhport, uint8_t ep_addr) TU_ATTR_WEAK;
 // Submit a transfer, When complete dcd_event_xfer_complete() is invoked to notify the stack
 bool dcd_edpt_xfer        (uint8_t rhport, uint8_t ep_addr, uint8_t * buffer, uint16_t total_bytes);
 
+// Submit a scatter-gather transfer: segments are one transfer, packets may span segment boundaries.
+// Total length is the 32-bit sum of segment lengths, it can exceed 64 KB.
+// Segment array must stay valid until complete. This API is optional, usbd falls back to a bounce buffer.
+bool dcd_edpt_xfer_sg     (uint8_t rhport, uint8_t ep_addr, tusb_xfer_seg_t const * segs, uint8_t count) TU_ATTR_WEAK;
+
+// Submit a transfer where data is moved directly between hardware and a FIFO: OUT data is written to
+// and IN data is read from ff, DCD must handle its wrap around. Not used on control endpoint.
+// IN total_bytes does not exceed data in ff. OUT data that does not fit into ff must fail the transfer.
+// This API is optional, usbd_edpt_xfer_fifo() fails without it.
+bool dcd_edpt_xfer_fifo   (uint8_t rhport, uint8_t ep_addr, tu_fifo_t * ff, uint16_t total_bytes) TU_ATTR_WEAK;
+
 // Stall endpoint
 void dcd_edpt_stall       (uint8_t rhport, uint8_t ep_addr);
 
@@ -37,13 +37,77 @@
 #define CFG_TUD_TASK_QUEUE_SZ   16
 #endif
 
+// Max number of events tud_task() pops from the queue at once (OPT_OS_NONE only)
+#ifndef CFG_TUD_TASK_EVENT_BATCH
+#define CFG_TUD_TASK_EVENT_BATCH  4
+#endif
+
+// Depth of the high priority event lane, which tud_task() always services first: setup,
+// bus signals and transfer complete of control and high priority (default iso & interrupt)
+// endpoints. 0 disables the lane, all events are then processed in arrival order.
+#ifndef CFG_TUD_TASK_HIGH_QUEUE_SZ
+#define CFG_TUD_TASK_HIGH_QUEUE_SZ  0
+#endif
+
 #ifndef CFG_TUD_EP_MAX
 #define CFG_TUD_EP_MAX          9
 #endif
 
+// Max number of SOF subscribers registered with usbd_sof_subscribe(), including tud_sof_cb()
+#ifndef CFG_TUD_SOF_SUBSCRIBER_MAX
+#define CFG_TUD_SOF_SUBSCRIBER_MAX  4
+#endif
+
+// Number of transfers that can be queued on a non-control endpoint behind the one in progress.
+// Queued transfer is started by the transfer complete interrupt, therefore the DCD must accept
+// dcd_edpt_xfer() from its interrupt handler. 0 allows only one transfer per endpoint.
+#ifndef CFG_TUD_EDPT_XFER_QUEUE_SZ
+#define CFG_TUD_EDPT_XFER_QUEUE_SZ  0
+#endif
+
+// Max length handed to dcd_edpt_xfer() at once. Longer usbd_edpt_xfer() is split into chunks of
+// this size, next chunk is started by the transfer complete interrupt and usbd task is notified
+// once the whole transfer is done. Must be a multiple of all endpoints' packet size.
+#ifndef CFG_TUD_EDPT_XFER_CHUNK_SIZE
+#define CFG_TUD_EDPT_XFER_CHUNK_SIZE  0xFC00 // 63 KB
+#endif
+
+TU_VERIFY_STATIC(CFG_TUD_EDPT_XFER_CHUNK_SIZE <= UINT16_MAX, "dcd_edpt_xfer() length is 16-bit");
+
+// dcd_edpt_xfer_fifo() accesses class drivers' FIFOs in interrupt context, they can't be mutex protected
+#if CFG_TUD_EDPT_XFER_FIFO && CFG_FIFO_MUTEX
+  #error "CFG_TUD_EDPT_XFER_FIFO requires lock-free FIFOs, enable CFG_TUSB_FIFO_SPSC"
+#endif
+
+// Bounce buffers for usbd_edpt_xfer_sg() on DCD without dcd_edpt_xfer_sg(): max total size of a
+// scatter-gather transfer and number of them in progress at the same time. 0 size disables bounce.
+#ifndef CFG_TUD_XFER_SG_BOUNCE_SIZE
+#define CFG_TUD_XFER_SG_BOUNCE_SIZE   0
+#endif
+
+#ifndef CFG_TUD_XFER_SG_BOUNCE_COUNT
+#define CFG_TUD_XFER_SG_BOUNCE_COUNT  2
+#endif
+
+// Scale of endpoint statistics' latency histogram: first bucket counts latency below 2^shift
+#ifndef CFG_TUD_EDPT_STATS_HIST_SHIFT
+#define CFG_TUD_EDPT_STATS_HIST_SHIFT  0
+#endif
+
+// bRequest of vendor device request reading endpoint statistics as tud_edpt_stats_t. Direction IN,
+// wIndex = endpoint address, wValue = 1 to reset them after reading. Handled by usbd before
+// tud_vendor_control_xfer_cb(), 0 disables the request.
+#ifndef CFG_TUD_EDPT_STATS_REQUEST
+#define CFG_TUD_EDPT_STATS_REQUEST     0
+#endif
+
 //--------------------------------------------------------------------+
 // Device Data
 //--------------------------------------------------------------------+
+
+// Interface numbers supported in a configuration
+#define USBD_ITF_MAX    16
+
 typedef struct
 {
   struct TU_ATTR_PACKED
@@ -60,25 +124,174 @@ typedef struct
   volatile uint8_t cfg_num; // current active configuration (0x00 is not configured)
   uint8_t speed;
 
-  uint8_t itf2drv[16];     // map interface number to driver (0xff is invalid)
+  uint8_t itf2drv[USBD_ITF_MAX]; // map interface number to driver (0xff is invalid)
   uint8_t ep2drv[CFG_TUD_EP_MAX][2]; // map endpoint to driver ( 0xff is invalid )
 
+  // Index of current configuration descriptor, built by SET_CONFIGURATION before drivers are opened
+  uint8_t const* cfg_desc;
+  struct
+  {
+    uint16_t offset;       // alternate setting 0 descriptor in cfg_desc (0 is invalid)
+    uint16_t len;          // all alternate settings including class & endpoint descriptors
+    uint8_t  alt_count;
+  }itf_index[USBD_ITF_MAX];
+  uint8_t ep2itf[CFG_TUD_EP_MAX][2]; // map endpoint to interface number ( 0xff is invalid )
+
   struct TU_ATTR_PACKED
   {
     volatile bool busy    : 1;
     volatile bool stalled : 1;
     volatile bool claimed : 1;
+    volatile bool high_prio : 1; // complete event is queued in high priority lane
 
     // TODO merge ep2drv here, 4-bit should be sufficient
   }ep_status[CFG_TUD_EP_MAX][2];
 
+  // Transfer longer than CFG_TUD_EDPT_XFER_CHUNK_SIZE, continued in dcd_event_handler()
+  struct
+  {
+    uint8_t* buffer;
+    tu_fifo_t* ff;        // FIFO transfer (usbd_edpt_xfer_fifo), buffer is unused
+    uint32_t total_bytes; // 0 if transfer is not split
+    uint32_t xferred;     // length of completed chunks
+  }xfer_split[CFG_TUD_EP_MAX][2];
+
+#if CFG_TUD_EDPT_XFER_QUEUE_SZ
+  // Transfers submitted while endpoint is busy. Pushed by usbd_edpt_xfer() with dcd interrupt
+  // disabled, popped by transfer complete in dcd_event_handler()
+  struct
+  {
+    struct
+    {
+      uint8_t* buffer;
+      uint32_t total_bytes;
+    }xfer[CFG_TUD_EDPT_XFER_QUEUE_SZ];
+
+    volatile uint8_t rd_idx;
+    volatile uint8_t count;    // queued, not started yet
+    volatile uint8_t inflight; // submitted, complete not processed by usbd task yet
+    volatile bool    active;   // a transfer is owned by dcd
+  }xfer_q[CFG_TUD_EP_MAX][2];
+#endif
+
+#if CFG_TUD_EDPT_ISR_CB
+  usbd_edpt_isr_cb_t isr_cb[CFG_TUD_EP_MAX][2]; // complete in dcd interrupt context if not NULL
+  volatile bool in_isr_cb;                      // an isr_cb is running, dcd interrupt is masked
+#endif
+
+#if CFG_TUD_EDPT_STATS
+  struct
+  {
+    tud_edpt_stats_t stats;
+    uint32_t start_time;  // current transfer handed to dcd
+    uint32_t idle_since;  // last transfer complete
+    bool     idle;        // no transfer since idle_since
+  }ep_stats[CFG_TUD_EP_MAX][2];
+#endif
+
 }usbd_device_t;
 
-static usbd_device_t _usbd_dev;
+// One device stack per device rhport
+static usbd_device_t _usbd_dev[TUD_OPT_RHPORT_COUNT];
+
+static inline usbd_device_t* get_dev(uint8_t rhport)
+{
+  return &_usbd_dev[usbd_rhport_idx(rhport)];
+}
+
+// Endpoint API is called from an ISR-direct callback (CFG_TUD_EDPT_ISR_CB)
+static inline bool edpt_in_isr(usbd_device_t const* dev)
+{
+#if CFG_TUD_EDPT_ISR_CB
+  return dev->in_isr_cb;
+#else
+  (void) dev;
+  return false;
+#endif
+}
+
+// Mask dcd interrupt to update endpoint state shared with dcd_event_handler(), nothing to do
+// when already running in dcd interrupt
+static inline void edpt_int_disable(usbd_device_t const* dev, uint8_t rhport)
+{
+  if ( !edpt_in_isr(dev) ) dcd_int_disable(rhport);
+}
+
+static inline void edpt_int_enable(usbd_device_t const* dev, uint8_t rhport)
+{
+  if ( !edpt_in_isr(dev) ) dcd_int_enable(rhport);
+}
+
+// Transfer logging, skipped in dcd interrupt context
+#define EDPT_LOG2(_dev, ...)  do { if ( !edpt_in_isr(_dev) ) { TU_LOG2(__VA_ARGS__); } } while(0)
+
+// rhport of a per-port state index
+static inline uint8_t idx_rhport(uint8_t idx)
+{
+#if TUD_OPT_RHPORT_COUNT > 1
+  return idx;
+#else
+  (void) idx;
+  return TUD_OPT_RHPORT;
+#endif
+}
 
 // Invalid driver ID in itf2drv[] ep2drv[][] mapping
 enum { DRVID_INVALID = 0xFFu };
 
+// Invalid interface number in ep2itf[][] mapping
+enum { ITF_INVALID = 0xFFu };
+
+#if CFG_TUD_XFER_SG_BOUNCE_SIZE
+// Bounce buffer of a scatter-gather transfer, segments are gathered before IN transfer and
+// scattered after OUT transfer is complete
+typedef struct
+{
+  uint8_t rhport;
+  uint8_t ep_addr; // 0 is free, control endpoint does not use scatter-gather
+  uint8_t count;
+  tusb_xfer_seg_t const * segs;
+}sg_bounce_t;
+
+static sg_bounce_t _sg_bounce[CFG_TUD_XFER_SG_BOUNCE_COUNT];
+
+CFG_TUSB_MEM_SECTION CFG_TUSB_MEM_ALIGN
+static uint8_t _sg_bounce_buf[CFG_TUD_XFER_SG_BOUNCE_COUNT][CFG_TUD_XFER_SG_BOUNCE_SIZE];
+
+static sg_bounce_t* sg_bounce_find(uint8_t rhport, uint8_t ep_addr)
+{
+  for(uint8_t i=0; i<CFG_TUD_XFER_SG_BOUNCE_COUNT; i++)
+  {
+    // free buffer can be used by any port
+    if ( _sg_bounce[i].ep_addr == ep_addr && (ep_addr == 0 || _sg_bounce[i].rhport == rhport) ) return &_sg_bounce[i];
+  }
+
+  return NULL;
+}
+
+// Scatter received data (if OUT) to segments and free the bounce buffer
+static void sg_bounce_complete(uint8_t rhport, uint8_t ep_addr, uint32_t xferred_bytes)
+{
+  sg_bounce_t* bounce = sg_bounce_find(rhport, ep_addr);
+  if ( !bounce ) return;
+
+  if ( tu_edpt_dir(ep_addr) == TUSB_DIR_OUT )
+  {
+    uint8_t const* src = _sg_bounce_buf[bounce - _sg_bounce];
+
+    for(uint8_t i=0; i<bounce->count && xferred_bytes; i++)
+    {
+      uint16_t const n = (uint16_t) tu_min32(bounce->segs[i].len, xferred_bytes);
+      memcpy(bounce->segs[i].buffer, src, n);
+      src += n;
+      xferred_bytes -= n;
+    }
+  }
+
+  bounce->ep_addr = 0;
+}
+#endif
+
 //--------------------------------------------------------------------+
 // Class Driver
 //--------------------------------------------------------------------+
@@ -241,10 +454,63 @@ static inline usbd_class_driver_t const * get_driver(uint8_t drvid)
 // DCD Event
 //--------------------------------------------------------------------+
 
-// Event queue
-// OPT_MODE_DEVICE is used by OS NONE for mutex (disable usb isr)
-OSAL_QUEUE_DEF(OPT_MODE_DEVICE, _usbd_qdef, CFG_TUD_TASK_QUEUE_SZ, dcd_event_t);
-static osal_queue_t _usbd_q;
+// Event queue, one per device rhport so that each has a single producer (its ISR)
+// OPT_MODE_DEVICE and rhport are used by OS NONE for mutex (disable usb isr)
+OSAL_QUEUE_DEF_RHPORT(OPT_MODE_DEVICE, TUD_OPT_RHPORT, _usbd_qdef, CFG_TUD_TASK_QUEUE_SZ, dcd_event_t);
+#if TUD_OPT_RHPORT_COUNT > 1
+OSAL_QUEUE_DEF_RHPORT(OPT_MODE_DEVICE, 1, _usbd_qdef1, CFG_TUD_TASK_QUEUE_SZ, dcd_event_t);
+#endif
+static osal_queue_t _usbd_q[TUD_OPT_RHPORT_COUNT];
+
+#if CFG_TUD_TASK_HIGH_QUEUE_SZ
+// High priority lane
+OSAL_QUEUE_DEF_RHPORT(OPT_MODE_DEVICE, TUD_OPT_RHPORT, _usbd_qdef_hi, CFG_TUD_TASK_HIGH_QUEUE_SZ, dcd_event_t);
+#if TUD_OPT_RHPORT_COUNT > 1
+OSAL_QUEUE_DEF_RHPORT(OPT_MODE_DEVICE, 1, _usbd_qdef1_hi, CFG_TUD_TASK_HIGH_QUEUE_SZ, dcd_event_t);
+#endif
+static osal_queue_t _usbd_q_hi[TUD_OPT_RHPORT_COUNT];
+
+#if CFG_TUSB_OS != OPT_OS_NONE
+// A wake-up event is pending in the normal lane, at most one at a time
+static volatile bool _usbd_wakeup_pending[TUD_OPT_RHPORT_COUNT];
+#endif
+#endif
+
+enum
+{
+  LANE_NORMAL = 0,
+  LANE_HIGH,
+  LANE_COUNT
+};
+
+// Event accounting: written by the producer (ISR) except received[] which is written by tud_task().
+// Pending events of a lane is sent - received, so that neither side needs a lock.
+static struct
+{
+  volatile uint32_t sent[LANE_COUNT];
+  volatile uint32_t received[LANE_COUNT];
+  uint16_t peak[LANE_COUNT];
+
+  uint32_t dropped;
+  uint32_t coalesced;
+  uint32_t sent_base; // sum of sent[] at last reset
+}_usbd_qstat[TUD_OPT_RHPORT_COUNT];
+
+// SOF subscribers and coalescing. SOF interrupt is only enabled while there is a subscriber or
+// a class driver implementing sof(). Only one SOF event is pending in the queue at a time, SOFs
+// arriving meanwhile are counted by the ISR in merged and picked up by tud_task() with merged_taken.
+static bool _usbd_driver_sof; // any class driver implements sof()
+
+static struct
+{
+  usbd_sof_cb_t subscriber[CFG_TUD_SOF_SUBSCRIBER_MAX];
+  uint8_t subscriber_count;
+  volatile bool enabled;   // SOF is forwarded by dcd_event_handler()
+
+  volatile bool pending;
+  volatile uint32_t merged;
+  uint32_t merged_taken;
+}_usbd_sof[TUD_OPT_RHPORT_COUNT];
 
 // Mutex for claiming endpoint, only needed when using with preempted RTOS
 #if CFG_TUSB_OS != OPT_OS_NONE
@@ -257,14 +523,23 @@ static osal_mutex_t _usbd_mutex;
 // Prototypes
 //--------------------------------------------------------------------+
 static void mark_interface_endpoint(uint8_t ep2drv[][2], uint8_t const* p_desc, uint16_t desc_len, uint8_t driver_id);
+static bool build_config_index(usbd_device_t* dev, tusb_desc_configuration_t const * desc_cfg);
+static void process_event(dcd_event_t const * event);
+static void edpt_xfer_done(usbd_device_t* dev, uint8_t rhport, uint8_t ep_addr, uint32_t xferred_bytes);
+static void sof_enable_update(uint8_t rhport);
 static bool process_control_request(uint8_t rhport, tusb_control_request_t const * p_request);
 static bool process_set_config(uint8_t rhport, uint8_t cfg_num);
 static bool process_get_descriptor(uint8_t rhport, tusb_control_request_t const * p_request);
 
+#if CFG_TUD_TIMER
+static uint32_t timer_wait_ms(uint8_t idx, uint32_t timeout_ms);
+static void timer_fire_ms(uint8_t idx);
+#endif
+
 // from usbd_control.c
-void usbd_control_reset(void);
-void usbd_control_set_request(tusb_control_request_t const *request);
-void usbd_control_set_complete_callback( usbd_control_xfer_cb_t fp );
+void usbd_control_reset(uint8_t rhport);
+void usbd_control_set_request(uint8_t rhport, tusb_control_request_t const *request);
+void usbd_control_set_complete_callback(uint8_t rhport, usbd_control_xfer_cb_t fp );
 bool usbd_control_xfer_cb (uint8_t rhport, uint8_t ep_addr, xfer_result_t event, uint32_t xferred_bytes);
 
 
@@ -318,49 +593,131 @@ void usbd_driver_print_control_complete_name(usbd_control_xfer_cb_t callback)
 
 #endif
 
+#if CFG_TUSB_TRACE
+// Record an event with its endpoint/length (xfer complete) or bRequest/wLength (setup)
+static void trace_event(uint8_t trace_id, dcd_event_t const * event)
+{
+  uint8_t  addr = 0;
+  uint32_t len  = 0;
+
+  if ( event->event_id == DCD_EVENT_XFER_COMPLETE )
+  {
+    addr = event->xfer_complete.ep_addr;
+    len  = event->xfer_complete.len;
+  }
+  else if ( event->event_id == DCD_EVENT_SETUP_RECEIVED )
+  {
+    addr = event->setup_received.bRequest;
+    len  = event->setup_received.wLength;
+  }
+
+  tu_trace_write(trace_id, event->rhport, addr, event->event_id, len);
+}
+
+#define TRACE_EVENT(_id, _event)  trace_event(_id, _event)
+#else
+#define TRACE_EVENT(_id, _event)
+#endif
+
 //--------------------------------------------------------------------+
 // Application API
 //--------------------------------------------------------------------+
+tusb_speed_t tud_speed_get_rhport(uint8_t rhport)
+{
+  return (tusb_speed_t) get_dev(rhport)->speed;
+}
+
+bool tud_connected_rhport(uint8_t rhport)
+{
+  return get_dev(rhport)->connected;
+}
+
+bool tud_mounted_rhport(uint8_t rhport)
+{
+  return get_dev(rhport)->cfg_num ? true : false;
+}
+
+bool tud_suspended_rhport(uint8_t rhport)
+{
+  return get_dev(rhport)->suspended;
+}
+
+bool tud_remote_wakeup_rhport(uint8_t rhport)
+{
+  usbd_device_t const* dev = get_dev(rhport);
+
+  // only wake up host if this feature is supported and enabled and we are suspended
+  TU_VERIFY (dev->suspended && dev->remote_wakeup_support && dev->remote_wakeup_en );
+  dcd_remote_wakeup(rhport);
+  return true;
+}
+
+bool tud_disconnect_rhport(uint8_t rhport)
+{
+  TU_VERIFY(dcd_disconnect);
+  dcd_disconnect(rhport);
+  return true;
+}
+
+bool tud_connect_rhport(uint8_t rhport)
+{
+  TU_VERIFY(dcd_connect);
+  dcd_connect(rhport);
+  return true;
+}
+
 tusb_speed_t tud_speed_get(void)
 {
-  return (tusb_speed_t) _usbd_dev.speed;
+  return tud_speed_get_rhport(TUD_OPT_RHPORT);
 }
 
 bool tud_connected(void)
 {
-  return _usbd_dev.connected;
+  return tud_connected_rhport(TUD_OPT_RHPORT);
 }
 
 bool tud_mounted(void)
 {
-  return _usbd_dev.cfg_num ? true : false;
+  return tud_mounted_rhport(TUD_OPT_RHPORT);
 }
 
 bool tud_suspended(void)
 {
-  return _usbd_dev.suspended;
+  return tud_suspended_rhport(TUD_OPT_RHPORT);
 }
 
 bool tud_remote_wakeup(void)
 {
-  // only wake up host if this feature is supported and enabled and we are suspended
-  TU_VERIFY (_usbd_dev.suspended && _usbd_dev.remote_wakeup_support && _usbd_dev.remote_wakeup_en );
-  dcd_remote_wakeup(TUD_OPT_RHPORT);
-  return true;
+  return tud_remote_wakeup_rhport(TUD_OPT_RHPORT);
 }
 
 bool tud_disconnect(void)
 {
-  TU_VERIFY(dcd_disconnect);
-  dcd_disconnect(TUD_OPT_RHPORT);
-  return true;
+  return tud_disconnect_rhport(TUD_OPT_RHPORT);
 }
 
 bool tud_connect(void)
 {
-  TU_VERIFY(dcd_connect);
-  dcd_connect(TUD_OPT_RHPORT);
-  return true;
+  return tud_connect_rhport(TUD_OPT_RHPORT);
+}
+
+static void app_sof_cb(uint8_t rhport, uint32_t sof_count)
+{
+  (void) rhport;
+  if (tud_sof_cb) tud_sof_cb(sof_count);
+}
+
+bool tud_sof_cb_enable(bool en)
+{
+  if ( en )
+  {
+    return usbd_sof_subscribe(TUD_OPT_RHPORT, app_sof_cb);
+  }
+  else
+  {
+    usbd_sof_unsubscribe(TUD_OPT_RHPORT, app_sof_cb);
+    return true;
+  }
 }
 
 //--------------------------------------------------------------------+
@@ -372,6 +729,15 @@ bool tud_init (void)
 
   tu_varclr(&_usbd_dev);
 
+#if TUD_OPT_RHPORT_COUNT > 1
+  // no driver is bound to a port yet, so that first bus reset of one port does not reset
+  // drivers already in use by the other port
+  for (uint8_t idx = 0; idx < TUD_OPT_RHPORT_COUNT; idx++)
+  {
+    memset(_usbd_dev[idx].itf2drv, DRVID_INVALID, sizeof(_usbd_dev[idx].itf2drv));
+  }
+#endif
+
 #if CFG_TUSB_OS != OPT_OS_NONE
   // Init device mutex
   _usbd_mutex = osal_mutex_create(&_ubsd_mutexdef);
@@ -379,8 +745,25 @@ bool tud_init (void)
 #endif
 
   // Init device queue & task
-  _usbd_q = osal_queue_create(&_usbd_qdef);
-  TU_ASSERT(_usbd_q);
+  _usbd_q[0] = osal_queue_create(&_usbd_qdef);
+#if TUD_OPT_RHPORT_COUNT > 1
+  _usbd_q[1] = osal_queue_create(&_usbd_qdef1);
+#endif
+
+#if CFG_TUD_TASK_HIGH_QUEUE_SZ
+  _usbd_q_hi[0] = osal_queue_create(&_usbd_qdef_hi);
+#if TUD_OPT_RHPORT_COUNT > 1
+  _usbd_q_hi[1] = osal_queue_create(&_usbd_qdef1_hi);
+#endif
+#endif
+
+  for (uint8_t idx = 0; idx < TUD_OPT_RHPORT_COUNT; idx++)
+  {
+    TU_ASSERT(_usbd_q[idx]);
+#if CFG_TUD_TASK_HIGH_QUEUE_SZ
+    TU_ASSERT(_usbd_q_hi[idx]);
+#endif
+  }
 
   // Get application driver if available
   if ( usbd_app_driver_get_cb )
@@ -394,26 +777,53 @@ bool tud_init (void)
     usbd_class_driver_t const * driver = get_driver(i);
     TU_LOG2("%s init\r\n", driver->name);
     driver->init();
+
+    if ( driver->sof ) _usbd_driver_sof = true;
   }
 
-  // Init device controller driver
-  dcd_init(TUD_OPT_RHPORT);
-  dcd_int_enable(TUD_OPT_RHPORT);
+  // Init device controller drivers
+  for (uint8_t idx = 0; idx < TUD_OPT_RHPORT_COUNT; idx++)
+  {
+    uint8_t const rhport = idx_rhport(idx);
+    dcd_init(rhport);
+    dcd_int_enable(rhport);
+    sof_enable_update(rhport);
+  }
 
   return true;
 }
 
 static void usbd_reset(uint8_t rhport)
 {
-  tu_varclr(&_usbd_dev);
+  usbd_device_t* dev = get_dev(rhport);
+
+#if TUD_OPT_RHPORT_COUNT > 1
+  // Class drivers are shared by both ports, only reset the ones having interfaces on this port
+  uint8_t itf2drv[sizeof(dev->itf2drv)];
+  memcpy(itf2drv, dev->itf2drv, sizeof(itf2drv));
+#endif
+
+  tu_varclr(dev);
+
+#if CFG_TUD_XFER_SG_BOUNCE_SIZE
+  for(uint8_t i=0; i<CFG_TUD_XFER_SG_BOUNCE_COUNT; i++)
+  {
+    if ( _sg_bounce[i].rhport == rhport ) _sg_bounce[i].ep_addr = 0;
+  }
+#endif
 
-  memset(_usbd_dev.itf2drv, DRVID_INVALID, sizeof(_usbd_dev.itf2drv)); // invalid mapping
-  memset(_usbd_dev.ep2drv , DRVID_INVALID, sizeof(_usbd_dev.ep2drv )); // invalid mapping
+  memset(dev->itf2drv, DRVID_INVALID, sizeof(dev->itf2drv)); // invalid mapping
+  memset(dev->ep2drv , DRVID_INVALID, sizeof(dev->ep2drv )); // invalid mapping
+  memset(dev->ep2itf , ITF_INVALID  , sizeof(dev->ep2itf )); // invalid mapping
 
-  usbd_control_reset();
+  usbd_control_reset(rhport);
 
   for ( uint8_t i = 0; i < TOTAL_DRIVER_COUNT; i++ )
   {
+#if TUD_OPT_RHPORT_COUNT > 1
+    if ( !memchr(itf2drv, i, sizeof(itf2drv)) ) continue;
+#endif
+
     get_driver(i)->reset(rhport);
   }
 }
@@ -423,140 +833,398 @@ bool tud_task_event_ready(void)
   // Skip if stack is not initialized
   if ( !tusb_inited() ) return false;
 
-  return !osal_queue_empty(_usbd_q);
-}
+  for ( uint8_t idx = 0; idx < TUD_OPT_RHPORT_COUNT; idx++ )
+  {
+#if CFG_TUD_TASK_HIGH_QUEUE_SZ
+    if ( !osal_queue_empty(_usbd_q_hi[idx]) ) return true;
+#endif
 
-/* USB Device Driver task
- * This top level thread manages all device controller event and delegates events to class-specific drivers.
- * This should be called periodically within the mainloop or rtos thread.
- *
-   @code
-    int main(void)
-    {
-      application_init();
-      tusb_init();
+    if ( !osal_queue_empty(_usbd_q[idx]) ) return true;
+  }
 
-      while(1) // the mainloop
-      {
-        application_code();
-        tud_task(); // tinyusb device task
-      }
-    }
-    @endcode
- */
-void tud_task (void)
+  return false;
+}
+
+// Pop up to max_count events of one lane of a port
+static uint16_t lane_receive(uint8_t idx, uint8_t lane, dcd_event_t* events, uint16_t max_count, uint32_t msec)
 {
-  // Skip if stack is not initialized
-  if ( !tusb_inited() ) return;
+#if CFG_TUD_TASK_HIGH_QUEUE_SZ
+  osal_queue_t const q = (lane == LANE_HIGH) ? _usbd_q_hi[idx] : _usbd_q[idx];
+#else
+  osal_queue_t const q = _usbd_q[idx];
+#endif
 
-  // Loop until there is no more events in the queue
-  while (1)
+#if CFG_TUSB_OS == OPT_OS_NONE
+  (void) msec;
+  uint16_t const count = osal_queue_receive_n(q, events, max_count);
+#else
+  (void) max_count;
+  uint16_t const count = osal_queue_receive_timeout(q, events, msec) ? 1 : 0;
+#endif
+
+  _usbd_qstat[idx].received[lane] += count;
+
+  for(uint16_t i = 0; i < count; i++)
   {
-    dcd_event_t event;
+    if ( events[i].event_id == DCD_EVENT_SOF )
+    {
+      // Clear pending before collecting merged SOFs: one arriving later is queued as a new event
+      _usbd_sof[idx].pending = false;
+
+      uint32_t const merged = _usbd_sof[idx].merged;
+      events[i].sof.count = 1 + (merged - _usbd_sof[idx].merged_taken);
+      _usbd_sof[idx].merged_taken = merged;
+    }
+  }
 
-    if ( !osal_queue_receive(_usbd_q, &event) ) return;
+  return count;
+}
 
-#if CFG_TUSB_DEBUG >= 2
-    if (event.event_id == DCD_EVENT_SETUP_RECEIVED) TU_LOG2("\r\n"); // extra line for setup
-    TU_LOG2("USBD %s ", event.event_id < DCD_EVENT_COUNT ? _usbd_event_str[event.event_id] : "CORRUPTED");
+// Pop up to max_count events of a port, high priority lane first.
+// With an RTOS, only one event is popped and this blocks up to msec until one is available.
+static uint16_t event_receive(uint8_t idx, dcd_event_t* events, uint16_t max_count, uint32_t msec)
+{
+#if CFG_TUD_TASK_HIGH_QUEUE_SZ
+  #if CFG_TUSB_OS == OPT_OS_NONE
+  uint16_t const count = lane_receive(idx, LANE_HIGH, events, max_count, msec);
+  if ( count ) return count;
+  #else
+  // Single consumer: receive does not block if lane is not empty
+  if ( !osal_queue_empty(_usbd_q_hi[idx]) ) return lane_receive(idx, LANE_HIGH, events, max_count, OSAL_TIMEOUT_NOTIMEOUT);
+  #endif
 #endif
 
-    switch ( event.event_id )
-    {
-      case DCD_EVENT_BUS_RESET:
-        TU_LOG2("\r\n");
-        usbd_reset(event.rhport);
-        _usbd_dev.speed = event.bus_reset.speed;
-      break;
+  return lane_receive(idx, LANE_NORMAL, events, max_count, msec);
+}
 
-      case DCD_EVENT_UNPLUGGED:
-        TU_LOG2("\r\n");
-        usbd_reset(event.rhport);
+void tud_task_event_stats_rhport(uint8_t rhport, tud_task_event_stats_t* stats)
+{
+  uint8_t const idx = usbd_rhport_idx(rhport);
 
-        // invoke callback
-        if (tud_umount_cb) tud_umount_cb();
-      break;
+  stats->queued          = _usbd_qstat[idx].sent[LANE_NORMAL] + _usbd_qstat[idx].sent[LANE_HIGH] - _usbd_qstat[idx].sent_base;
+  stats->dropped         = _usbd_qstat[idx].dropped;
+  stats->coalesced       = _usbd_qstat[idx].coalesced;
+  stats->peak_count      = _usbd_qstat[idx].peak[LANE_NORMAL];
+  stats->peak_count_high = _usbd_qstat[idx].peak[LANE_HIGH];
+}
 
-      case DCD_EVENT_SETUP_RECEIVED:
-        TU_LOG2_VAR(&event.setup_received);
-        TU_LOG2("\r\n");
+void tud_task_event_stats_reset_rhport(uint8_t rhport)
+{
+  uint8_t const idx = usbd_rhport_idx(rhport);
 
-        // Mark as connected after receiving 1st setup packet.
-        // But it is easier to set it every time instead of wasting time to check then set
-        _usbd_dev.connected = 1;
+  _usbd_qstat[idx].sent_base = _usbd_qstat[idx].sent[LANE_NORMAL] + _usbd_qstat[idx].sent[LANE_HIGH];
+  _usbd_qstat[idx].dropped   = 0;
+  _usbd_qstat[idx].coalesced = 0;
 
-        // mark both in & out control as free
-        _usbd_dev.ep_status[0][TUSB_DIR_OUT].busy = false;
-        _usbd_dev.ep_status[0][TUSB_DIR_OUT].claimed = 0;
-        _usbd_dev.ep_status[0][TUSB_DIR_IN ].busy = false;
-        _usbd_dev.ep_status[0][TUSB_DIR_IN ].claimed = 0;
+  for(uint8_t lane = 0; lane < LANE_COUNT; lane++)
+  {
+    _usbd_qstat[idx].peak[lane] = (uint16_t) (_usbd_qstat[idx].sent[lane] - _usbd_qstat[idx].received[lane]);
+  }
+}
 
-        // Process control request
-        if ( !process_control_request(event.rhport, &event.setup_received) )
-        {
-          TU_LOG2("  Stall EP0\r\n");
-          // Failed -> stall both control endpoint IN and OUT
-          dcd_edpt_stall(event.rhport, 0);
-          dcd_edpt_stall(event.rhport, 0 | TUSB_DIR_IN_MASK);
-        }
-      break;
+void tud_task_event_stats(tud_task_event_stats_t* stats)
+{
+  tud_task_event_stats_rhport(TUD_OPT_RHPORT, stats);
+}
 
-      case DCD_EVENT_XFER_COMPLETE:
-      {
-        // Invoke the class callback associated with the endpoint address
-        uint8_t const ep_addr = event.xfer_complete.ep_addr;
-        uint8_t const epnum   = tu_edpt_number(ep_addr);
-        uint8_t const ep_dir  = tu_edpt_dir(ep_addr);
+void tud_task_event_stats_reset(void)
+{
+  tud_task_event_stats_reset_rhport(TUD_OPT_RHPORT);
+}
 
-        TU_LOG2("on EP %02X with %u bytes\r\n", ep_addr, (unsigned int) event.xfer_complete.len);
+#if CFG_TUD_EDPT_STATS
+bool tud_edpt_stats_get_rhport(uint8_t rhport, uint8_t ep_addr, tud_edpt_stats_t* stats)
+{
+  usbd_device_t* dev = get_dev(rhport);
+  uint8_t const epnum = tu_edpt_number(ep_addr);
 
-        _usbd_dev.ep_status[epnum][ep_dir].busy = false;
-        _usbd_dev.ep_status[epnum][ep_dir].claimed = 0;
+  TU_VERIFY(epnum < CFG_TUD_EP_MAX);
 
-        if ( 0 == epnum )
-        {
-          usbd_control_xfer_cb(event.rhport, ep_addr, (xfer_result_t)event.xfer_complete.result, event.xfer_complete.len);
-        }
-        else
-        {
-          usbd_class_driver_t const * driver = get_driver( _usbd_dev.ep2drv[epnum][ep_dir] );
-          TU_ASSERT(driver, );
+  // counters are updated by dcd interrupt
+  dcd_int_disable(rhport);
+  *stats = dev->ep_stats[epnum][tu_edpt_dir(ep_addr)].stats;
+  dcd_int_enable(rhport);
 
-          TU_LOG2("  %s xfer callback\r\n", driver->name);
-          driver->xfer_cb(event.rhport, ep_addr, (xfer_result_t)event.xfer_complete.result, event.xfer_complete.len);
-        }
-      }
-      break;
+  return true;
+}
 
-      case DCD_EVENT_SUSPEND:
-        TU_LOG2("\r\n");
-        if (tud_suspend_cb) tud_suspend_cb(_usbd_dev.remote_wakeup_en);
-      break;
+void tud_edpt_stats_reset_rhport(uint8_t rhport, uint8_t ep_addr)
+{
+  usbd_device_t* dev = get_dev(rhport);
+  uint8_t const epnum = tu_edpt_number(ep_addr);
 
-      case DCD_EVENT_RESUME:
-        TU_LOG2("\r\n");
-        if (tud_resume_cb) tud_resume_cb();
-      break;
+  TU_VERIFY(epnum < CFG_TUD_EP_MAX, );
 
-      case DCD_EVENT_SOF:
-        TU_LOG2("\r\n");
-        for ( uint8_t i = 0; i < TOTAL_DRIVER_COUNT; i++ )
-        {
-          usbd_class_driver_t const * driver = get_driver(i);
-          if ( driver->sof ) driver->sof(event.rhport);
-        }
-      break;
+  dcd_int_disable(rhport);
+  tu_varclr(&dev->ep_stats[epnum][tu_edpt_dir(ep_addr)].stats);
+  dcd_int_enable(rhport);
+}
 
-      case USBD_EVENT_FUNC_CALL:
-        TU_LOG2("\r\n");
-        if ( event.func_call.func ) event.func_call.func(event.func_call.param);
-      break;
+bool tud_edpt_stats_get(uint8_t ep_addr, tud_edpt_stats_t* stats)
+{
+  return tud_edpt_stats_get_rhport(TUD_OPT_RHPORT, ep_addr, stats);
+}
 
-      default:
-        TU_BREAKPOINT();
-      break;
+void tud_edpt_stats_reset(uint8_t ep_addr)
+{
+  tud_edpt_stats_reset_rhport(TUD_OPT_RHPORT, ep_addr);
+}
+
+#if CFG_TUD_EDPT_STATS_REQUEST
+// Statistics sent by CFG_TUD_EDPT_STATS_REQUEST, must stay valid until data stage is complete
+static tud_edpt_stats_t _usbd_stats_xfer[TUD_OPT_RHPORT_COUNT];
+
+static bool process_edpt_stats_request(uint8_t rhport, tusb_control_request_t const * p_request)
+{
+  TU_VERIFY(p_request->bmRequestType_bit.direction == TUSB_DIR_IN);
+
+  tud_edpt_stats_t* stats = &_usbd_stats_xfer[usbd_rhport_idx(rhport)];
+  uint8_t const ep_addr = (uint8_t) p_request->wIndex;
+
+  TU_VERIFY(tud_edpt_stats_get_rhport(rhport, ep_addr, stats));
+  if ( p_request->wValue ) tud_edpt_stats_reset_rhport(rhport, ep_addr);
+
+  return tud_control_xfer(rhport, p_request, stats, sizeof(tud_edpt_stats_t));
+}
+#endif
+#endif
+
+/* USB Device Driver task
+ * This top level thread manages all device controller event and delegates events to class-specific drivers.
+ * This should be called periodically within the mainloop or rtos thread.
+ *
+   @code
+    int main(void)
+    {
+      application_init();
+      tusb_init();
+
+      while(1) // the mainloop
+      {
+        application_code();
+        tud_task(); // tinyusb device task
+      }
+    }
+    @endcode
+ */
+void tud_task (void)
+{
+  (void) tud_task_ext(0, OSAL_TIMEOUT_WAIT_FOREVER);
+}
+
+uint32_t tud_task_ext(uint16_t max_events, uint32_t timeout_ms)
+{
+#if CFG_TUSB_OS == OPT_OS_NONE
+  // Serve all device ports with one shared budget. Each call starts with the next port so that
+  // a busy port does not starve the other one.
+  static uint8_t first_idx = 0;
+
+  uint32_t total = 0;
+  for ( uint8_t i = 0; i < TUD_OPT_RHPORT_COUNT; i++ )
+  {
+    uint16_t budget = 0; // unlimited
+    if ( max_events )
+    {
+      if ( total >= max_events ) break;
+      budget = (uint16_t) (max_events - total);
+    }
+
+    uint8_t const idx = (uint8_t) ((first_idx + i) % TUD_OPT_RHPORT_COUNT);
+    total += tud_task_ext_rhport(idx_rhport(idx), budget, timeout_ms);
+  }
+
+  first_idx = (uint8_t) ((first_idx + 1) % TUD_OPT_RHPORT_COUNT);
+
+  return total;
+#else
+  // Blocking on a port, other port needs its own task running tud_task_ext_rhport()
+  return tud_task_ext_rhport(TUD_OPT_RHPORT, max_events, timeout_ms);
+#endif
+}
+
+void tud_task_rhport(uint8_t rhport)
+{
+  (void) tud_task_ext_rhport(rhport, 0, OSAL_TIMEOUT_WAIT_FOREVER);
+}
+
+uint32_t tud_task_ext_rhport(uint8_t rhport, uint16_t max_events, uint32_t timeout_ms)
+{
+  // Skip if stack is not initialized
+  if ( !tusb_inited() ) return 0;
+
+#if CFG_TUSB_OS == OPT_OS_NONE
+  // Drain the lock-free event queue in batches, each batch releases its queue slots at once
+  enum { EVENT_BATCH = CFG_TUD_TASK_EVENT_BATCH };
+#else
+  enum { EVENT_BATCH = 1 };
+#endif
+
+  uint8_t const idx = usbd_rhport_idx(rhport);
+  dcd_event_t events[EVENT_BATCH];
+  uint32_t processed = 0;
+
+  // Loop until there is no more events in the queue or budget is used up
+  while (1)
+  {
+    uint16_t batch = EVENT_BATCH;
+    if ( max_events )
+    {
+      if ( processed >= max_events ) return processed;
+      batch = (uint16_t) tu_min32(batch, max_events - processed);
+    }
+
+    // only block while waiting for the first event, then drain what is queued and return
+    uint32_t const timeout = processed ? OSAL_TIMEOUT_NOTIMEOUT : timeout_ms;
+
+#if CFG_TUD_TIMER
+    // wake up for the next timer deadline
+    uint32_t const wait = timer_wait_ms(idx, timeout);
+#else
+    uint32_t const wait = timeout;
+#endif
+
+    uint16_t const count = event_receive(idx, events, batch, wait);
+    for ( uint16_t i = 0; i < count; i++ ) process_event(&events[i]);
+    processed += count;
+
+#if CFG_TUD_TIMER
+    timer_fire_ms(idx);
+#endif
+
+    if ( count == 0 ) return processed;
+  }
+}
+
+// Process an event popped from the queue
+static void process_event(dcd_event_t const * event)
+{
+  usbd_device_t* dev = get_dev(event->rhport);
+
+  TRACE_EVENT(TU_TRACE_EVENT_TASK, event);
+
+#if CFG_TUSB_DEBUG >= 2
+  if (event->event_id == DCD_EVENT_SETUP_RECEIVED) TU_LOG2("\r\n"); // extra line for setup
+  TU_LOG2("USBD %s ", event->event_id < DCD_EVENT_COUNT ? _usbd_event_str[event->event_id] : "CORRUPTED");
+#endif
+
+  switch ( event->event_id )
+  {
+    case DCD_EVENT_BUS_RESET:
+      TU_LOG2("\r\n");
+      usbd_reset(event->rhport);
+      dev->speed = event->bus_reset.speed;
+    break;
+
+    case DCD_EVENT_UNPLUGGED:
+      TU_LOG2("\r\n");
+      usbd_reset(event->rhport);
+
+      // invoke callback
+      if (tud_umount_cb) tud_umount_cb();
+    break;
+
+    case DCD_EVENT_SETUP_RECEIVED:
+      TU_LOG2_VAR(&event->setup_received);
+      TU_LOG2("\r\n");
+
+      // Mark as connected after receiving 1st setup packet.
+      // But it is easier to set it every time instead of wasting time to check then set
+      dev->connected = 1;
+
+      // mark both in & out control as free
+      dev->ep_status[0][TUSB_DIR_OUT].busy = false;
+      dev->ep_status[0][TUSB_DIR_OUT].claimed = 0;
+      dev->ep_status[0][TUSB_DIR_IN ].busy = false;
+      dev->ep_status[0][TUSB_DIR_IN ].claimed = 0;
+
+      TU_TRACE(TU_TRACE_CONTROL_STAGE, event->rhport, event->setup_received.bRequest, CONTROL_STAGE_SETUP, event->setup_received.wLength);
+
+      // Process control request
+      if ( !process_control_request(event->rhport, &event->setup_received) )
+      {
+        TU_LOG2("  Stall EP0\r\n");
+        // Failed -> stall both control endpoint IN and OUT
+        dcd_edpt_stall(event->rhport, 0);
+        dcd_edpt_stall(event->rhport, 0 | TUSB_DIR_IN_MASK);
+      }
+    break;
+
+    case DCD_EVENT_XFER_COMPLETE:
+    {
+      // Invoke the class callback associated with the endpoint address
+      uint8_t const ep_addr = event->xfer_complete.ep_addr;
+      uint8_t const epnum   = tu_edpt_number(ep_addr);
+      uint8_t const ep_dir  = tu_edpt_dir(ep_addr);
+
+      TU_LOG2("on EP %02X with %u bytes\r\n", ep_addr, (unsigned int) event->xfer_complete.len);
+
+      edpt_xfer_done(dev, event->rhport, ep_addr, event->xfer_complete.len);
+
+      if ( 0 == epnum )
+      {
+        usbd_control_xfer_cb(event->rhport, ep_addr, (xfer_result_t)event->xfer_complete.result, event->xfer_complete.len);
+      }
+      else
+      {
+        usbd_class_driver_t const * driver = get_driver( dev->ep2drv[epnum][ep_dir] );
+        TU_ASSERT(driver, );
+
+        TU_LOG2("  %s xfer callback\r\n", driver->name);
+        driver->xfer_cb(event->rhport, ep_addr, (xfer_result_t)event->xfer_complete.result, event->xfer_complete.len);
+      }
+
+      TU_TRACE(TU_TRACE_XFER_CB_DONE, event->rhport, ep_addr, event->xfer_complete.result, event->xfer_complete.len);
     }
+    break;
+
+    case DCD_EVENT_SUSPEND:
+      TU_LOG2("\r\n");
+      if (tud_suspend_cb) tud_suspend_cb(dev->remote_wakeup_en);
+    break;
+
+    case DCD_EVENT_RESUME:
+      TU_LOG2("\r\n");
+      if (tud_resume_cb) tud_resume_cb();
+    break;
+
+    case DCD_EVENT_SOF:
+      TU_LOG2("count = %lu\r\n", (unsigned long) event->sof.count);
+      for ( uint8_t i = 0; i < CFG_TUD_SOF_SUBSCRIBER_MAX; i++ )
+      {
+        usbd_sof_cb_t const cb = _usbd_sof[usbd_rhport_idx(event->rhport)].subscriber[i];
+        if ( cb ) cb(event->rhport, event->sof.count);
+      }
+
+      if ( _usbd_driver_sof )
+      {
+        for ( uint8_t i = 0; i < TOTAL_DRIVER_COUNT; i++ )
+        {
+          usbd_class_driver_t const * driver = get_driver(i);
+          if ( driver->sof ) driver->sof(event->rhport);
+        }
+      }
+    break;
+
+    case USBD_EVENT_FUNC_CALL:
+      TU_LOG2("\r\n");
+      if ( event->func_call.func )
+      {
+        event->func_call.func(event->func_call.param);
+      }
+      #if CFG_TUD_TASK_HIGH_QUEUE_SZ && CFG_TUSB_OS != OPT_OS_NONE
+      else
+      {
+        // wake-up for high priority lane, which is serviced before the next event
+        _usbd_wakeup_pending[usbd_rhport_idx(event->rhport)] = false;
+      }
+      #endif
+    break;
+
+    default:
+      TU_BREAKPOINT();
+    break;
   }
+
 }
 
 //--------------------------------------------------------------------+
@@ -566,7 +1234,7 @@ void tud_task (void)
 // Helper to invoke class driver control request handler
 static bool invoke_class_control(uint8_t rhport, usbd_class_driver_t const * driver, tusb_control_request_t const * request)
 {
-  usbd_control_set_complete_callback(driver->control_xfer_cb);
+  usbd_control_set_complete_callback(rhport, driver->control_xfer_cb);
   TU_LOG2("  %s control request\r\n", driver->name);
   return driver->control_xfer_cb(rhport, CONTROL_STAGE_SETUP, request);
 }
@@ -575,16 +1243,25 @@ static bool invoke_class_control(uint8_t rhport, usbd_class_driver_t const * dri
 // return false will cause its caller to stall control endpoint
 static bool process_control_request(uint8_t rhport, tusb_control_request_t const * p_request)
 {
-  usbd_control_set_complete_callback(NULL);
+  usbd_device_t* dev = get_dev(rhport);
+
+  usbd_control_set_complete_callback(rhport, NULL);
 
   TU_ASSERT(p_request->bmRequestType_bit.type < TUSB_REQ_TYPE_INVALID);
 
   // Vendor request
   if ( p_request->bmRequestType_bit.type == TUSB_REQ_TYPE_VENDOR )
   {
+#if CFG_TUD_EDPT_STATS && CFG_TUD_EDPT_STATS_REQUEST
+    if ( (p_request->bmRequestType_bit.recipient == TUSB_REQ_RCPT_DEVICE) && (p_request->bRequest == CFG_TUD_EDPT_STATS_REQUEST) )
+    {
+      return process_edpt_stats_request(rhport, p_request);
+    }
+#endif
+
     TU_VERIFY(tud_vendor_control_xfer_cb);
 
-    usbd_control_set_complete_callback(tud_vendor_control_xfer_cb);
+    usbd_control_set_complete_callback(rhport, tud_vendor_control_xfer_cb);
     return tud_vendor_control_xfer_cb(rhport, CONTROL_STAGE_SETUP, p_request);
   }
 
@@ -603,9 +1280,9 @@ static bool process_control_request(uint8_t rhport, tusb_control_request_t const
       if ( TUSB_REQ_TYPE_CLASS == p_request->bmRequestType_bit.type )
       {
         uint8_t const itf = tu_u16_low(p_request->wIndex);
-        TU_VERIFY(itf < TU_ARRAY_SIZE(_usbd_dev.itf2drv));
+        TU_VERIFY(itf < TU_ARRAY_SIZE(dev->itf2drv));
 
-        usbd_class_driver_t const * driver = get_driver(_usbd_dev.itf2drv[itf]);
+        usbd_class_driver_t const * driver = get_driver(dev->itf2drv[itf]);
         TU_VERIFY(driver);
 
         // forward to class driver: "non-STD request to Interface"
@@ -625,15 +1302,15 @@ static bool process_control_request(uint8_t rhport, tusb_control_request_t const
           // Depending on mcu, status phase could be sent either before or after changing device address,
           // or even require stack to not response with status at all
           // Therefore DCD must take full responsibility to response and include zlp status packet if needed.
-          usbd_control_set_request(p_request); // set request since DCD has no access to tud_control_status() API
+          usbd_control_set_request(rhport, p_request); // set request since DCD has no access to tud_control_status() API
           dcd_set_address(rhport, (uint8_t) p_request->wValue);
           // skip tud_control_status()
-          _usbd_dev.addressed = 1;
+          dev->addressed = 1;
         break;
 
         case TUSB_REQ_GET_CONFIGURATION:
         {
-          uint8_t cfg_num = _usbd_dev.cfg_num;
+          uint8_t cfg_num = dev->cfg_num;
           tud_control_xfer(rhport, p_request, &cfg_num, 1);
         }
         break;
@@ -642,8 +1319,8 @@ static bool process_control_request(uint8_t rhport, tusb_control_request_t const
         {
           uint8_t const cfg_num = (uint8_t) p_request->wValue;
 
-          if ( !_usbd_dev.cfg_num && cfg_num ) TU_ASSERT( process_set_config(rhport, cfg_num) );
-          _usbd_dev.cfg_num = cfg_num;
+          if ( !dev->cfg_num && cfg_num ) TU_ASSERT( process_set_config(rhport, cfg_num) );
+          dev->cfg_num = cfg_num;
 
           tud_control_status(rhport, p_request);
         }
@@ -658,7 +1335,7 @@ static bool process_control_request(uint8_t rhport, tusb_control_request_t const
           TU_VERIFY(TUSB_REQ_FEATURE_REMOTE_WAKEUP == p_request->wValue);
 
           // Host may enable remote wake up before suspending especially HID device
-          _usbd_dev.remote_wakeup_en = true;
+          dev->remote_wakeup_en = true;
           tud_control_status(rhport, p_request);
         break;
 
@@ -667,7 +1344,7 @@ static bool process_control_request(uint8_t rhport, tusb_control_request_t const
           TU_VERIFY(TUSB_REQ_FEATURE_REMOTE_WAKEUP == p_request->wValue);
 
           // Host may disable remote wake up after resuming
-          _usbd_dev.remote_wakeup_en = false;
+          dev->remote_wakeup_en = false;
           tud_control_status(rhport, p_request);
         break;
 
@@ -676,7 +1353,7 @@ static bool process_control_request(uint8_t rhport, tusb_control_request_t const
           // Device status bit mask
           // - Bit 0: Self Powered
           // - Bit 1: Remote Wakeup enabled
-          uint16_t status = (_usbd_dev.self_powered ? 1 : 0) | (_usbd_dev.remote_wakeup_en ? 2 : 0);
+          uint16_t status = (dev->self_powered ? 1 : 0) | (dev->remote_wakeup_en ? 2 : 0);
           tud_control_xfer(rhport, p_request, &status, 2);
         }
         break;
@@ -690,9 +1367,9 @@ static bool process_control_request(uint8_t rhport, tusb_control_request_t const
     case TUSB_REQ_RCPT_INTERFACE:
     {
       uint8_t const itf = tu_u16_low(p_request->wIndex);
-      TU_VERIFY(itf < TU_ARRAY_SIZE(_usbd_dev.itf2drv));
+      TU_VERIFY(itf < TU_ARRAY_SIZE(dev->itf2drv));
 
-      usbd_class_driver_t const * driver = get_driver(_usbd_dev.itf2drv[itf]);
+      usbd_class_driver_t const * driver = get_driver(dev->itf2drv[itf]);
       TU_VERIFY(driver);
 
       // all requests to Interface (STD or Class) is forwarded to class driver.
@@ -725,9 +1402,9 @@ static bool process_control_request(uint8_t rhport, tusb_control_request_t const
       uint8_t const ep_num  = tu_edpt_number(ep_addr);
       uint8_t const ep_dir  = tu_edpt_dir(ep_addr);
 
-      TU_ASSERT(ep_num < TU_ARRAY_SIZE(_usbd_dev.ep2drv) );
+      TU_ASSERT(ep_num < TU_ARRAY_SIZE(dev->ep2drv) );
 
-      usbd_class_driver_t const * driver = get_driver(_usbd_dev.ep2drv[ep_num][ep_dir]);
+      usbd_class_driver_t const * driver = get_driver(dev->ep2drv[ep_num][ep_dir]);
 
       if ( TUSB_REQ_TYPE_STANDARD != p_request->bmRequestType_bit.type )
       {
@@ -769,10 +1446,10 @@ static bool process_control_request(uint8_t rhport, tusb_control_request_t const
               // STD request must always be ACKed regardless of driver returned value
               // Also clear complete callback if driver set since it can also stall the request.
               (void) invoke_class_control(rhport, driver, p_request);
-              usbd_control_set_complete_callback(NULL);
+              usbd_control_set_complete_callback(rhport, NULL);
 
               // skip ZLP status if driver already did that
-              if ( !_usbd_dev.ep_status[0][TUSB_DIR_IN].busy ) tud_control_status(rhport, p_request);
+              if ( !dev->ep_status[0][TUSB_DIR_IN].busy ) tud_control_status(rhport, p_request);
             }
           }
           break;
@@ -798,9 +1475,14 @@ static bool process_set_config(uint8_t rhport, uint8_t cfg_num)
   tusb_desc_configuration_t const * desc_cfg = (tusb_desc_configuration_t const *) tud_descriptor_configuration_cb(cfg_num-1); // index is cfg_num-1
   TU_ASSERT(desc_cfg != NULL && desc_cfg->bDescriptorType == TUSB_DESC_CONFIGURATION);
 
+  usbd_device_t* dev = get_dev(rhport);
+
   // Parse configuration descriptor
-  _usbd_dev.remote_wakeup_support = (desc_cfg->bmAttributes & TUSB_DESC_CONFIG_ATT_REMOTE_WAKEUP) ? 1 : 0;
-  _usbd_dev.self_powered = (desc_cfg->bmAttributes & TUSB_DESC_CONFIG_ATT_SELF_POWERED) ? 1 : 0;
+  dev->remote_wakeup_support = (desc_cfg->bmAttributes & TUSB_DESC_CONFIG_ATT_REMOTE_WAKEUP) ? 1 : 0;
+  dev->self_powered = (desc_cfg->bmAttributes & TUSB_DESC_CONFIG_ATT_SELF_POWERED) ? 1 : 0;
+
+  // Index interfaces and endpoints first, drivers can look them up when opened
+  TU_ASSERT( build_config_index(dev, desc_cfg) );
 
   // Parse interface descriptor
   uint8_t const * p_desc   = ((uint8_t const*) desc_cfg) + sizeof(tusb_desc_configuration_t);
@@ -834,10 +1516,10 @@ static bool process_set_config(uint8_t rhport, uint8_t cfg_num)
         TU_ASSERT( sizeof(tusb_desc_interface_t) <= drv_len && drv_len <= remaining_len);
 
         // Interface number must not be used already
-        TU_ASSERT(DRVID_INVALID == _usbd_dev.itf2drv[desc_itf->bInterfaceNumber]);
+        TU_ASSERT(DRVID_INVALID == dev->itf2drv[desc_itf->bInterfaceNumber]);
 
         TU_LOG2("  %s opened\r\n", driver->name);
-        _usbd_dev.itf2drv[desc_itf->bInterfaceNumber] = drv_id;
+        dev->itf2drv[desc_itf->bInterfaceNumber] = drv_id;
 
         // If IAD exist, assign all interfaces to the same driver
         if (desc_itf_assoc)
@@ -848,11 +1530,11 @@ static bool process_set_config(uint8_t rhport, uint8_t cfg_num)
 
           for(uint8_t i=1; i<desc_itf_assoc->bInterfaceCount; i++)
           {
-            _usbd_dev.itf2drv[desc_itf->bInterfaceNumber+i] = drv_id;
+            dev->itf2drv[desc_itf->bInterfaceNumber+i] = drv_id;
           }
         }
 
-        mark_interface_endpoint(_usbd_dev.ep2drv, p_desc, drv_len, drv_id); // TODO refactor
+        mark_interface_endpoint(dev->ep2drv, p_desc, drv_len, drv_id); // TODO refactor
 
         p_desc += drv_len; // next interface
 
@@ -889,6 +1571,67 @@ static void mark_interface_endpoint(uint8_t ep2drv[][2], uint8_t const* p_desc,
   }
 }
 
+// Helper indexing interfaces and endpoints of configuration descriptor, alternate settings
+// of an interface are expected to be contiguous
+static bool build_config_index(usbd_device_t* dev, tusb_desc_configuration_t const * desc_cfg)
+{
+  uint8_t const * p_desc   = ((uint8_t const*) desc_cfg) + sizeof(tusb_desc_configuration_t);
+  uint8_t const * desc_end = ((uint8_t const*) desc_cfg) + desc_cfg->wTotalLength;
+  uint8_t itf_num = ITF_INVALID; // interface the current descriptor belongs to
+
+  // configuration can be set again after SET_CONFIGURATION(0) without bus reset
+  dev->cfg_desc = (uint8_t const*) desc_cfg;
+  tu_varclr(&dev->itf_index);
+  memset(dev->ep2itf, ITF_INVALID, sizeof(dev->ep2itf));
+
+  while( p_desc < desc_end )
+  {
+    TU_ASSERT( tu_desc_len(p_desc) );
+
+    uint16_t const offset = (uint16_t) (p_desc - dev->cfg_desc);
+
+    switch ( tu_desc_type(p_desc) )
+    {
+      case TUSB_DESC_INTERFACE:
+        itf_num = ((tusb_desc_interface_t const*) p_desc)->bInterfaceNumber;
+        TU_ASSERT( itf_num < TU_ARRAY_SIZE(dev->itf_index) );
+
+        if ( !dev->itf_index[itf_num].offset ) dev->itf_index[itf_num].offset = offset;
+        dev->itf_index[itf_num].alt_count++;
+      break;
+
+      case TUSB_DESC_INTERFACE_ASSOCIATION:
+        itf_num = ITF_INVALID;
+      break;
+
+      case TUSB_DESC_ENDPOINT:
+        if ( itf_num != ITF_INVALID )
+        {
+          uint8_t const ep_addr = ((tusb_desc_endpoint_t const*) p_desc)->bEndpointAddress;
+          uint8_t const epnum   = tu_edpt_number(ep_addr);
+          uint8_t const dir     = tu_edpt_dir(ep_addr);
+
+          TU_ASSERT( epnum < CFG_TUD_EP_MAX );
+
+          // endpoint can be re-used by other alternate settings of the same interface
+          if ( dev->ep2itf[epnum][dir] == ITF_INVALID ) dev->ep2itf[epnum][dir] = itf_num;
+        }
+      break;
+
+      default: break;
+    }
+
+    if ( itf_num != ITF_INVALID )
+    {
+      dev->itf_index[itf_num].len = (uint16_t) (offset + tu_desc_len(p_desc) - dev->itf_index[itf_num].offset);
+    }
+
+    p_desc = tu_desc_next(p_desc);
+  }
+
+  return true;
+}
+
 // return descriptor's buffer and update desc_len
 static bool process_get_descriptor(uint8_t rhport, tusb_control_request_t const * p_request)
 {
@@ -905,7 +1648,7 @@ static bool process_get_descriptor(uint8_t rhport, tusb_control_request_t const
 
       // Only send up to EP0 Packet Size if not addressed
       // This only happens with the very first get device descriptor and EP0 size = 8 or 16.
-      if ((CFG_TUD_ENDPOINT0_SIZE < sizeof(tusb_desc_device_t)) && !_usbd_dev.addressed)
+      if ((CFG_TUD_ENDPOINT0_SIZE < sizeof(tusb_desc_device_t)) && !get_dev(rhport)->addressed)
       {
         len = CFG_TUD_ENDPOINT0_SIZE;
 
@@ -995,119 +1738,455 @@ static bool process_get_descriptor(uint8_t rhport, tusb_control_request_t const
 //--------------------------------------------------------------------+
 // DCD Event Handler
 //--------------------------------------------------------------------+
-void dcd_event_handler(dcd_event_t const * event, bool in_isr)
+#if CFG_TUD_TASK_HIGH_QUEUE_SZ
+static inline bool event_is_high_prio(usbd_device_t const * dev, dcd_event_t const * event)
 {
   switch (event->event_id)
   {
-    case DCD_EVENT_UNPLUGGED:
-      // UNPLUGGED event can be bouncing, only processing if we are currently connected
-      if ( _usbd_dev.connected )
-      {
-        _usbd_dev.connected  = 0;
-        _usbd_dev.addressed  = 0;
-        _usbd_dev.cfg_num    = 0;
-        _usbd_dev.suspended  = 0;
-        osal_queue_send(_usbd_q, event, in_isr);
-      }
-    break;
-
-    case DCD_EVENT_SOF:
-      return;   // skip SOF event for now
-    break;
+    case DCD_EVENT_XFER_COMPLETE:
+    {
+      uint8_t const ep_addr = event->xfer_complete.ep_addr;
+      uint8_t const epnum   = tu_edpt_number(ep_addr);
 
-    case DCD_EVENT_SUSPEND:
-      // NOTE: When plugging/unplugging device, the D+/D- state are unstable and
-      // can accidentally meet the SUSPEND condition ( Bus Idle for 3ms ).
-      // In addition, some MCUs such as SAMD or boards that haven no VBUS detection cannot distinguish
-      // suspended vs disconnected. We will skip handling SUSPEND/RESUME event if not currently connected
-      if ( _usbd_dev.connected )
-      {
-        _usbd_dev.suspended = 1;
-        osal_queue_send(_usbd_q, event, in_isr);
-      }
-    break;
+      // control endpoint is in the same lane as SETUP to keep their order
+      return (epnum == 0) || dev->ep_status[epnum][tu_edpt_dir(ep_addr)].high_prio;
+    }
 
-    case DCD_EVENT_RESUME:
-      // skip event if not connected (especially required for SAMD)
-      if ( _usbd_dev.connected )
-      {
-        _usbd_dev.suspended = 0;
-        osal_queue_send(_usbd_q, event, in_isr);
-      }
-    break;
+    case USBD_EVENT_FUNC_CALL:
+      return false;
 
     default:
-      osal_queue_send(_usbd_q, event, in_isr);
-    break;
+      return true; // setup and bus signals
   }
 }
+#endif
 
-void dcd_event_bus_signal (uint8_t rhport, dcd_eventid_t eid, bool in_isr)
+// Send event to a lane of its port and account for it
+static bool lane_send(uint8_t idx, uint8_t lane, dcd_event_t const * event, bool in_isr)
 {
-  dcd_event_t event = { .rhport = rhport, .event_id = eid };
-  dcd_event_handler(&event, in_isr);
-}
+#if CFG_TUD_TASK_HIGH_QUEUE_SZ
+  osal_queue_t const q = (lane == LANE_HIGH) ? _usbd_q_hi[idx] : _usbd_q[idx];
+#else
+  osal_queue_t const q = _usbd_q[idx];
+#endif
 
-void dcd_event_bus_reset (uint8_t rhport, tusb_speed_t speed, bool in_isr)
-{
-  dcd_event_t event = { .rhport = rhport, .event_id = DCD_EVENT_BUS_RESET };
-  event.bus_reset.speed = speed;
-  dcd_event_handler(&event, in_isr);
-}
+  if ( !osal_queue_send(q, event, in_isr) )
+  {
+    _usbd_qstat[idx].dropped++;
+    return false;
+  }
 
-void dcd_event_setup_received(uint8_t rhport, uint8_t const * setup, bool in_isr)
-{
-  dcd_event_t event = { .rhport = rhport, .event_id = DCD_EVENT_SETUP_RECEIVED };
-  memcpy(&event.setup_received, setup, 8);
+  uint32_t const sent = _usbd_qstat[idx].sent[lane] + 1;
+  _usbd_qstat[idx].sent[lane] = sent;
 
-  dcd_event_handler(&event, in_isr);
+  uint16_t const pending = (uint16_t) (sent - _usbd_qstat[idx].received[lane]);
+  if ( pending > _usbd_qstat[idx].peak[lane] ) _usbd_qstat[idx].peak[lane] = pending;
+
+  return true;
 }
 
-void dcd_event_xfer_complete (uint8_t rhport, uint8_t ep_addr, uint32_t xferred_bytes, uint8_t result, bool in_isr)
+// Queue event in its lane
+static bool queue_event(dcd_event_t const * event, bool in_isr)
 {
-  dcd_event_t event = { .rhport = rhport, .event_id = DCD_EVENT_XFER_COMPLETE };
+  uint8_t const idx = usbd_rhport_idx(event->rhport);
 
-  event.xfer_complete.ep_addr = ep_addr;
-  event.xfer_complete.len     = xferred_bytes;
-  event.xfer_complete.result  = result;
-
-  dcd_event_handler(&event, in_isr);
-}
-
-//--------------------------------------------------------------------+
-// Helper
-//--------------------------------------------------------------------+
+  TRACE_EVENT(TU_TRACE_EVENT_ISR, event);
 
-// Parse consecutive endpoint descriptors (IN & OUT)
-bool usbd_open_edpt_pair(uint8_t rhport, uint8_t const* p_desc, uint8_t ep_count, uint8_t xfer_type, uint8_t* ep_out, uint8_t* ep_in)
-{
-  for(int i=0; i<ep_count; i++)
+#if CFG_TUD_TASK_HIGH_QUEUE_SZ
+  if ( event_is_high_prio(&_usbd_dev[idx], event) )
   {
-    tusb_desc_endpoint_t const * desc_ep = (tusb_desc_endpoint_t const *) p_desc;
-
-    TU_ASSERT(TUSB_DESC_ENDPOINT == desc_ep->bDescriptorType && xfer_type == desc_ep->bmAttributes.xfer);
-    TU_ASSERT(usbd_edpt_open(rhport, desc_ep));
+    bool const success = lane_send(idx, LANE_HIGH, event, in_isr);
 
-    if ( tu_edpt_dir(desc_ep->bEndpointAddress) == TUSB_DIR_IN )
-    {
-      (*ep_in) = desc_ep->bEndpointAddress;
-    }else
+    #if CFG_TUSB_OS != OPT_OS_NONE
+    // tud_task() may be blocked on the normal lane, post an empty function call to wake it up
+    if ( success && !_usbd_wakeup_pending[idx] )
     {
-      (*ep_out) = desc_ep->bEndpointAddress;
+      dcd_event_t const wakeup = { .rhport = event->rhport, .event_id = USBD_EVENT_FUNC_CALL };
+      _usbd_wakeup_pending[idx] = lane_send(idx, LANE_NORMAL, &wakeup, in_isr);
     }
+    #endif
 
-    p_desc = tu_desc_next(p_desc);
+    return success;
+  }
+#endif
+
+  return lane_send(idx, LANE_NORMAL, event, in_isr);
+}
+
+#if CFG_TUD_EDPT_STATS
+static inline uint32_t edpt_stats_time(void)
+{
+  return tud_edpt_stats_time_cb ? tud_edpt_stats_time_cb() : 0;
+}
+
+// Transfer is handed to dcd, ends endpoint's idle time
+static void edpt_stats_start(usbd_device_t* dev, uint8_t epnum, uint8_t dir)
+{
+  uint32_t const now = edpt_stats_time();
+
+  dev->ep_stats[epnum][dir].start_time = now;
+
+  if ( dev->ep_stats[epnum][dir].idle )
+  {
+    tud_edpt_stats_t* stats = &dev->ep_stats[epnum][dir].stats;
+    uint32_t const idle = now - dev->ep_stats[epnum][dir].idle_since;
+
+    dev->ep_stats[epnum][dir].idle = false;
+    stats->idle_count++;
+    stats->idle_total += idle;
+    if ( idle > stats->idle_max ) stats->idle_max = idle;
+  }
+}
+
+// Whole transfer is complete, called in dcd interrupt context. Endpoint becomes idle unless
+// its next transfer is already started.
+static void edpt_stats_complete(usbd_device_t* dev, dcd_event_t const * event, bool idle)
+{
+  uint8_t const epnum = tu_edpt_number(event->xfer_complete.ep_addr);
+  uint8_t const dir   = tu_edpt_dir(event->xfer_complete.ep_addr);
+
+  uint32_t const now = edpt_stats_time();
+  uint32_t const latency = now - dev->ep_stats[epnum][dir].start_time;
+  tud_edpt_stats_t* stats = &dev->ep_stats[epnum][dir].stats;
+
+  stats->xfers++;
+  stats->bytes += event->xfer_complete.len;
+  if ( event->xfer_complete.result != XFER_RESULT_SUCCESS ) stats->failed++;
+
+  uint8_t bucket = 0;
+  for ( uint32_t v = latency >> CFG_TUD_EDPT_STATS_HIST_SHIFT; v && (bucket < TUD_EDPT_STATS_HIST_COUNT-1); v >>= 1 ) bucket++;
+  stats->latency_hist[bucket]++;
+  if ( latency > stats->latency_max ) stats->latency_max = latency;
+
+  if ( idle )
+  {
+    dev->ep_stats[epnum][dir].idle       = true;
+    dev->ep_stats[epnum][dir].idle_since = now;
+  }
+}
+#endif
+
+// Submit a chunk to dcd, from/to FIFO if ff is not NULL
+static inline bool edpt_xfer_chunk(uint8_t rhport, uint8_t ep_addr, uint8_t * buffer, tu_fifo_t * ff, uint16_t len)
+{
+  return ff ? dcd_edpt_xfer_fifo(rhport, ep_addr, ff, len) : dcd_edpt_xfer(rhport, ep_addr, buffer, len);
+}
+
+// Submit transfer to dcd, only its first chunk if it is longer than CFG_TUD_EDPT_XFER_CHUNK_SIZE
+static bool edpt_xfer_start(usbd_device_t* dev, uint8_t rhport, uint8_t ep_addr, uint8_t * buffer, tu_fifo_t * ff, uint32_t total_bytes)
+{
+  uint8_t const epnum = tu_edpt_number(ep_addr);
+  uint8_t const dir   = tu_edpt_dir(ep_addr);
+
+  // set up before dcd_edpt_xfer() since the chunk can be complete before it returns
+  dev->xfer_split[epnum][dir].total_bytes = 0;
+
+#if CFG_TUD_EDPT_STATS
+  edpt_stats_start(dev, epnum, dir);
+#endif
+
+  if ( total_bytes > CFG_TUD_EDPT_XFER_CHUNK_SIZE )
+  {
+    dev->xfer_split[epnum][dir].buffer      = buffer;
+    dev->xfer_split[epnum][dir].ff          = ff;
+    dev->xfer_split[epnum][dir].total_bytes = total_bytes;
+    dev->xfer_split[epnum][dir].xferred     = 0;
+
+    total_bytes = CFG_TUD_EDPT_XFER_CHUNK_SIZE;
+  }
+
+  if ( edpt_xfer_chunk(rhport, ep_addr, buffer, ff, (uint16_t) total_bytes) ) return true;
+
+  dev->xfer_split[epnum][dir].total_bytes = 0;
+  return false;
+}
+
+// Start next chunk of a split transfer, called on transfer complete in dcd interrupt context.
+// Return false if transfer is done, event length is then updated to the whole transfer's.
+static bool edpt_xfer_continue(usbd_device_t* dev, dcd_event_t* event)
+{
+  uint8_t const ep_addr = event->xfer_complete.ep_addr;
+  uint8_t const epnum   = tu_edpt_number(ep_addr);
+  uint8_t const dir     = tu_edpt_dir(ep_addr);
+
+  uint32_t const total_bytes = dev->xfer_split[epnum][dir].total_bytes;
+  if ( total_bytes == 0 ) return false;
+
+  uint32_t xferred = dev->xfer_split[epnum][dir].xferred;
+  uint32_t const chunk = tu_min32(total_bytes - xferred, CFG_TUD_EDPT_XFER_CHUNK_SIZE);
+
+  xferred += event->xfer_complete.len;
+  dev->xfer_split[epnum][dir].xferred = xferred;
+
+  // continue unless chunk is failed, short or the last one
+  if ( (event->xfer_complete.result == XFER_RESULT_SUCCESS) && (event->xfer_complete.len == chunk) && (xferred < total_bytes) )
+  {
+    uint32_t const next = tu_min32(total_bytes - xferred, CFG_TUD_EDPT_XFER_CHUNK_SIZE);
+    tu_fifo_t* const ff = dev->xfer_split[epnum][dir].ff;
+    uint8_t* const buffer = ff ? NULL : (dev->xfer_split[epnum][dir].buffer + xferred);
+    if ( edpt_xfer_chunk(event->rhport, ep_addr, buffer, ff, (uint16_t) next) ) return true;
+
+    event->xfer_complete.result = XFER_RESULT_FAILED;
+  }
+
+  event->xfer_complete.len = xferred;
+  dev->xfer_split[epnum][dir].total_bytes = 0;
+
+  return false;
+}
+
+// Mark endpoint ready for next transfer once class driver is notified of completion
+static void edpt_xfer_done(usbd_device_t* dev, uint8_t rhport, uint8_t ep_addr, uint32_t xferred_bytes)
+{
+  uint8_t const epnum = tu_edpt_number(ep_addr);
+  uint8_t const dir   = tu_edpt_dir(ep_addr);
+
+  (void) rhport;
+  (void) xferred_bytes;
+
+#if CFG_TUD_EDPT_XFER_QUEUE_SZ
+  if ( epnum )
+  {
+    // endpoint stays busy while there are more transfers queued behind this one
+    edpt_int_disable(dev, rhport);
+    uint8_t const inflight = dev->xfer_q[epnum][dir].inflight;
+    if ( inflight > 1 )
+    {
+      dev->xfer_q[epnum][dir].inflight = inflight - 1;
+    }
+    else
+    {
+      // nothing started nor queued anymore
+      dev->xfer_q[epnum][dir].inflight = 0;
+      dev->xfer_q[epnum][dir].active   = false;
+      dev->ep_status[epnum][dir].busy  = false;
+    }
+    edpt_int_enable(dev, rhport);
+  }
+  else
+#endif
+  {
+    dev->ep_status[epnum][dir].busy = false;
+  }
+  dev->ep_status[epnum][dir].claimed = 0;
+
+#if CFG_TUD_XFER_SG_BOUNCE_SIZE
+  if ( epnum ) sg_bounce_complete(rhport, ep_addr, xferred_bytes);
+#endif
+}
+
+#if CFG_TUD_EDPT_ISR_CB
+// Complete transfer of an ISR-direct endpoint, what usbd task does for the others
+static void edpt_isr_complete(usbd_device_t* dev, dcd_event_t const * event, usbd_edpt_isr_cb_t cb)
+{
+  uint8_t const ep_addr = event->xfer_complete.ep_addr;
+
+  TRACE_EVENT(TU_TRACE_EVENT_ISR, event);
+
+  dev->in_isr_cb = true;
+  edpt_xfer_done(dev, event->rhport, ep_addr, event->xfer_complete.len);
+  cb(event->rhport, ep_addr, (xfer_result_t) event->xfer_complete.result, event->xfer_complete.len);
+  dev->in_isr_cb = false;
+
+  TU_TRACE(TU_TRACE_XFER_CB_DONE, event->rhport, ep_addr, event->xfer_complete.result, event->xfer_complete.len);
+}
+#endif
+
+#if CFG_TUD_EDPT_XFER_QUEUE_SZ
+// Start next queued transfer of endpoint, called on transfer complete in dcd interrupt context
+static void xfer_queue_next(usbd_device_t* dev, uint8_t rhport, uint8_t ep_addr, bool in_isr)
+{
+  uint8_t const epnum = tu_edpt_number(ep_addr);
+  uint8_t const dir   = tu_edpt_dir(ep_addr);
+
+  if ( epnum == 0 ) return;
+
+  if ( dev->xfer_q[epnum][dir].count == 0 )
+  {
+    dev->xfer_q[epnum][dir].active = false;
+    return;
+  }
+
+  uint8_t const rd_idx = dev->xfer_q[epnum][dir].rd_idx;
+  uint8_t* buffer = dev->xfer_q[epnum][dir].xfer[rd_idx].buffer;
+  uint32_t const total_bytes = dev->xfer_q[epnum][dir].xfer[rd_idx].total_bytes;
+
+  dev->xfer_q[epnum][dir].rd_idx = (rd_idx + 1) % CFG_TUD_EDPT_XFER_QUEUE_SZ;
+  dev->xfer_q[epnum][dir].count--;
+
+  if ( !edpt_xfer_start(dev, rhport, ep_addr, buffer, NULL, total_bytes) )
+  {
+    // report it as failed transfer, which in turn starts the next one
+    dcd_event_xfer_complete(rhport, ep_addr, 0, XFER_RESULT_FAILED, in_isr);
+  }
+}
+#endif
+
+void dcd_event_handler(dcd_event_t const * event, bool in_isr)
+{
+  uint8_t const idx = usbd_rhport_idx(event->rhport);
+  usbd_device_t* dev = &_usbd_dev[idx];
+
+  switch (event->event_id)
+  {
+    case DCD_EVENT_UNPLUGGED:
+      // UNPLUGGED event can be bouncing, only processing if we are currently connected
+      if ( dev->connected )
+      {
+        dev->connected  = 0;
+        dev->addressed  = 0;
+        dev->cfg_num    = 0;
+        dev->suspended  = 0;
+        queue_event(event, in_isr);
+      }
+    break;
+
+    case DCD_EVENT_SOF:
+      // skip SOF if there is no subscriber e.g port without dcd_sof_enable()
+      if ( !_usbd_sof[idx].enabled ) return;
+
+      if ( _usbd_sof[idx].pending )
+      {
+        // merge into the pending SOF event, its count is updated when tud_task() pops it
+        _usbd_sof[idx].merged++;
+        _usbd_qstat[idx].coalesced++;
+      }
+      else
+      {
+        _usbd_sof[idx].pending = queue_event(event, in_isr);
+      }
+    break;
+
+    case DCD_EVENT_SUSPEND:
+      // NOTE: When plugging/unplugging device, the D+/D- state are unstable and
+      // can accidentally meet the SUSPEND condition ( Bus Idle for 3ms ).
+      // In addition, some MCUs such as SAMD or boards that haven no VBUS detection cannot distinguish
+      // suspended vs disconnected. We will skip handling SUSPEND/RESUME event if not currently connected
+      if ( dev->connected )
+      {
+        dev->suspended = 1;
+        queue_event(event, in_isr);
+      }
+    break;
+
+    case DCD_EVENT_RESUME:
+      // skip event if not connected (especially required for SAMD)
+      if ( dev->connected )
+      {
+        dev->suspended = 0;
+        queue_event(event, in_isr);
+      }
+    break;
+
+    case DCD_EVENT_XFER_COMPLETE:
+    {
+      dcd_event_t xfer_event = *event;
+
+      // usbd task is not involved until all chunks of a split transfer are done
+      if ( edpt_xfer_continue(dev, &xfer_event) ) break;
+
+#if CFG_TUD_EDPT_ISR_CB
+      usbd_edpt_isr_cb_t const isr_cb = dev->isr_cb[tu_edpt_number(event->xfer_complete.ep_addr)][tu_edpt_dir(event->xfer_complete.ep_addr)];
+      if ( !isr_cb )
+#endif
+      {
+        // queue completion first so that it is processed before the one of next transfer
+        queue_event(&xfer_event, in_isr);
+      }
+
+#if CFG_TUD_EDPT_XFER_QUEUE_SZ
+      // account completion before next queued transfer overwrites its start time
+      #if CFG_TUD_EDPT_STATS
+      uint8_t const epnum = tu_edpt_number(event->xfer_complete.ep_addr);
+      bool const has_next = (epnum != 0) && (dev->xfer_q[epnum][tu_edpt_dir(event->xfer_complete.ep_addr)].count > 0);
+      edpt_stats_complete(dev, &xfer_event, !has_next);
+      #endif
+
+      xfer_queue_next(dev, event->rhport, event->xfer_complete.ep_addr, in_isr);
+#elif CFG_TUD_EDPT_STATS
+      edpt_stats_complete(dev, &xfer_event, true);
+#endif
+
+#if CFG_TUD_EDPT_ISR_CB
+      // after next queued transfer is started, a transfer submitted by callback is queued behind it
+      if ( isr_cb ) edpt_isr_complete(dev, &xfer_event, isr_cb);
+#endif
+    }
+    break;
+
+    default:
+      queue_event(event, in_isr);
+    break;
+  }
+}
+
+void dcd_event_bus_signal (uint8_t rhport, dcd_eventid_t eid, bool in_isr)
+{
+  dcd_event_t event = { .rhport = rhport, .event_id = eid };
+  dcd_event_handler(&event, in_isr);
+}
+
+void dcd_event_bus_reset (uint8_t rhport, tusb_speed_t speed, bool in_isr)
+{
+  dcd_event_t event = { .rhport = rhport, .event_id = DCD_EVENT_BUS_RESET };
+  event.bus_reset.speed = speed;
+  dcd_event_handler(&event, in_isr);
+}
+
+void dcd_event_setup_received(uint8_t rhport, uint8_t const * setup, bool in_isr)
+{
+  dcd_event_t event = { .rhport = rhport, .event_id = DCD_EVENT_SETUP_RECEIVED };
+  memcpy(&event.setup_received, setup, 8);
+
+  dcd_event_handler(&event, in_isr);
+}
+
+void dcd_event_xfer_complete (uint8_t rhport, uint8_t ep_addr, uint32_t xferred_bytes, uint8_t result, bool in_isr)
+{
+  dcd_event_t event = { .rhport = rhport, .event_id = DCD_EVENT_XFER_COMPLETE };
+
+  event.xfer_complete.ep_addr = ep_addr;
+  event.xfer_complete.len     = xferred_bytes;
+  event.xfer_complete.result  = result;
+
+  dcd_event_handler(&event, in_isr);
+}
+
+//--------------------------------------------------------------------+
+// Helper
+//--------------------------------------------------------------------+
+
+// Parse consecutive endpoint descriptors (IN & OUT)
+bool usbd_open_edpt_pair(uint8_t rhport, uint8_t const* p_desc, uint8_t ep_count, uint8_t xfer_type, uint8_t* ep_out, uint8_t* ep_in)
+{
+  for(int i=0; i<ep_count; i++)
+  {
+    tusb_desc_endpoint_t const * desc_ep = (tusb_desc_endpoint_t const *) p_desc;
+
+    TU_ASSERT(TUSB_DESC_ENDPOINT == desc_ep->bDescriptorType && xfer_type == desc_ep->bmAttributes.xfer);
+    TU_ASSERT(usbd_edpt_open(rhport, desc_ep));
+
+    if ( tu_edpt_dir(desc_ep->bEndpointAddress) == TUSB_DIR_IN )
+    {
+      (*ep_in) = desc_ep->bEndpointAddress;
+    }else
+    {
+      (*ep_out) = desc_ep->bEndpointAddress;
+    }
+
+    p_desc = tu_desc_next(p_desc);
   }
 
   return true;
 }
 
-// Helper to defer an isr function
-void usbd_defer_func(osal_task_func_t func, void* param, bool in_isr)
+// Helper to defer an isr function to usbd task of rhport. Each port's queue must only be
+// fed by the interrupt of that port (lock-free queue with OS NONE).
+void usbd_defer_func(uint8_t rhport, osal_task_func_t func, void* param, bool in_isr)
 {
   dcd_event_t event =
   {
-      .rhport   = 0,
+      .rhport   = rhport,
       .event_id = USBD_EVENT_FUNC_CALL,
   };
 
@@ -1117,25 +2196,314 @@ void usbd_defer_func(osal_task_func_t func, void* param, bool in_isr)
   dcd_event_handler(&event, in_isr);
 }
 
+//--------------------------------------------------------------------+
+// Configuration Index
+//--------------------------------------------------------------------+
+
+uint8_t const* usbd_itf_desc(uint8_t rhport, uint8_t itf_num)
+{
+  usbd_device_t const* dev = get_dev(rhport);
+
+  TU_VERIFY(itf_num < TU_ARRAY_SIZE(dev->itf_index) && dev->itf_index[itf_num].offset, NULL);
+  return dev->cfg_desc + dev->itf_index[itf_num].offset;
+}
+
+uint16_t usbd_itf_desc_len(uint8_t rhport, uint8_t itf_num)
+{
+  usbd_device_t const* dev = get_dev(rhport);
+
+  TU_VERIFY(itf_num < TU_ARRAY_SIZE(dev->itf_index), 0);
+  return dev->itf_index[itf_num].len;
+}
+
+uint8_t usbd_itf_alt_count(uint8_t rhport, uint8_t itf_num)
+{
+  usbd_device_t const* dev = get_dev(rhport);
+
+  TU_VERIFY(itf_num < TU_ARRAY_SIZE(dev->itf_index), 0);
+  return dev->itf_index[itf_num].alt_count;
+}
+
+uint8_t usbd_edpt_itf(uint8_t rhport, uint8_t ep_addr)
+{
+  usbd_device_t const* dev = get_dev(rhport);
+  uint8_t const epnum = tu_edpt_number(ep_addr);
+
+  TU_VERIFY(epnum < CFG_TUD_EP_MAX, ITF_INVALID);
+  return dev->ep2itf[epnum][tu_edpt_dir(ep_addr)];
+}
+
+//--------------------------------------------------------------------+
+// SOF subscription
+//--------------------------------------------------------------------+
+
+// Enable SOF interrupt when the first consumer comes and disable it when the last one leaves
+static void sof_enable_update(uint8_t rhport)
+{
+  uint8_t const idx = usbd_rhport_idx(rhport);
+
+  bool const en = _usbd_driver_sof || (_usbd_sof[idx].subscriber_count > 0);
+  if ( en == _usbd_sof[idx].enabled ) return;
+
+  _usbd_sof[idx].enabled = en;
+
+  // port may modify the same interrupt mask register in its ISR
+  if ( dcd_sof_enable )
+  {
+    dcd_int_disable(rhport);
+    dcd_sof_enable(rhport, en);
+    dcd_int_enable(rhport);
+  }
+}
+
+bool usbd_sof_subscribe(uint8_t rhport, usbd_sof_cb_t cb)
+{
+  TU_ASSERT(cb);
+
+  uint8_t const idx = usbd_rhport_idx(rhport);
+
+  uint8_t free_idx = CFG_TUD_SOF_SUBSCRIBER_MAX;
+  for ( uint8_t i = 0; i < CFG_TUD_SOF_SUBSCRIBER_MAX; i++ )
+  {
+    // already subscribed
+    if ( _usbd_sof[idx].subscriber[i] == cb ) return true;
+    if ( !_usbd_sof[idx].subscriber[i] && free_idx == CFG_TUD_SOF_SUBSCRIBER_MAX ) free_idx = i;
+  }
+
+  // increase CFG_TUD_SOF_SUBSCRIBER_MAX if this fails
+  TU_ASSERT(free_idx < CFG_TUD_SOF_SUBSCRIBER_MAX);
+
+  _usbd_sof[idx].subscriber[free_idx] = cb;
+  _usbd_sof[idx].subscriber_count++;
+  sof_enable_update(rhport);
+
+  return true;
+}
+
+void usbd_sof_unsubscribe(uint8_t rhport, usbd_sof_cb_t cb)
+{
+  uint8_t const idx = usbd_rhport_idx(rhport);
+
+  for ( uint8_t i = 0; i < CFG_TUD_SOF_SUBSCRIBER_MAX; i++ )
+  {
+    if ( cb && _usbd_sof[idx].subscriber[i] == cb )
+    {
+      _usbd_sof[idx].subscriber[i] = NULL;
+      _usbd_sof[idx].subscriber_count--;
+      sof_enable_update(rhport);
+      return;
+    }
+  }
+}
+
+//--------------------------------------------------------------------+
+// Timer
+//--------------------------------------------------------------------+
+#if CFG_TUD_TIMER
+
+// Active timers of a port sorted by deadline, one list for each time base
+static struct
+{
+  tud_timer_t* ms_list;
+  tud_timer_t* sof_list;
+  uint32_t     frames; // SOF frames counted while there are SOF timers
+}_usbd_timer[TUD_OPT_RHPORT_COUNT];
+
+// deadline wraps around
+static inline bool timer_before(uint32_t a, uint32_t b)
+{
+  return (int32_t) (a - b) < 0;
+}
+
+// Timers can be started from another task than usbd's
+static inline void timer_lock(void)
+{
+#if CFG_TUSB_OS != OPT_OS_NONE
+  osal_mutex_lock(_usbd_mutex, OSAL_TIMEOUT_WAIT_FOREVER);
+#endif
+}
+
+static inline void timer_unlock(void)
+{
+#if CFG_TUSB_OS != OPT_OS_NONE
+  osal_mutex_unlock(_usbd_mutex);
+#endif
+}
+
+static tud_timer_t** timer_list(tud_timer_t const* timer)
+{
+  uint8_t const idx = usbd_rhport_idx(timer->rhport);
+  return timer->sof ? &_usbd_timer[idx].sof_list : &_usbd_timer[idx].ms_list;
+}
+
+static void timer_unlink(tud_timer_t* timer)
+{
+  for ( tud_timer_t** p = timer_list(timer); *p; p = &(*p)->next )
+  {
+    if ( *p == timer )
+    {
+      *p = timer->next;
+      break;
+    }
+  }
+
+  timer->active = false;
+}
+
+static void timer_sof_cb(uint8_t rhport, uint32_t sof_count);
+
+// SOF is only needed while there are SOF timers
+static void timer_sof_update(uint8_t rhport)
+{
+  if ( _usbd_timer[usbd_rhport_idx(rhport)].sof_list )
+  {
+    usbd_sof_subscribe(rhport, timer_sof_cb);
+  }
+  else
+  {
+    usbd_sof_unsubscribe(rhport, timer_sof_cb);
+  }
+}
+
+// Invoke callbacks of expired timers, now is in list's time base
+static void timer_fire(tud_timer_t** list, uint32_t now)
+{
+  while (1)
+  {
+    timer_lock();
+
+    tud_timer_t* timer = *list;
+    if ( !timer || timer_before(now, timer->deadline) )
+    {
+      timer_unlock();
+      return;
+    }
+
+    *list = timer->next;
+    timer->active = false;
+
+    tud_timer_cb_t const func = timer->func;
+    void* const param = timer->param;
+
+    timer_unlock();
+
+    // callback may restart the timer
+    func(param);
+  }
+}
+
+static void timer_sof_cb(uint8_t rhport, uint32_t sof_count)
+{
+  uint8_t const idx = usbd_rhport_idx(rhport);
+
+  _usbd_timer[idx].frames += sof_count;
+  timer_fire(&_usbd_timer[idx].sof_list, _usbd_timer[idx].frames);
+  timer_sof_update(rhport);
+}
+
+static void timer_fire_ms(uint8_t idx)
+{
+  if ( _usbd_timer[idx].ms_list ) timer_fire(&_usbd_timer[idx].ms_list, tusb_hal_millis());
+}
+
+// Time to wait for events until next millisecond timer expires
+static uint32_t timer_wait_ms(uint8_t idx, uint32_t timeout_ms)
+{
+  timer_lock();
+  tud_timer_t const* head = _usbd_timer[idx].ms_list;
+  uint32_t const deadline = head ? head->deadline : 0;
+  timer_unlock();
+
+  if ( !head ) return timeout_ms;
+
+  int32_t const remain = (int32_t) (deadline - tusb_hal_millis());
+  return (remain <= 0) ? 0 : tu_min32((uint32_t) remain, timeout_ms);
+}
+
+bool tud_timer_start_rhport(uint8_t rhport, tud_timer_t* timer, uint32_t delay, bool sof, tud_timer_cb_t func, void* param)
+{
+  TU_ASSERT(timer && func);
+
+  uint8_t const idx = usbd_rhport_idx(rhport);
+
+  timer_lock();
+
+  bool const was_sof = timer->active && timer->sof;
+  uint8_t const was_rhport = timer->rhport;
+
+  if ( timer->active ) timer_unlink(timer);
+
+  timer->func     = func;
+  timer->param    = param;
+  timer->rhport   = rhport;
+  timer->sof      = sof;
+  timer->deadline = (sof ? _usbd_timer[idx].frames : tusb_hal_millis()) + delay;
+  timer->active   = true;
+
+  tud_timer_t** p = timer_list(timer);
+  while ( *p && !timer_before(timer->deadline, (*p)->deadline) ) p = &(*p)->next;
+  timer->next = *p;
+  *p = timer;
+
+  bool const is_first = (_usbd_timer[idx].ms_list == timer);
+
+  timer_unlock();
+
+  if ( was_sof ) timer_sof_update(was_rhport);
+  if ( sof ) timer_sof_update(rhport);
+
+#if CFG_TUSB_OS != OPT_OS_NONE
+  // usbd task may be blocked with a later deadline, wake it up with an empty function call
+  if ( is_first )
+  {
+    dcd_event_t const wakeup = { .rhport = rhport, .event_id = USBD_EVENT_FUNC_CALL };
+    queue_event(&wakeup, false);
+  }
+#else
+  (void) is_first;
+#endif
+
+  return true;
+}
+
+bool tud_timer_start(tud_timer_t* timer, uint32_t delay, bool sof, tud_timer_cb_t func, void* param)
+{
+  return tud_timer_start_rhport(TUD_OPT_RHPORT, timer, delay, sof, func, param);
+}
+
+void tud_timer_stop(tud_timer_t* timer)
+{
+  timer_lock();
+  bool const was_active = timer->active;
+  if ( was_active ) timer_unlink(timer);
+  timer_unlock();
+
+  if ( was_active && timer->sof ) timer_sof_update(timer->rhport);
+}
+
+#endif
+
 //--------------------------------------------------------------------+
 // USBD Endpoint API
 //--------------------------------------------------------------------+
 
 bool usbd_edpt_open(uint8_t rhport, tusb_desc_endpoint_t const * desc_ep)
 {
+  usbd_device_t* dev = get_dev(rhport);
+
   TU_LOG2("  Open EP %02X with Size = %u\r\n", desc_ep->bEndpointAddress, desc_ep->wMaxPacketSize.size);
 
   switch (desc_ep->bmAttributes.xfer)
   {
     case TUSB_XFER_ISOCHRONOUS:
     {
-      uint16_t const max_epsize = (_usbd_dev.speed == TUSB_SPEED_HIGH ? 1024 : 1023);
+      uint16_t const max_epsize = (dev->speed == TUSB_SPEED_HIGH ? 1024 : 1023);
       TU_ASSERT(desc_ep->wMaxPacketSize.size <= max_epsize);
     }
     break;
 
     case TUSB_XFER_BULK:
-      if (_usbd_dev.speed == TUSB_SPEED_HIGH)
+      if (dev->speed == TUSB_SPEED_HIGH)
       {
         // Bulk highspeed must be EXACTLY 512
         TU_ASSERT(desc_ep->wMaxPacketSize.size == 512);
@@ -1148,7 +2516,7 @@ bool usbd_edpt_open(uint8_t rhport, tusb_desc_endpoint_t const * desc_ep)
 
     case TUSB_XFER_INTERRUPT:
     {
-      uint16_t const max_epsize = (_usbd_dev.speed == TUSB_SPEED_HIGH ? 1024 : 64);
+      uint16_t const max_epsize = (dev->speed == TUSB_SPEED_HIGH ? 1024 : 64);
       TU_ASSERT(desc_ep->wMaxPacketSize.size <= max_epsize);
     }
     break;
@@ -1156,28 +2524,67 @@ bool usbd_edpt_open(uint8_t rhport, tusb_desc_endpoint_t const * desc_ep)
     default: return false;
   }
 
+  // iso and interrupt endpoints complete in the high priority lane by default
+  uint8_t const ep_addr = desc_ep->bEndpointAddress;
+  dev->ep_status[tu_edpt_number(ep_addr)][tu_edpt_dir(ep_addr)].high_prio = (desc_ep->bmAttributes.xfer != TUSB_XFER_BULK);
+
+  tu_varclr(&dev->xfer_split[tu_edpt_number(ep_addr)][tu_edpt_dir(ep_addr)]);
+#if CFG_TUD_EDPT_XFER_QUEUE_SZ
+  tu_varclr(&dev->xfer_q[tu_edpt_number(ep_addr)][tu_edpt_dir(ep_addr)]);
+#endif
+#if CFG_TUD_EDPT_ISR_CB
+  dev->isr_cb[tu_edpt_number(ep_addr)][tu_edpt_dir(ep_addr)] = NULL;
+#endif
+
   return dcd_edpt_open(rhport, desc_ep);
 }
 
+void usbd_edpt_set_priority(uint8_t rhport, uint8_t ep_addr, bool high)
+{
+  usbd_device_t* dev = get_dev(rhport);
+
+  dev->ep_status[tu_edpt_number(ep_addr)][tu_edpt_dir(ep_addr)].high_prio = high;
+}
+
+#if CFG_TUD_EDPT_ISR_CB
+bool usbd_edpt_set_isr_cb(uint8_t rhport, uint8_t ep_addr, usbd_edpt_isr_cb_t cb)
+{
+  usbd_device_t* dev = get_dev(rhport);
+
+  uint8_t const epnum = tu_edpt_number(ep_addr);
+  uint8_t const dir   = tu_edpt_dir(ep_addr);
+
+  // control endpoint is always completed by usbd task
+  TU_ASSERT(epnum && epnum < CFG_TUD_EP_MAX);
+
+  // pending transfer would be completed in the wrong context
+  TU_VERIFY(!dev->ep_status[epnum][dir].busy);
+
+  dev->isr_cb[epnum][dir] = cb;
+
+  return true;
+}
+#endif
+
 bool usbd_edpt_claim(uint8_t rhport, uint8_t ep_addr)
 {
-  (void) rhport;
+  usbd_device_t* dev = get_dev(rhport);
 
   uint8_t const epnum = tu_edpt_number(ep_addr);
   uint8_t const dir   = tu_edpt_dir(ep_addr);
 
 #if CFG_TUSB_OS != OPT_OS_NONE
   // pre-check to help reducing mutex lock
-  TU_VERIFY((_usbd_dev.ep_status[epnum][dir].busy == 0) && (_usbd_dev.ep_status[epnum][dir].claimed == 0));
+  TU_VERIFY((dev->ep_status[epnum][dir].busy == 0) && (dev->ep_status[epnum][dir].claimed == 0));
 
   osal_mutex_lock(_usbd_mutex, OSAL_TIMEOUT_WAIT_FOREVER);
 #endif
 
   // can only claim the endpoint if it is not busy and not claimed yet.
-  bool const ret = (_usbd_dev.ep_status[epnum][dir].busy == 0) && (_usbd_dev.ep_status[epnum][dir].claimed == 0);
+  bool const ret = (dev->ep_status[epnum][dir].busy == 0) && (dev->ep_status[epnum][dir].claimed == 0);
   if (ret)
   {
-    _usbd_dev.ep_status[epnum][dir].claimed = 1;
+    dev->ep_status[epnum][dir].claimed = 1;
   }
 
 #if CFG_TUSB_OS != OPT_OS_NONE
@@ -1189,7 +2596,7 @@ bool usbd_edpt_claim(uint8_t rhport, uint8_t ep_addr)
 
 bool usbd_edpt_release(uint8_t rhport, uint8_t ep_addr)
 {
-  (void) rhport;
+  usbd_device_t* dev = get_dev(rhport);
 
   uint8_t const epnum = tu_edpt_number(ep_addr);
   uint8_t const dir   = tu_edpt_dir(ep_addr);
@@ -1199,10 +2606,10 @@ bool usbd_edpt_release(uint8_t rhport, uint8_t ep_addr)
 #endif
 
   // can only release the endpoint if it is claimed and not busy
-  bool const ret = (_usbd_dev.ep_status[epnum][dir].busy == 0) && (_usbd_dev.ep_status[epnum][dir].claimed == 1);
+  bool const ret = (dev->ep_status[epnum][dir].busy == 0) && (dev->ep_status[epnum][dir].claimed == 1);
   if (ret)
   {
-    _usbd_dev.ep_status[epnum][dir].claimed = 0;
+    dev->ep_status[epnum][dir].claimed = 0;
   }
 
 #if CFG_TUSB_OS != OPT_OS_NONE
@@ -1212,87 +2619,339 @@ bool usbd_edpt_release(uint8_t rhport, uint8_t ep_addr)
   return ret;
 }
 
-bool usbd_edpt_xfer(uint8_t rhport, uint8_t ep_addr, uint8_t * buffer, uint16_t total_bytes)
+#if CFG_TUD_EDPT_XFER_QUEUE_SZ
+// Start transfer if endpoint is idle, otherwise append it to endpoint's queue
+static bool xfer_queue_submit(usbd_device_t* dev, uint8_t rhport, uint8_t ep_addr, uint8_t * buffer, uint32_t total_bytes)
+{
+  uint8_t const epnum = tu_edpt_number(ep_addr);
+  uint8_t const dir   = tu_edpt_dir(ep_addr);
+
+  // Attempt to transfer on a stalled endpoint
+  TU_ASSERT(!dev->ep_status[epnum][dir].stalled);
+
+  bool start = false;
+  bool queued = false;
+
+  edpt_int_disable(dev, rhport);
+
+  if ( !dev->xfer_q[epnum][dir].active )
+  {
+    dev->xfer_q[epnum][dir].active = true;
+    start = true;
+  }
+  else if ( dev->xfer_q[epnum][dir].count < CFG_TUD_EDPT_XFER_QUEUE_SZ )
+  {
+    uint8_t const wr_idx = (dev->xfer_q[epnum][dir].rd_idx + dev->xfer_q[epnum][dir].count) % CFG_TUD_EDPT_XFER_QUEUE_SZ;
+    dev->xfer_q[epnum][dir].xfer[wr_idx].buffer      = buffer;
+    dev->xfer_q[epnum][dir].xfer[wr_idx].total_bytes = total_bytes;
+    dev->xfer_q[epnum][dir].count++;
+    queued = true;
+  }
+
+  if ( start || queued )
+  {
+    dev->xfer_q[epnum][dir].inflight++;
+    dev->ep_status[epnum][dir].busy = true;
+  }
+
+  edpt_int_enable(dev, rhport);
+
+  // Queue is full, increase CFG_TUD_EDPT_XFER_QUEUE_SZ or check usbd_edpt_xfer_count() before submitting
+  TU_ASSERT(start || queued);
+
+  if ( queued )
+  {
+    EDPT_LOG2(dev, "queued\r\n");
+    return true;
+  }
+
+  if ( edpt_xfer_start(dev, rhport, ep_addr, buffer, NULL, total_bytes) )
+  {
+    EDPT_LOG2(dev, "OK\r\n");
+    return true;
+  }
+
+  // DCD error, nothing can be queued behind it since endpoint was idle
+  edpt_int_disable(dev, rhport);
+  dev->xfer_q[epnum][dir].active = false;
+  dev->xfer_q[epnum][dir].inflight--;
+  dev->ep_status[epnum][dir].busy = (dev->xfer_q[epnum][dir].inflight > 0);
+  dev->ep_status[epnum][dir].claimed = 0;
+  edpt_int_enable(dev, rhport);
+
+  EDPT_LOG2(dev, "failed\r\n");
+  TU_BREAKPOINT();
+  return false;
+}
+#endif
+
+bool usbd_edpt_xfer(uint8_t rhport, uint8_t ep_addr, uint8_t * buffer, uint32_t total_bytes)
 {
+  usbd_device_t* dev = get_dev(rhport);
+
   uint8_t const epnum = tu_edpt_number(ep_addr);
   uint8_t const dir   = tu_edpt_dir(ep_addr);
 
-  TU_LOG2("  Queue EP %02X with %u bytes ... ", ep_addr, total_bytes);
+  EDPT_LOG2(dev, "  Queue EP %02X with %lu bytes ... ", ep_addr, (unsigned long) total_bytes);
+  TU_TRACE(TU_TRACE_XFER_SUBMIT, rhport, ep_addr, TU_TRACE_XFER_BUFFER, total_bytes);
+
+#if CFG_TUD_EDPT_XFER_QUEUE_SZ
+  if ( epnum ) return xfer_queue_submit(dev, rhport, ep_addr, buffer, total_bytes);
+#endif
 
   // Attempt to transfer on a busy endpoint, sound like an race condition !
-  TU_ASSERT(_usbd_dev.ep_status[epnum][dir].busy == 0);
+  TU_ASSERT(dev->ep_status[epnum][dir].busy == 0);
 
   // Set busy first since the actual transfer can be complete before dcd_edpt_xfer() could return
   // and usbd task can preempt and clear the busy
-  _usbd_dev.ep_status[epnum][dir].busy = true;
+  dev->ep_status[epnum][dir].busy = true;
 
-  if ( dcd_edpt_xfer(rhport, ep_addr, buffer, total_bytes) )
+  if ( edpt_xfer_start(dev, rhport, ep_addr, buffer, NULL, total_bytes) )
   {
-    TU_LOG2("OK\r\n");
+    EDPT_LOG2(dev, "OK\r\n");
     return true;
   }else
   {
     // DCD error, mark endpoint as ready to allow next transfer
-    _usbd_dev.ep_status[epnum][dir].busy = false;
-    _usbd_dev.ep_status[epnum][dir].claimed = 0;
-    TU_LOG2("failed\r\n");
+    dev->ep_status[epnum][dir].busy = false;
+    dev->ep_status[epnum][dir].claimed = 0;
+    EDPT_LOG2(dev, "failed\r\n");
     TU_BREAKPOINT();
     return false;
   }
 }
 
+// Mark idle endpoint busy with a transfer that can not be queued (scatter-gather, fifo) or
+// back to idle if it fails to start. Endpoint is idle, dcd interrupt does not touch its status.
+static void edpt_set_busy(usbd_device_t* dev, uint8_t epnum, uint8_t dir, bool busy)
+{
+  dev->ep_status[epnum][dir].busy = busy;
+  if ( !busy ) dev->ep_status[epnum][dir].claimed = 0;
+
+#if CFG_TUD_EDPT_XFER_QUEUE_SZ
+  dev->xfer_q[epnum][dir].active   = busy;
+  dev->xfer_q[epnum][dir].inflight = busy ? 1 : 0;
+#endif
+}
+
+bool usbd_edpt_xfer_sg(uint8_t rhport, uint8_t ep_addr, tusb_xfer_seg_t const * segs, uint8_t count)
+{
+  usbd_device_t* dev = get_dev(rhport);
+
+  uint8_t const epnum = tu_edpt_number(ep_addr);
+  uint8_t const dir   = tu_edpt_dir(ep_addr);
+
+  TU_ASSERT(epnum && count);
+
+  // single segment is just a normal transfer
+  if ( count == 1 ) return usbd_edpt_xfer(rhport, ep_addr, segs[0].buffer, segs[0].len);
+
+  uint32_t total_bytes = 0;
+  for(uint8_t i=0; i<count; i++) total_bytes += segs[i].len;
+
+  // Scatter-gather transfer can not be queued behind another one
+  TU_ASSERT(usbd_edpt_xfer_count(rhport, ep_addr) == 0);
+
+  if ( dcd_edpt_xfer_sg )
+  {
+    EDPT_LOG2(dev, "  Queue EP %02X with %u segments ... ", ep_addr, count);
+    TU_TRACE(TU_TRACE_XFER_SUBMIT, rhport, ep_addr, TU_TRACE_XFER_SG, total_bytes);
+
+    // Attempt to transfer on a stalled endpoint
+    TU_ASSERT(!dev->ep_status[epnum][dir].stalled);
+
+    edpt_set_busy(dev, epnum, dir, true);
+
+#if CFG_TUD_EDPT_STATS
+    edpt_stats_start(dev, epnum, dir);
+#endif
+
+    if ( dcd_edpt_xfer_sg(rhport, ep_addr, segs, count) )
+    {
+      EDPT_LOG2(dev, "OK\r\n");
+      return true;
+    }
+
+    edpt_set_busy(dev, epnum, dir, false);
+    EDPT_LOG2(dev, "failed\r\n");
+    TU_BREAKPOINT();
+    return false;
+  }
+
+#if CFG_TUD_XFER_SG_BOUNCE_SIZE
+  // Increase CFG_TUD_XFER_SG_BOUNCE_SIZE to fit the whole transfer
+  TU_ASSERT(total_bytes <= CFG_TUD_XFER_SG_BOUNCE_SIZE);
+
+  sg_bounce_t* bounce = sg_bounce_find(rhport, 0);
+  TU_ASSERT(bounce); // all bounce buffers are in use, increase CFG_TUD_XFER_SG_BOUNCE_COUNT
+
+  uint8_t* buf = _sg_bounce_buf[bounce - _sg_bounce];
+
+  if ( dir == TUSB_DIR_IN )
+  {
+    uint8_t* dst = buf;
+    for(uint8_t i=0; i<count; i++)
+    {
+      memcpy(dst, segs[i].buffer, segs[i].len);
+      dst += segs[i].len;
+    }
+  }
+
+  bounce->rhport  = rhport;
+  bounce->ep_addr = ep_addr;
+  bounce->count   = count;
+  bounce->segs    = segs;
+
+  if ( usbd_edpt_xfer(rhport, ep_addr, buf, total_bytes) ) return true;
+
+  bounce->ep_addr = 0;
+  return false;
+#else
+  // DCD has no scatter-gather support, enable CFG_TUD_XFER_SG_BOUNCE_SIZE
+  TU_ASSERT(false);
+#endif
+}
+
+bool usbd_edpt_xfer_fifo(uint8_t rhport, uint8_t ep_addr, tu_fifo_t * ff, uint32_t total_bytes)
+{
+  usbd_device_t* dev = get_dev(rhport);
+
+  uint8_t const epnum = tu_edpt_number(ep_addr);
+  uint8_t const dir   = tu_edpt_dir(ep_addr);
+
+  // IN transfer only sends data already in the FIFO
+  if ( dir == TUSB_DIR_IN ) total_bytes = tu_min32(total_bytes, tu_fifo_count(ff));
+
+  EDPT_LOG2(dev, "  Queue FIFO EP %02X with %lu bytes ... ", ep_addr, (unsigned long) total_bytes);
+  TU_TRACE(TU_TRACE_XFER_SUBMIT, rhport, ep_addr, TU_TRACE_XFER_FIFO, total_bytes);
+
+  // DCD does not support FIFO transfer, disable CFG_TUD_EDPT_XFER_FIFO
+  TU_ASSERT(dcd_edpt_xfer_fifo && epnum);
+
+  // FIFO transfer can not be queued behind another one
+  TU_ASSERT(usbd_edpt_xfer_count(rhport, ep_addr) == 0);
+
+  edpt_set_busy(dev, epnum, dir, true);
+
+  if ( edpt_xfer_start(dev, rhport, ep_addr, NULL, ff, total_bytes) )
+  {
+    EDPT_LOG2(dev, "OK\r\n");
+    return true;
+  }
+
+  edpt_set_busy(dev, epnum, dir, false);
+  EDPT_LOG2(dev, "failed\r\n");
+  TU_BREAKPOINT();
+  return false;
+}
+
+uint8_t usbd_edpt_xfer_count(uint8_t rhport, uint8_t ep_addr)
+{
+  usbd_device_t* dev = get_dev(rhport);
+
+  uint8_t const epnum = tu_edpt_number(ep_addr);
+  uint8_t const dir   = tu_edpt_dir(ep_addr);
+
+#if CFG_TUD_EDPT_XFER_QUEUE_SZ
+  if ( epnum ) return dev->xfer_q[epnum][dir].inflight;
+#endif
+
+  return dev->ep_status[epnum][dir].busy ? 1 : 0;
+}
+
 bool usbd_edpt_busy(uint8_t rhport, uint8_t ep_addr)
 {
-  (void) rhport;
+  usbd_device_t* dev = get_dev(rhport);
+
+  uint8_t const epnum = tu_edpt_number(ep_addr);
+  uint8_t const dir   = tu_edpt_dir(ep_addr);
 
+  return dev->ep_status[epnum][dir].busy;
+}
+
+// Drop transfer state of endpoint: split transfer, queued transfers and scatter-gather bounce
+// buffer. Transfer owned by dcd is aborted by stall or close and will not be continued.
+static void edpt_xfer_abort(usbd_device_t* dev, uint8_t rhport, uint8_t ep_addr)
+{
   uint8_t const epnum = tu_edpt_number(ep_addr);
   uint8_t const dir   = tu_edpt_dir(ep_addr);
 
-  return _usbd_dev.ep_status[epnum][dir].busy;
+  edpt_int_disable(dev, rhport);
+
+  tu_varclr(&dev->xfer_split[epnum][dir]);
+
+#if CFG_TUD_EDPT_XFER_QUEUE_SZ
+  tu_varclr(&dev->xfer_q[epnum][dir]);
+#endif
+
+#if CFG_TUD_XFER_SG_BOUNCE_SIZE
+  sg_bounce_t* bounce = epnum ? sg_bounce_find(rhport, ep_addr) : NULL;
+  if ( bounce ) bounce->ep_addr = 0;
+#endif
+
+  edpt_int_enable(dev, rhport);
 }
 
 void usbd_edpt_stall(uint8_t rhport, uint8_t ep_addr)
 {
+  usbd_device_t* dev = get_dev(rhport);
+
   uint8_t const epnum = tu_edpt_number(ep_addr);
   uint8_t const dir   = tu_edpt_dir(ep_addr);
 
   dcd_edpt_stall(rhport, ep_addr);
-  _usbd_dev.ep_status[epnum][dir].stalled = true;
-  _usbd_dev.ep_status[epnum][dir].busy = true;
+  edpt_xfer_abort(dev, rhport, ep_addr);
+  dev->ep_status[epnum][dir].stalled = true;
+  dev->ep_status[epnum][dir].busy = true;
+
+#if CFG_TUD_EDPT_STATS
+  dev->ep_stats[epnum][dir].stats.stalls++;
+#endif
 }
 
 void usbd_edpt_clear_stall(uint8_t rhport, uint8_t ep_addr)
 {
+  usbd_device_t* dev = get_dev(rhport);
+
   uint8_t const epnum = tu_edpt_number(ep_addr);
   uint8_t const dir   = tu_edpt_dir(ep_addr);
 
   dcd_edpt_clear_stall(rhport, ep_addr);
-  _usbd_dev.ep_status[epnum][dir].stalled = false;
-  _usbd_dev.ep_status[epnum][dir].busy = false;
+  edpt_xfer_abort(dev, rhport, ep_addr);
+  dev->ep_status[epnum][dir].stalled = false;
+  dev->ep_status[epnum][dir].busy = false;
+  dev->ep_status[epnum][dir].claimed = 0;
 }
 
 bool usbd_edpt_stalled(uint8_t rhport, uint8_t ep_addr)
 {
-  (void) rhport;
+  usbd_device_t* dev = get_dev(rhport);
 
   uint8_t const epnum = tu_edpt_number(ep_addr);
   uint8_t const dir   = tu_edpt_dir(ep_addr);
 
-  return _usbd_dev.ep_status[epnum][dir].stalled;
+  return dev->ep_status[epnum][dir].stalled;
 }
 
 /**
  * usbd_edpt_close will disable an endpoint.
  * 
  * In progress transfers on this EP may be delivered after this call.
- * 
+ * Queued transfers are dropped and endpoint is ready for a new transfer once re-opened.
  */
 void usbd_edpt_close(uint8_t rhport, uint8_t ep_addr)
 {
   TU_ASSERT(dcd_edpt_close, /**/);
   TU_LOG2("  CLOSING Endpoint: 0x%02X\r\n", ep_addr);
 
+  usbd_device_t* dev = get_dev(rhport);
+  uint8_t const epnum = tu_edpt_number(ep_addr);
+  uint8_t const dir   = tu_edpt_dir(ep_addr);
+
   dcd_edpt_close(rhport, ep_addr);
+  edpt_xfer_abort(dev, rhport, ep_addr);
+  dev->ep_status[epnum][dir].busy = false;
+  dev->ep_status[epnum][dir].claimed = 0;
 
   return;
 }
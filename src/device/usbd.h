@@ -43,12 +43,99 @@ extern "C" {
 // Init device stack
 bool tud_init (void);
 
-// Task function should be called in main/rtos loop
+// Task function should be called in main/rtos loop.
+// It serves all device ports with OS NONE, only TUD_OPT_RHPORT with an RTOS.
 void tud_task (void);
 
+// Task function with bounded run time, return number of events processed. It returns
+// - after processing max_events events (0 is unlimited), even if more are pending. With OS NONE
+//   the budget is shared by all device ports
+// - when queue is empty: with an RTOS it blocks up to timeout_ms, or until the next timer
+//   deadline, only if no event is processed yet. OS NONE never blocks.
+// tud_task() is tud_task_ext(0, OSAL_TIMEOUT_WAIT_FOREVER)
+uint32_t tud_task_ext(uint16_t max_events, uint32_t timeout_ms);
+
 // Check if there is pending events need proccessing by tud_task()
 bool tud_task_event_ready(void);
 
+// Event queue statistics since last reset
+typedef struct
+{
+  uint32_t queued;          // events queued, coalesced ones are not included
+  uint32_t dropped;         // events lost because their queue was full
+  uint32_t coalesced;       // SOF events merged into an already pending one
+  uint16_t peak_count;      // max number of events pending in the queue
+  uint16_t peak_count_high; // max number of events pending in the high priority lane (CFG_TUD_TASK_HIGH_QUEUE_SZ)
+} tud_task_event_stats_t;
+
+// Get event queue statistics. Counters are updated by the USB ISR, the snapshot is not atomic.
+void tud_task_event_stats(tud_task_event_stats_t* stats);
+
+// Reset event queue statistics, peak counts restart from the current number of pending events
+void tud_task_event_stats_reset(void);
+
+#if CFG_TUD_EDPT_STATS
+// Number of buckets of latency histogram
+#define TUD_EDPT_STATS_HIST_COUNT   8
+
+// Statistics of an endpoint since bus reset or last tud_edpt_stats_reset(). Time values are in unit of
+// tud_edpt_stats_time_cb() and stay 0 if it is not implemented. Also the payload of
+// CFG_TUD_EDPT_STATS_REQUEST vendor request (little endian).
+typedef struct
+{
+  uint32_t bytes;         // bytes transferred, wraps around
+  uint32_t xfers;         // completed transfers
+  uint32_t failed;        // transfers completed with error
+  uint32_t stalls;        // usbd_edpt_stall() calls
+
+  // Time from handing a transfer to the controller to its completion. Bucket 0 counts latency
+  // below 2^CFG_TUD_EDPT_STATS_HIST_SHIFT, each next bucket doubles the limit, last one has no limit.
+  uint32_t latency_hist[TUD_EDPT_STATS_HIST_COUNT];
+  uint32_t latency_max;
+
+  // Time endpoint sat idle between a completion and next transfer submitted by class driver
+  uint32_t idle_count;
+  uint32_t idle_total;
+  uint32_t idle_max;
+} tud_edpt_stats_t;
+
+// Get statistics of an endpoint
+bool tud_edpt_stats_get(uint8_t ep_addr, tud_edpt_stats_t* stats);
+
+// Reset statistics of an endpoint
+void tud_edpt_stats_reset(uint8_t ep_addr);
+#endif
+
+#if CFG_TUD_TIMER
+typedef void (*tud_timer_cb_t)(void* param);
+
+// Timer firing its callback from tud_task(), allocated by caller. Members are private to usbd.
+typedef struct tud_timer_s
+{
+  struct tud_timer_s* next;
+  tud_timer_cb_t func;
+  void*    param;
+  uint32_t deadline; // milliseconds or SOF frames
+  uint8_t  rhport;
+  bool     sof;
+  bool     active;
+} tud_timer_t;
+
+// Start timer to invoke func(param) from tud_task() after delay milliseconds, or delay SOF frames
+// if sof is true (SOF timers do not advance while bus is suspended). Active timer is restarted.
+// Must not be called from interrupt.
+bool tud_timer_start(tud_timer_t* timer, uint32_t delay, bool sof, tud_timer_cb_t func, void* param);
+
+// Stop timer, its callback is not invoked
+void tud_timer_stop(tud_timer_t* timer);
+
+// Check if timer is started and not fired yet
+static inline bool tud_timer_active(tud_timer_t const* timer)
+{
+  return timer->active;
+}
+#endif
+
 // Interrupt handler, name alias to DCD
 extern void dcd_int_handler(uint8_t rhport);
 #define tud_int_handler   dcd_int_handler
@@ -83,6 +170,10 @@ bool tud_disconnect(void);
 // Return false on unsupported MCUs
 bool tud_connect(void);
 
+// Enable/Disable invoking tud_sof_cb() on every SOF, SOF interrupt is only enabled while needed.
+// Return false if there is no free SOF subscriber slot (CFG_TUD_SOF_SUBSCRIBER_MAX)
+bool tud_sof_cb_enable(bool en);
+
 // Carry out Data and Status stage of control transfer
 // - If len = 0, it is equivalent to sending status only
 // - If len > wLength : it will be truncated
@@ -91,6 +182,41 @@ bool tud_control_xfer(uint8_t rhport, tusb_control_request_t const * request, vo
 // Send STATUS (zero length) packet
 bool tud_control_status(uint8_t rhport, tusb_control_request_t const * request);
 
+//--------------------------------------------------------------------+
+// Multiple device ports: API for each rhport when both roothub ports run in device mode
+// (TUD_OPT_RHPORT_COUNT = 2). API without rhport above applies to TUD_OPT_RHPORT.
+//--------------------------------------------------------------------+
+
+// Task function of a device port. With an RTOS it blocks, each port needs its own task.
+void tud_task_rhport(uint8_t rhport);
+uint32_t tud_task_ext_rhport(uint8_t rhport, uint16_t max_events, uint32_t timeout_ms);
+
+void tud_task_event_stats_rhport(uint8_t rhport, tud_task_event_stats_t* stats);
+void tud_task_event_stats_reset_rhport(uint8_t rhport);
+
+tusb_speed_t tud_speed_get_rhport(uint8_t rhport);
+bool tud_connected_rhport(uint8_t rhport);
+bool tud_mounted_rhport(uint8_t rhport);
+bool tud_suspended_rhport(uint8_t rhport);
+
+static inline bool tud_ready_rhport(uint8_t rhport)
+{
+  return tud_mounted_rhport(rhport) && !tud_suspended_rhport(rhport);
+}
+
+bool tud_remote_wakeup_rhport(uint8_t rhport);
+bool tud_disconnect_rhport(uint8_t rhport);
+bool tud_connect_rhport(uint8_t rhport);
+
+#if CFG_TUD_TIMER
+bool tud_timer_start_rhport(uint8_t rhport, tud_timer_t* timer, uint32_t delay, bool sof, tud_timer_cb_t func, void* param);
+#endif
+
+#if CFG_TUD_EDPT_STATS
+bool tud_edpt_stats_get_rhport(uint8_t rhport, uint8_t ep_addr, tud_edpt_stats_t* stats);
+void tud_edpt_stats_reset_rhport(uint8_t rhport, uint8_t ep_addr);
+#endif
+
 //--------------------------------------------------------------------+
 // Application Callbacks (WEAK is optional)
 //--------------------------------------------------------------------+
@@ -128,9 +254,23 @@ TU_ATTR_WEAK void tud_suspend_cb(bool remote_wakeup_en);
 // Invoked when usb bus is resumed
 TU_ATTR_WEAK void tud_resume_cb(void);
 
+// Invoked on SOF if enabled by tud_sof_cb_enable(), sof_count is number of SOFs since last invocation
+TU_ATTR_WEAK void tud_sof_cb(uint32_t sof_count);
+
 // Invoked when received control request with VENDOR TYPE
 TU_ATTR_WEAK bool tud_vendor_control_xfer_cb(uint8_t rhport, uint8_t stage, tusb_control_request_t const * request);
 
+#if CFG_TUD_EDPT_STATS
+// Invoked to timestamp transfers for endpoint statistics, return a free running counter e.g us timer
+// or cycle counter. Called from USB interrupt.
+TU_ATTR_WEAK uint32_t tud_edpt_stats_time_cb(void);
+#endif
+
+#if CFG_TUD_TIMER
+// Millisecond tick of timers e.g SysTick counter, implemented by application
+uint32_t tusb_hal_millis(void);
+#endif
+
 //--------------------------------------------------------------------+
 // Binary Device Object Store (BOS) Descriptor Templates
 //--------------------------------------------------------------------+
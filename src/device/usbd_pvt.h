@@ -69,8 +69,25 @@ bool usbd_edpt_open(uint8_t rhport, tusb_desc_endpoint_t const * desc_ep);
 // Close an endpoint
 void usbd_edpt_close(uint8_t rhport, uint8_t ep_addr);
 
-// Submit a usb transfer
-bool usbd_edpt_xfer(uint8_t rhport, uint8_t ep_addr, uint8_t * buffer, uint16_t total_bytes);
+// Submit a usb transfer. With CFG_TUD_EDPT_XFER_QUEUE_SZ, transfer submitted while endpoint is busy
+// is queued and started as soon as the previous one completes. Buffer must stay valid until its complete.
+// Transfer longer than CFG_TUD_EDPT_XFER_CHUNK_SIZE is split into chunks without involving usbd task,
+// it is complete when all bytes are transferred or a short packet is received.
+bool usbd_edpt_xfer(uint8_t rhport, uint8_t ep_addr, uint8_t * buffer, uint32_t total_bytes);
+
+// Submit a scatter-gather transfer made of count segments e.g a protocol header followed by payload.
+// Segments are sent/received as a single transfer, no ZLP is added (same as usbd_edpt_xfer).
+// Segment array and buffers must stay valid until complete, endpoint must not have transfer pending.
+// Without dcd_edpt_xfer_sg() the segments are copied via bounce buffer (CFG_TUD_XFER_SG_BOUNCE_SIZE).
+bool usbd_edpt_xfer_sg(uint8_t rhport, uint8_t ep_addr, tusb_xfer_seg_t const * segs, uint8_t count);
+
+// Submit a usb transfer from/to a FIFO without a linear buffer, see CFG_TUD_EDPT_XFER_FIFO.
+// Endpoint must not have transfer pending, OUT transfer must fit in FIFO's remaining space.
+// Like usbd_edpt_xfer(), it is submitted to DCD in chunks of CFG_TUD_EDPT_XFER_CHUNK_SIZE.
+bool usbd_edpt_xfer_fifo(uint8_t rhport, uint8_t ep_addr, tu_fifo_t * ff, uint32_t total_bytes);
+
+// Number of transfers submitted on endpoint whose complete callback is not invoked yet
+uint8_t usbd_edpt_xfer_count(uint8_t rhport, uint8_t ep_addr);
 
 // Claim an endpoint before submitting a transfer.
 // If caller does not make any transfer, it must release endpoint for others.
@@ -91,6 +108,19 @@ void usbd_edpt_clear_stall(uint8_t rhport, uint8_t ep_addr);
 // Check if endpoint is stalled
 bool usbd_edpt_stalled(uint8_t rhport, uint8_t ep_addr);
 
+// Select the event lane of endpoint's transfer complete (CFG_TUD_TASK_HIGH_QUEUE_SZ). Iso and interrupt
+// endpoints are high priority when opened, bulk are normal. Must be called after the endpoint is opened.
+void usbd_edpt_set_priority(uint8_t rhport, uint8_t ep_addr, bool high);
+
+// Invoked in dcd interrupt context when transfer of an ISR-direct endpoint is complete
+typedef void (*usbd_edpt_isr_cb_t)(uint8_t rhport, uint8_t ep_addr, xfer_result_t result, uint32_t xferred_bytes);
+
+// Complete transfers of endpoint by invoking cb right from dcd_event_handler() instead of driver's
+// xfer_cb() in usbd task, NULL restores the default (CFG_TUD_EDPT_ISR_CB). Callback must be ISR-safe,
+// it can submit the next transfer and defer heavier work with usbd_defer_func(rhport, ...).
+// Endpoint must not have transfer pending, mode is cleared when endpoint is opened.
+bool usbd_edpt_set_isr_cb(uint8_t rhport, uint8_t ep_addr, usbd_edpt_isr_cb_t cb);
+
 static inline
 bool usbd_edpt_ready(uint8_t rhport, uint8_t ep_addr)
 {
@@ -101,8 +131,53 @@ bool usbd_edpt_ready(uint8_t rhport, uint8_t ep_addr)
 /* Helper
  *------------------------------------------------------------------*/
 
+// Index of device rhport in per-port state arrays of size TUD_OPT_RHPORT_COUNT
+static inline uint8_t usbd_rhport_idx(uint8_t rhport)
+{
+#if TUD_OPT_RHPORT_COUNT > 1
+  return rhport;
+#else
+  (void) rhport;
+  return 0;
+#endif
+}
+
 bool usbd_open_edpt_pair(uint8_t rhport, uint8_t const* p_desc, uint8_t ep_count, uint8_t xfer_type, uint8_t* ep_out, uint8_t* ep_in);
-void usbd_defer_func( osal_task_func_t func, void* param, bool in_isr );
+
+// Defer func to usbd task of rhport, must be called from rhport's interrupt or task context
+void usbd_defer_func(uint8_t rhport, osal_task_func_t func, void* param, bool in_isr);
+
+/*------------------------------------------------------------------*/
+/* Configuration Index
+ * Built once by SET_CONFIGURATION before class drivers are opened,
+ * lookups are O(1) instead of walking the configuration descriptor.
+ *------------------------------------------------------------------*/
+
+// Interface descriptor of alternate setting 0, NULL if interface is not in configuration
+uint8_t const* usbd_itf_desc(uint8_t rhport, uint8_t itf_num);
+
+// Length of interface's descriptors: all alternate settings with their class & endpoint descriptors
+uint16_t usbd_itf_desc_len(uint8_t rhport, uint8_t itf_num);
+
+// Number of alternate settings of interface, 0 if interface is not in configuration
+uint8_t usbd_itf_alt_count(uint8_t rhport, uint8_t itf_num);
+
+// Interface number whose descriptors declare the endpoint, 0xFF if none
+uint8_t usbd_edpt_itf(uint8_t rhport, uint8_t ep_addr);
+
+/*------------------------------------------------------------------*/
+/* SOF
+ *------------------------------------------------------------------*/
+
+// Invoked in usbd task context with number of SOFs received since last invocation (usually 1)
+typedef void (*usbd_sof_cb_t)(uint8_t rhport, uint32_t sof_count);
+
+// Subscribe to SOF, SOF interrupt is enabled as long as there is at least one subscriber.
+// Class driver should subscribe only when it needs SOF e.g when streaming is active.
+bool usbd_sof_subscribe(uint8_t rhport, usbd_sof_cb_t cb);
+
+// Unsubscribe from SOF, SOF interrupt is disabled when the last subscriber is removed
+void usbd_sof_unsubscribe(uint8_t rhport, usbd_sof_cb_t cb);
 
 
 #ifdef __cplusplus
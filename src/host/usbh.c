@@ -32,6 +32,11 @@
 #define CFG_TUH_TASK_QUEUE_SZ   16
 #endif
 
+// Max number of events tuh_task() pops from the queue at once (OPT_OS_NONE only)
+#ifndef CFG_TUH_TASK_EVENT_BATCH
+#define CFG_TUH_TASK_EVENT_BATCH  4
+#endif
+
 //--------------------------------------------------------------------+
 // INCLUDE
 //--------------------------------------------------------------------+
@@ -132,7 +137,8 @@ static osal_queue_t _usbh_q;
 CFG_TUSB_MEM_SECTION TU_ATTR_ALIGNED(4) static uint8_t _usbh_ctrl_buf[CFG_TUSB_HOST_ENUM_BUFFER_SIZE];
 
 //------------- Helper Function Prototypes -------------//
-static bool enum_new_device(hcd_event_t* event);
+static bool enum_new_device(hcd_event_t const * event);
+static void process_event(hcd_event_t const * event);
 
 // from usbh_control.c
 extern bool usbh_control_xfer_cb (uint8_t dev_addr, uint8_t ep_addr, xfer_result_t result, uint32_t xferred_bytes);
@@ -419,69 +425,108 @@ static void usbh_device_unplugged(uint8_t rhport, uint8_t hub_addr, uint8_t hub_
     @endcode
  */
 void tuh_task(void)
+{
+  (void) tuh_task_ext(0, OSAL_TIMEOUT_WAIT_FOREVER);
+}
+
+uint32_t tuh_task_ext(uint16_t max_events, uint32_t timeout_ms)
 {
   // Skip if stack is not initialized
-  if ( !tusb_inited() ) return;
+  if ( !tusb_inited() ) return 0;
 
-  // Loop until there is no more events in the queue
+#if CFG_TUSB_OS == OPT_OS_NONE
+  // Drain the lock-free event queue in batches, each batch releases its queue slots at once
+  enum { EVENT_BATCH = CFG_TUH_TASK_EVENT_BATCH };
+  (void) timeout_ms;
+#else
+  enum { EVENT_BATCH = 1 };
+#endif
+
+  hcd_event_t events[EVENT_BATCH];
+  uint32_t processed = 0;
+
+  // Loop until there is no more events in the queue or budget is used up
   while (1)
   {
-    hcd_event_t event;
-    if ( !osal_queue_receive(_usbh_q, &event) ) return;
-
-    switch (event.event_id)
+    uint16_t batch = EVENT_BATCH;
+    if ( max_events )
     {
-      case HCD_EVENT_DEVICE_ATTACH:
-        // TODO due to the shared _usbh_ctrl_buf, we must complete enumerating
-        // one device before enumerating another one.
-        TU_LOG2("USBH DEVICE ATTACH\r\n");
-        enum_new_device(&event);
-      break;
+      if ( processed >= max_events ) return processed;
+      batch = (uint16_t) tu_min32(batch, max_events - processed);
+    }
 
-      case HCD_EVENT_DEVICE_REMOVE:
-        TU_LOG2("USBH DEVICE REMOVED\r\n");
-        usbh_device_unplugged(event.rhport, event.connection.hub_addr, event.connection.hub_port);
+#if CFG_TUSB_OS == OPT_OS_NONE
+    uint16_t const count = osal_queue_receive_n(_usbh_q, events, batch);
+#else
+    (void) batch;
+    // only block while waiting for the first event, then drain what is queued and return
+    uint32_t const timeout = processed ? OSAL_TIMEOUT_NOTIMEOUT : timeout_ms;
+    uint16_t const count = osal_queue_receive_timeout(_usbh_q, events, timeout) ? 1 : 0;
+#endif
 
-        #if CFG_TUH_HUB
-        // TODO remove
-        if ( event.connection.hub_addr != 0)
-        {
-          // done with hub, waiting for next data on status pipe
-          (void) hub_status_pipe_queue( event.connection.hub_addr );
-        }
-        #endif
-      break;
+    if ( count == 0 ) return processed;
 
-      case HCD_EVENT_XFER_COMPLETE:
-      {
-        usbh_device_t* dev = &_usbh_devices[event.dev_addr];
-        uint8_t const ep_addr = event.xfer_complete.ep_addr;
-        uint8_t const epnum   = tu_edpt_number(ep_addr);
-        uint8_t const ep_dir  = tu_edpt_dir(ep_addr);
+    for ( uint16_t i = 0; i < count; i++ ) process_event(&events[i]);
+    processed += count;
+  }
+}
 
-        TU_LOG2("on EP %02X with %u bytes\r\n", ep_addr, (unsigned int) event.xfer_complete.len);
+// Process an event popped from the queue
+static void process_event(hcd_event_t const * event)
+{
+  switch (event->event_id)
+  {
+    case HCD_EVENT_DEVICE_ATTACH:
+      // TODO due to the shared _usbh_ctrl_buf, we must complete enumerating
+      // one device before enumerating another one.
+      TU_LOG2("USBH DEVICE ATTACH\r\n");
+      enum_new_device(event);
+    break;
 
-        if ( 0 == epnum )
-        {
-          usbh_control_xfer_cb(event.dev_addr, ep_addr, event.xfer_complete.result, event.xfer_complete.len);
-        }else
-        {
-          uint8_t drv_id = dev->ep2drv[epnum][ep_dir];
-          TU_ASSERT(drv_id < USBH_CLASS_DRIVER_COUNT, );
+    case HCD_EVENT_DEVICE_REMOVE:
+      TU_LOG2("USBH DEVICE REMOVED\r\n");
+      usbh_device_unplugged(event->rhport, event->connection.hub_addr, event->connection.hub_port);
 
-          TU_LOG2("%s xfer callback\r\n", usbh_class_drivers[drv_id].name);
-          usbh_class_drivers[drv_id].xfer_cb(event.dev_addr, ep_addr, event.xfer_complete.result, event.xfer_complete.len);
-        }
+      #if CFG_TUH_HUB
+      // TODO remove
+      if ( event->connection.hub_addr != 0)
+      {
+        // done with hub, waiting for next data on status pipe
+        (void) hub_status_pipe_queue( event->connection.hub_addr );
       }
-      break;
+      #endif
+    break;
 
-      case USBH_EVENT_FUNC_CALL:
-        if ( event.func_call.func ) event.func_call.func(event.func_call.param);
-      break;
+    case HCD_EVENT_XFER_COMPLETE:
+    {
+      usbh_device_t* dev = &_usbh_devices[event->dev_addr];
+      uint8_t const ep_addr = event->xfer_complete.ep_addr;
+      uint8_t const epnum   = tu_edpt_number(ep_addr);
+      uint8_t const ep_dir  = tu_edpt_dir(ep_addr);
+
+      TU_LOG2("on EP %02X with %u bytes\r\n", ep_addr, (unsigned int) event->xfer_complete.len);
+
+      if ( 0 == epnum )
+      {
+        usbh_control_xfer_cb(event->dev_addr, ep_addr, event->xfer_complete.result, event->xfer_complete.len);
+      }else
+      {
+        uint8_t drv_id = dev->ep2drv[epnum][ep_dir];
+        TU_ASSERT(drv_id < USBH_CLASS_DRIVER_COUNT, );
 
-      default: break;
+        TU_LOG2("%s xfer callback\r\n", usbh_class_drivers[drv_id].name);
+        usbh_class_drivers[drv_id].xfer_cb(event->dev_addr, ep_addr, event->xfer_complete.result, event->xfer_complete.len);
+      }
     }
+    break;
+
+    case USBH_EVENT_FUNC_CALL:
+      if ( event->func_call.func ) event->func_call.func(event->func_call.param);
+    break;
+
+    default: break;
   }
+
 }
 
 //--------------------------------------------------------------------+
@@ -645,7 +690,7 @@ static bool enum_request_set_addr(void)
   return true;
 }
 
-static bool enum_new_device(hcd_event_t* event)
+static bool enum_new_device(hcd_event_t const * event)
 {
   usbh_device_t* dev0 = &_usbh_devices[0];
   dev0->rhport   = event->rhport; // TODO refractor integrate to device_pool
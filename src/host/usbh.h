@@ -81,6 +81,13 @@ bool tuh_init(void);
 // Task function should be called in main/rtos loop
 void tuh_task(void);
 
+// Task function with bounded run time, return number of events processed. It returns
+// - after processing max_events events (0 is unlimited), even if more are pending
+// - when queue is empty: with an RTOS it blocks up to timeout_ms, only if no event is processed
+//   yet. OS NONE never blocks.
+// tuh_task() is tuh_task_ext(0, OSAL_TIMEOUT_WAIT_FOREVER)
+uint32_t tuh_task_ext(uint16_t max_events, uint32_t timeout_ms);
+
 // Interrupt handler, name alias to HCD
 extern void hcd_int_handler(uint8_t rhport);
 #define tuh_int_handler   hcd_int_handler
@@ -57,12 +57,20 @@ typedef void (*osal_task_func_t)( void * );
   #include "osal_pico.h"
 #elif CFG_TUSB_OS == OPT_OS_RTTHREAD
   #include "osal_rtthread.h"
+#elif CFG_TUSB_OS == OPT_OS_POSIX
+  #include "osal_posix.h"
 #elif CFG_TUSB_OS == OPT_OS_CUSTOM
   #include "tusb_os_custom.h" // implemented by application
 #else
   #error OS is not supported yet
 #endif
 
+// Queue bound to a roothub port. RTOS ports do not need the port and fall back to
+// OSAL_QUEUE_DEF(), OS NONE masks the port's interrupt to lock the queue.
+#ifndef OSAL_QUEUE_DEF_RHPORT
+  #define OSAL_QUEUE_DEF_RHPORT(_role, _rhport, _name, _depth, _type)   OSAL_QUEUE_DEF(_role, _name, _depth, _type)
+#endif
+
 //--------------------------------------------------------------------+
 // OSAL Porting API
 //--------------------------------------------------------------------+
@@ -82,9 +90,21 @@ static inline bool osal_mutex_unlock(osal_mutex_t mutex_hdl);
 //------------- Queue -------------//
 static inline osal_queue_t osal_queue_create(osal_queue_def_t* qdef);
 static inline bool osal_queue_receive(osal_queue_t qhdl, void* data);
+static inline bool osal_queue_receive_timeout(osal_queue_t qhdl, void* data, uint32_t msec); // msec is ignored by OS NONE
 static inline bool osal_queue_send(osal_queue_t qhdl, void const * data, bool in_isr);
 static inline bool osal_queue_empty(osal_queue_t qhdl);
 
+// Custom OS port that only implements osal_queue_receive(): receive waits forever, which
+// tud_task_ext() timeout and CFG_TUD_TIMER millisecond timers need. Port implementing
+// osal_queue_receive_timeout() defines OSAL_QUEUE_RECEIVE_TIMEOUT in tusb_os_custom.h.
+#if CFG_TUSB_OS == OPT_OS_CUSTOM && !defined(OSAL_QUEUE_RECEIVE_TIMEOUT)
+static inline bool osal_queue_receive_timeout(osal_queue_t qhdl, void* data, uint32_t msec)
+{
+  (void) msec;
+  return osal_queue_receive(qhdl, data);
+}
+#endif
+
 #if 0  // TODO remove subtask related macros later
 // Sub Task
 #define OSAL_SUBTASK_BEGIN
@@ -134,9 +134,15 @@ static inline osal_queue_t osal_queue_create(osal_queue_def_t* qdef)
   return xQueueCreateStatic(qdef->depth, qdef->item_sz, (uint8_t*) qdef->buf, &qdef->sq);
 }
 
+static inline bool osal_queue_receive_timeout(osal_queue_t qhdl, void* data, uint32_t msec)
+{
+  uint32_t const ticks = (msec == OSAL_TIMEOUT_WAIT_FOREVER) ? portMAX_DELAY : pdMS_TO_TICKS(msec);
+  return xQueueReceive(qhdl, data, ticks);
+}
+
 static inline bool osal_queue_receive(osal_queue_t qhdl, void* data)
 {
-  return xQueueReceive(qhdl, data, portMAX_DELAY);
+  return osal_queue_receive_timeout(qhdl, data, OSAL_TIMEOUT_WAIT_FOREVER);
 }
 
 static inline bool osal_queue_send(osal_queue_t qhdl, void const * data, bool in_isr)
@@ -125,10 +125,20 @@ static inline osal_queue_t osal_queue_create(osal_queue_def_t* qdef)
   return (osal_queue_t) qdef;
 }
 
-static inline bool osal_queue_receive(osal_queue_t qhdl, void* data)
+static inline bool osal_queue_receive_timeout(osal_queue_t qhdl, void* data, uint32_t msec)
 {
   struct os_event* ev;
-  ev = os_eventq_get(&qhdl->evq);
+
+  if ( msec == OSAL_TIMEOUT_WAIT_FOREVER )
+  {
+    ev = os_eventq_get(&qhdl->evq);
+  }
+  else
+  {
+    struct os_eventq* evq = &qhdl->evq;
+    ev = os_eventq_poll(&evq, 1, os_time_ms_to_ticks32(msec));
+    if ( !ev ) return false;
+  }
 
   memcpy(data, ev->ev_arg, qhdl->item_sz); // copy message
   os_memblock_put(&qhdl->mpool, ev->ev_arg); // put back mem block
@@ -137,6 +147,11 @@ static inline bool osal_queue_receive(osal_queue_t qhdl, void* data)
   return true;
 }
 
+static inline bool osal_queue_receive(osal_queue_t qhdl, void* data)
+{
+  return osal_queue_receive_timeout(qhdl, data, OSAL_TIMEOUT_WAIT_FOREVER);
+}
+
 static inline bool osal_queue_send(osal_queue_t qhdl, void const * data, bool in_isr)
 {
   (void) in_isr;
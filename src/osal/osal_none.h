@@ -101,8 +101,6 @@ static inline bool osal_mutex_unlock(osal_mutex_t mutex_hdl)
 //--------------------------------------------------------------------+
 // QUEUE API
 //--------------------------------------------------------------------+
-#include "common/tusb_fifo.h"
-
 // extern to avoid including dcd.h and hcd.h
 #if TUSB_OPT_DEVICE_ENABLED
 extern void dcd_int_disable(uint8_t rhport);
@@ -114,20 +112,38 @@ extern void hcd_int_disable(uint8_t rhport);
 extern void hcd_int_enable(uint8_t rhport);
 #endif
 
+// Single-producer single-consumer ring: events are produced by the USB ISR and consumed
+// by tud_task()/tuh_task(). Indices run over [0, 2*depth) so that full and empty can be
+// told apart without a spare slot. Each index is written by one side only and published
+// with release/acquire ordering, therefore neither side needs to mask the USB interrupt.
 typedef struct
 {
-    uint8_t role; // device or host
-    tu_fifo_t ff;
+    uint8_t role;   // device or host
+    uint8_t rhport; // roothub port whose interrupt is masked to lock the queue
+    uint16_t item_size;
+    uint16_t depth;
+    uint8_t* buf;
+
+    volatile uint16_t wr_idx; // written by producer only
+    volatile uint16_t rd_idx; // written by consumer only
 }osal_queue_def_t;
 
 typedef osal_queue_def_t* osal_queue_t;
 
-// role device/host is used by OS NONE for mutex (disable usb isr) only
+// role device/host and rhport are used by OS NONE for mutex (disable usb isr) only
 #define OSAL_QUEUE_DEF(_role, _name, _depth, _type)       \
+  OSAL_QUEUE_DEF_RHPORT(_role, ((_role) == OPT_MODE_HOST) ? TUH_OPT_RHPORT : TUD_OPT_RHPORT, _name, _depth, _type)
+
+#define OSAL_QUEUE_DEF_RHPORT(_role, _rhport, _name, _depth, _type) \
   uint8_t _name##_buf[_depth*sizeof(_type)];              \
   osal_queue_def_t _name = {                              \
-    .role = _role,                                        \
-    .ff = TU_FIFO_INIT(_name##_buf, _depth, _type, false) \
+    .role      = _role,                                   \
+    .rhport    = (uint8_t) (_rhport),                     \
+    .item_size = sizeof(_type),                           \
+    .depth     = _depth,                                  \
+    .buf       = _name##_buf,                             \
+    .wr_idx    = 0,                                       \
+    .rd_idx    = 0                                        \
   }
 
 // lock queue by disable USB interrupt
@@ -136,11 +152,11 @@ static inline void _osal_q_lock(osal_queue_t qhdl)
   (void) qhdl;
 
 #if TUSB_OPT_DEVICE_ENABLED
-  if (qhdl->role == OPT_MODE_DEVICE) dcd_int_disable(TUD_OPT_RHPORT);
+  if (qhdl->role == OPT_MODE_DEVICE) dcd_int_disable(qhdl->rhport);
 #endif
 
 #if TUSB_OPT_HOST_ENABLED
-  if (qhdl->role == OPT_MODE_HOST) hcd_int_disable(TUH_OPT_RHPORT);
+  if (qhdl->role == OPT_MODE_HOST) hcd_int_disable(qhdl->rhport);
 #endif
 }
 
@@ -150,36 +166,93 @@ static inline void _osal_q_unlock(osal_queue_t qhdl)
   (void) qhdl;
 
 #if TUSB_OPT_DEVICE_ENABLED
-  if (qhdl->role == OPT_MODE_DEVICE) dcd_int_enable(TUD_OPT_RHPORT);
+  if (qhdl->role == OPT_MODE_DEVICE) dcd_int_enable(qhdl->rhport);
 #endif
 
 #if TUSB_OPT_HOST_ENABLED
-  if (qhdl->role == OPT_MODE_HOST) hcd_int_enable(TUH_OPT_RHPORT);
+  if (qhdl->role == OPT_MODE_HOST) hcd_int_enable(qhdl->rhport);
 #endif
 }
 
+static inline uint16_t _osal_q_advance(osal_queue_t qhdl, uint16_t idx, uint16_t n)
+{
+  uint32_t next = (uint32_t) idx + n;
+  if ( next >= 2u*qhdl->depth ) next -= 2u*qhdl->depth;
+  return (uint16_t) next;
+}
+
+static inline uint16_t _osal_q_count(osal_queue_t qhdl, uint16_t wr_idx, uint16_t rd_idx)
+{
+  return (wr_idx >= rd_idx) ? (uint16_t) (wr_idx - rd_idx) : (uint16_t) (2u*qhdl->depth - (rd_idx - wr_idx));
+}
+
+static inline uint8_t* _osal_q_slot(osal_queue_t qhdl, uint16_t idx)
+{
+  if ( idx >= qhdl->depth ) idx -= qhdl->depth;
+  return qhdl->buf + idx*qhdl->item_size;
+}
+
 static inline osal_queue_t osal_queue_create(osal_queue_def_t* qdef)
 {
-  tu_fifo_clear(&qdef->ff);
+  qdef->wr_idx = qdef->rd_idx = 0;
   return (osal_queue_t) qdef;
 }
 
+// Receive up to max_count items, return number of items received.
+// Lock-free: only the consumer writes rd_idx, released slots are published once per batch.
+static inline uint16_t osal_queue_receive_n(osal_queue_t qhdl, void* data, uint16_t max_count)
+{
+  uint16_t const rd_idx = qhdl->rd_idx;
+  uint16_t const wr_idx = TU_ATOMIC_LOAD_ACQUIRE(&qhdl->wr_idx);
+
+  uint16_t count = tu_min16(_osal_q_count(qhdl, wr_idx, rd_idx), max_count);
+  if ( count == 0 ) return 0;
+
+  // copy out as two linear parts in case the batch wraps around the buffer end
+  uint16_t const rd_ptr = (rd_idx >= qhdl->depth) ? (uint16_t) (rd_idx - qhdl->depth) : rd_idx;
+  uint16_t const lin    = tu_min16(count, (uint16_t) (qhdl->depth - rd_ptr));
+
+  memcpy(data, _osal_q_slot(qhdl, rd_idx), lin*qhdl->item_size);
+  if ( count > lin )
+  {
+    memcpy(((uint8_t*) data) + lin*qhdl->item_size, qhdl->buf, (count - lin)*qhdl->item_size);
+  }
+
+  TU_ATOMIC_STORE_RELEASE(&qhdl->rd_idx, _osal_q_advance(qhdl, rd_idx, count));
+
+  return count;
+}
+
+// There is no blocking without RTOS, msec is ignored
 static inline bool osal_queue_receive(osal_queue_t qhdl, void* data)
 {
-  _osal_q_lock(qhdl);
-  bool success = tu_fifo_read(&qhdl->ff, data);
-  _osal_q_unlock(qhdl);
+  return osal_queue_receive_n(qhdl, data, 1) == 1;
+}
 
-  return success;
+static inline bool osal_queue_receive_timeout(osal_queue_t qhdl, void* data, uint32_t msec)
+{
+  (void) msec;
+  return osal_queue_receive(qhdl, data);
 }
 
 static inline bool osal_queue_send(osal_queue_t qhdl, void const * data, bool in_isr)
 {
+  // ISR is the only producer. A send from thread context masks the USB interrupt so that
+  // it cannot interleave with the ISR writing the same slot.
   if (!in_isr) {
     _osal_q_lock(qhdl);
   }
 
-  bool success = tu_fifo_write(&qhdl->ff, data);
+  uint16_t const wr_idx = qhdl->wr_idx;
+  uint16_t const rd_idx = TU_ATOMIC_LOAD_ACQUIRE(&qhdl->rd_idx);
+
+  bool const success = (_osal_q_count(qhdl, wr_idx, rd_idx) < qhdl->depth);
+
+  if ( success )
+  {
+    memcpy(_osal_q_slot(qhdl, wr_idx), data, qhdl->item_size);
+    TU_ATOMIC_STORE_RELEASE(&qhdl->wr_idx, _osal_q_advance(qhdl, wr_idx, 1));
+  }
 
   if (!in_isr) {
     _osal_q_unlock(qhdl);
@@ -192,9 +265,8 @@ static inline bool osal_queue_send(osal_queue_t qhdl, void const * data, bool in
 
 static inline bool osal_queue_empty(osal_queue_t qhdl)
 {
-  // Skip queue lock/unlock since this function is primarily called
-  // with interrupt disabled before going into low power mode
-  return tu_fifo_empty(&qhdl->ff);
+  // Lock-free, primarily called with interrupt disabled before going into low power mode
+  return TU_ATOMIC_LOAD_ACQUIRE(&qhdl->wr_idx) == qhdl->rd_idx;
 }
 
 #ifdef __cplusplus
@@ -152,6 +152,12 @@ static inline bool osal_queue_receive(osal_queue_t qhdl, void* data)
   return success;
 }
 
+static inline bool osal_queue_receive_timeout(osal_queue_t qhdl, void* data, uint32_t msec)
+{
+  (void) msec; // not blocking
+  return osal_queue_receive(qhdl, data);
+}
+
 static inline bool osal_queue_send(osal_queue_t qhdl, void const * data, bool in_isr)
 {
   // TODO: revisit... docs say that mutexes are never used from IRQ context,
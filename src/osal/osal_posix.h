@@ -0,0 +1,295 @@
+/* 
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2021, Ha Thach (tinyusb.org)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ * This file is part of the TinyUSB stack.
+ */
+
+#ifndef _TUSB_OSAL_POSIX_H_
+#define _TUSB_OSAL_POSIX_H_
+
+// POSIX threads port for hosted (e.g Linux) builds: tud_task()/tuh_task() run in their own
+// thread, "ISR" events are posted from other threads. All waits block on condition variables
+// with real timeouts, timed waits are measured with CLOCK_MONOTONIC except mutex lock which
+// is limited to CLOCK_REALTIME by pthread_mutex_timedlock(). Requires POSIX.1-2008 interfaces
+// e.g -std=gnu99 or -D_POSIX_C_SOURCE=200809L.
+#include <errno.h>
+#include <time.h>
+#include <pthread.h>
+
+#ifdef __cplusplus
+ extern "C" {
+#endif
+
+//--------------------------------------------------------------------+
+// Internal helpers
+//--------------------------------------------------------------------+
+
+// absolute deadline msec from now on clock clk
+static inline void _osal_posix_deadline(clockid_t clk, uint32_t msec, struct timespec* ts)
+{
+  clock_gettime(clk, ts);
+  ts->tv_sec  += (time_t) (msec / 1000);
+  ts->tv_nsec += (long) (msec % 1000) * 1000000L;
+
+  if ( ts->tv_nsec >= 1000000000L )
+  {
+    ts->tv_sec++;
+    ts->tv_nsec -= 1000000000L;
+  }
+}
+
+static inline void _osal_posix_cond_init(pthread_cond_t* cond)
+{
+  pthread_condattr_t attr;
+  pthread_condattr_init(&attr);
+  pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+  pthread_cond_init(cond, &attr);
+  pthread_condattr_destroy(&attr);
+}
+
+// Wait on cond until ready(arg) is true or msec elapsed, mutex must be locked.
+// Return false if timed out
+static inline bool _osal_posix_cond_wait(pthread_cond_t* cond, pthread_mutex_t* mutex,
+                                         bool (*ready)(void const*), void const* arg, uint32_t msec)
+{
+  if ( ready(arg) ) return true;
+  if ( msec == OSAL_TIMEOUT_NOTIMEOUT ) return false;
+
+  if ( msec == OSAL_TIMEOUT_WAIT_FOREVER )
+  {
+    while ( !ready(arg) ) pthread_cond_wait(cond, mutex);
+    return true;
+  }
+
+  struct timespec deadline;
+  _osal_posix_deadline(CLOCK_MONOTONIC, msec, &deadline);
+
+  while ( !ready(arg) )
+  {
+    if ( ETIMEDOUT == pthread_cond_timedwait(cond, mutex, &deadline) ) return ready(arg);
+  }
+
+  return true;
+}
+
+//--------------------------------------------------------------------+
+// TASK API
+//--------------------------------------------------------------------+
+static inline void osal_task_delay(uint32_t msec)
+{
+  struct timespec ts = { .tv_sec = (time_t) (msec / 1000), .tv_nsec = (long) (msec % 1000) * 1000000L };
+
+  // resume sleeping if interrupted by a signal
+  while ( nanosleep(&ts, &ts) && errno == EINTR ) {}
+}
+
+//--------------------------------------------------------------------+
+// Binary Semaphore API
+//--------------------------------------------------------------------+
+typedef struct
+{
+  pthread_mutex_t mutex;
+  pthread_cond_t  cond;
+  bool            available;
+}osal_semaphore_def_t;
+
+typedef osal_semaphore_def_t* osal_semaphore_t;
+
+static inline bool _osal_posix_sem_ready(void const* arg)
+{
+  return ((osal_semaphore_def_t const*) arg)->available;
+}
+
+static inline osal_semaphore_t osal_semaphore_create(osal_semaphore_def_t* semdef)
+{
+  pthread_mutex_init(&semdef->mutex, NULL);
+  _osal_posix_cond_init(&semdef->cond);
+  semdef->available = false;
+  return semdef;
+}
+
+static inline bool osal_semaphore_post(osal_semaphore_t sem_hdl, bool in_isr)
+{
+  (void) in_isr;
+
+  pthread_mutex_lock(&sem_hdl->mutex);
+  sem_hdl->available = true;
+  pthread_cond_signal(&sem_hdl->cond);
+  pthread_mutex_unlock(&sem_hdl->mutex);
+
+  return true;
+}
+
+static inline bool osal_semaphore_wait (osal_semaphore_t sem_hdl, uint32_t msec)
+{
+  pthread_mutex_lock(&sem_hdl->mutex);
+
+  bool const success = _osal_posix_cond_wait(&sem_hdl->cond, &sem_hdl->mutex, _osal_posix_sem_ready, sem_hdl, msec);
+  if ( success ) sem_hdl->available = false;
+
+  pthread_mutex_unlock(&sem_hdl->mutex);
+
+  return success;
+}
+
+static inline void osal_semaphore_reset(osal_semaphore_t const sem_hdl)
+{
+  pthread_mutex_lock(&sem_hdl->mutex);
+  sem_hdl->available = false;
+  pthread_mutex_unlock(&sem_hdl->mutex);
+}
+
+//--------------------------------------------------------------------+
+// MUTEX API
+//--------------------------------------------------------------------+
+typedef pthread_mutex_t osal_mutex_def_t;
+typedef pthread_mutex_t* osal_mutex_t;
+
+static inline osal_mutex_t osal_mutex_create(osal_mutex_def_t* mdef)
+{
+  pthread_mutex_init(mdef, NULL);
+  return mdef;
+}
+
+static inline bool osal_mutex_lock (osal_mutex_t mutex_hdl, uint32_t msec)
+{
+  if ( msec == OSAL_TIMEOUT_WAIT_FOREVER ) return 0 == pthread_mutex_lock(mutex_hdl);
+  if ( msec == OSAL_TIMEOUT_NOTIMEOUT    ) return 0 == pthread_mutex_trylock(mutex_hdl);
+
+  struct timespec deadline;
+  _osal_posix_deadline(CLOCK_REALTIME, msec, &deadline);
+
+  return 0 == pthread_mutex_timedlock(mutex_hdl, &deadline);
+}
+
+static inline bool osal_mutex_unlock(osal_mutex_t mutex_hdl)
+{
+  return 0 == pthread_mutex_unlock(mutex_hdl);
+}
+
+//--------------------------------------------------------------------+
+// QUEUE API
+//--------------------------------------------------------------------+
+
+// role device/host is used by OS NONE for mutex (disable usb isr) only
+#define OSAL_QUEUE_DEF(_role, _name, _depth, _type) \
+  static _type _name##_##buf[_depth];\
+  osal_queue_def_t _name = { .depth = _depth, .item_sz = sizeof(_type), .buf = (uint8_t*) _name##_##buf }
+
+typedef struct
+{
+  uint16_t depth;
+  uint16_t item_sz;
+  uint8_t* buf;
+
+  uint16_t rd_idx;
+  uint16_t count;
+
+  pthread_mutex_t mutex;
+  pthread_cond_t  cond_not_empty;
+  pthread_cond_t  cond_not_full;
+}osal_queue_def_t;
+
+typedef osal_queue_def_t* osal_queue_t;
+
+static inline bool _osal_posix_q_not_empty(void const* arg)
+{
+  return ((osal_queue_def_t const*) arg)->count > 0;
+}
+
+static inline bool _osal_posix_q_not_full(void const* arg)
+{
+  osal_queue_def_t const* qdef = (osal_queue_def_t const*) arg;
+  return qdef->count < qdef->depth;
+}
+
+static inline osal_queue_t osal_queue_create(osal_queue_def_t* qdef)
+{
+  pthread_mutex_init(&qdef->mutex, NULL);
+  _osal_posix_cond_init(&qdef->cond_not_empty);
+  _osal_posix_cond_init(&qdef->cond_not_full);
+  qdef->rd_idx = qdef->count = 0;
+  return qdef;
+}
+
+// Block until an item is available or msec is elapsed, same as other RTOS ports
+static inline bool osal_queue_receive_timeout(osal_queue_t qhdl, void* data, uint32_t msec)
+{
+  pthread_mutex_lock(&qhdl->mutex);
+
+  if ( !_osal_posix_cond_wait(&qhdl->cond_not_empty, &qhdl->mutex, _osal_posix_q_not_empty, qhdl, msec) )
+  {
+    pthread_mutex_unlock(&qhdl->mutex);
+    return false;
+  }
+
+  memcpy(data, qhdl->buf + qhdl->rd_idx*qhdl->item_sz, qhdl->item_sz);
+  qhdl->rd_idx = (uint16_t) ((qhdl->rd_idx + 1) % qhdl->depth);
+  qhdl->count--;
+
+  pthread_cond_signal(&qhdl->cond_not_full);
+  pthread_mutex_unlock(&qhdl->mutex);
+
+  return true;
+}
+
+static inline bool osal_queue_receive(osal_queue_t qhdl, void* data)
+{
+  return osal_queue_receive_timeout(qhdl, data, OSAL_TIMEOUT_WAIT_FOREVER);
+}
+
+// Thread context blocks while queue is full, ISR context fails instead
+static inline bool osal_queue_send(osal_queue_t qhdl, void const * data, bool in_isr)
+{
+  pthread_mutex_lock(&qhdl->mutex);
+
+  bool const success = _osal_posix_cond_wait(&qhdl->cond_not_full, &qhdl->mutex, _osal_posix_q_not_full, qhdl,
+                                             in_isr ? OSAL_TIMEOUT_NOTIMEOUT : OSAL_TIMEOUT_WAIT_FOREVER);
+  if ( success )
+  {
+    uint16_t const wr_idx = (uint16_t) ((qhdl->rd_idx + qhdl->count) % qhdl->depth);
+    memcpy(qhdl->buf + wr_idx*qhdl->item_sz, data, qhdl->item_sz);
+    qhdl->count++;
+
+    pthread_cond_signal(&qhdl->cond_not_empty);
+  }
+
+  pthread_mutex_unlock(&qhdl->mutex);
+
+  return success;
+}
+
+static inline bool osal_queue_empty(osal_queue_t qhdl)
+{
+  pthread_mutex_lock(&qhdl->mutex);
+  bool const empty = (qhdl->count == 0);
+  pthread_mutex_unlock(&qhdl->mutex);
+
+  return empty;
+}
+
+#ifdef __cplusplus
+ }
+#endif
+
+#endif /* _TUSB_OSAL_POSIX_H_ */
@@ -117,7 +117,7 @@ static void edpt_dma_start(volatile uint32_t* reg_startep)
     if (SCB->ICSR & SCB_ICSR_VECTACTIVE_Msk)
     {
       // Called within ISR, use usbd task to defer later
-      usbd_defer_func( (osal_task_func_t) edpt_dma_start, (void*) reg_startep, true );
+      usbd_defer_func(0, (osal_task_func_t) edpt_dma_start, (void*) reg_startep, true );
       return;
     }
     else
@@ -29,10 +29,6 @@
 
 #include "tusb_option.h"
 
-// Since TinyUSB doesn't use SOF for now, and this interrupt too often (1ms interval)
-// We disable SOF for now until needed later on
-#define USE_SOF     0
-
 #if defined (STM32F105x8) || defined (STM32F105xB) || defined (STM32F105xC) || \
     defined (STM32F107xB) || defined (STM32F107xC)
 #define STM32F1_SYNOPSYS
@@ -135,6 +131,8 @@ static TU_ATTR_ALIGNED(4) uint32_t _setup_packet[2];
 
 typedef struct {
   uint8_t * buffer;
+  tu_fifo_t * ff;       // transfer from/to FIFO instead of buffer (dcd_edpt_xfer_fifo)
+  bool ff_overflow;     // OUT data did not fit into ff and was dropped, transfer is reported failed
   uint16_t total_len;
   uint16_t max_size;
   uint8_t interval;
@@ -496,7 +494,9 @@ void dcd_init (uint8_t rhport)
 
   usb_otg->GINTMSK |= USB_OTG_GINTMSK_USBRST   | USB_OTG_GINTMSK_ENUMDNEM |
       USB_OTG_GINTMSK_USBSUSPM | USB_OTG_GINTMSK_WUIM     |
-      USB_OTG_GINTMSK_RXFLVLM  | (USE_SOF ? USB_OTG_GINTMSK_SOFM : 0);
+      USB_OTG_GINTMSK_RXFLVLM;
+
+  // SOF interrupt is too often (1ms interval), it is only enabled by dcd_sof_enable() when needed
 
   // Enable global interrupt
   usb_otg->GAHBCFG |= USB_OTG_GAHBCFG_GINT;
@@ -548,6 +548,23 @@ void dcd_disconnect(uint8_t rhport)
   dev->DCTL |= USB_OTG_DCTL_SDIS;
 }
 
+void dcd_sof_enable(uint8_t rhport, bool en)
+{
+  (void) rhport;
+  USB_OTG_GlobalTypeDef * usb_otg = GLOBAL_BASE(rhport);
+
+  if ( en )
+  {
+    // clear stale SOF before unmasking
+    usb_otg->GINTSTS = USB_OTG_GINTSTS_SOF;
+    usb_otg->GINTMSK |= USB_OTG_GINTMSK_SOFM;
+  }
+  else
+  {
+    usb_otg->GINTMSK &= ~USB_OTG_GINTMSK_SOFM;
+  }
+}
+
 
 /*------------------------------------------------------------------*/
 /* DCD Endpoint port
@@ -637,6 +654,23 @@ bool dcd_edpt_open (uint8_t rhport, tusb_desc_endpoint_t const * desc_edpt)
   return true;
 }
 
+// Schedule all packets of a non-control endpoint transfer
+static void edpt_schedule_xfer(uint8_t rhport, uint8_t const epnum, uint8_t const dir, uint16_t total_bytes)
+{
+  xfer_ctl_t * const xfer = XFER_CTL_BASE(epnum, dir);
+
+  uint16_t num_packets = (total_bytes / xfer->max_size);
+  uint8_t const short_packet_size = total_bytes % xfer->max_size;
+
+  // Zero-size packet is special case.
+  if(short_packet_size > 0 || (total_bytes == 0)) {
+    num_packets++;
+  }
+
+  // Schedule packets to be sent within interrupt
+  edpt_schedule_packets(rhport, epnum, dir, num_packets, total_bytes);
+}
+
 bool dcd_edpt_xfer (uint8_t rhport, uint8_t ep_addr, uint8_t * buffer, uint16_t total_bytes)
 {
   uint8_t const epnum = tu_edpt_number(ep_addr);
@@ -644,6 +678,8 @@ bool dcd_edpt_xfer (uint8_t rhport, uint8_t ep_addr, uint8_t * buffer, uint16_t
 
   xfer_ctl_t * xfer = XFER_CTL_BASE(epnum, dir);
   xfer->buffer      = buffer;
+  xfer->ff          = NULL;
+  xfer->ff_overflow = false;
   xfer->total_len   = total_bytes;
 
   // EP0 can only handle one packet
@@ -654,16 +690,31 @@ bool dcd_edpt_xfer (uint8_t rhport, uint8_t ep_addr, uint8_t * buffer, uint16_t
     return true;
   }
 
-  uint16_t num_packets = (total_bytes / xfer->max_size);
-  uint8_t const short_packet_size = total_bytes % xfer->max_size;
+  edpt_schedule_xfer(rhport, epnum, dir, total_bytes);
 
-  // Zero-size packet is special case.
-  if(short_packet_size > 0 || (total_bytes == 0)) {
-    num_packets++;
-  }
+  return true;
+}
 
-  // Schedule packets to be sent within interrupt
-  edpt_schedule_packets(rhport, epnum, dir, num_packets, total_bytes);
+// Packets are moved between the FIFO and the endpoint's hardware FIFO register in the interrupt
+// handler, there is no intermediate buffer.
+bool dcd_edpt_xfer_fifo (uint8_t rhport, uint8_t ep_addr, tu_fifo_t * ff, uint16_t total_bytes)
+{
+  uint8_t const epnum = tu_edpt_number(ep_addr);
+  uint8_t const dir   = tu_edpt_dir(ep_addr);
+
+  // EP0 transfers are split into single packets, it is served by usbd_control linear buffer only
+  TU_ASSERT(epnum);
+
+  // Only whole packets can be written to Tx-FIFO, IN transfer is limited to data already in ff
+  if ( dir == TUSB_DIR_IN ) total_bytes = (uint16_t) tu_min32(total_bytes, tu_fifo_count(ff));
+
+  xfer_ctl_t * xfer = XFER_CTL_BASE(epnum, dir);
+  xfer->buffer      = NULL;
+  xfer->ff          = ff;
+  xfer->ff_overflow = false;
+  xfer->total_len   = total_bytes;
+
+  edpt_schedule_xfer(rhport, epnum, dir, total_bytes);
 
   return true;
 }
@@ -867,10 +918,23 @@ static void handle_rxflvl_ints(uint8_t rhport, USB_OTG_OUTEndpointTypeDef * out_
       xfer_ctl_t * xfer = XFER_CTL_BASE(epnum, TUSB_DIR_OUT);
 
       // Read packet off RxFIFO
-      read_fifo_packet(rhport, xfer->buffer, bcnt);
+      if(xfer->ff) {
+        uint16_t const written = (uint16_t) tu_fifo_write_n_const_addr(xfer->ff, (void const *) rx_fifo, bcnt);
 
-      // Increment pointer to xfer data
-      xfer->buffer += bcnt;
+        if(written < bcnt) {
+          // FIFO is full: the whole packet must still be popped off RxFIFO. Dropped bytes are not
+          // reported as received and the transfer completes as failed (also counted by FIFO stats)
+          for(uint16_t w = (written + 3) / 4; w < (bcnt + 3) / 4; w++) (void) (*rx_fifo);
+
+          xfer->total_len -= (bcnt - written);
+          xfer->ff_overflow = true;
+        }
+      } else {
+        read_fifo_packet(rhport, xfer->buffer, bcnt);
+
+        // Increment pointer to xfer data
+        xfer->buffer += bcnt;
+      }
 
       // Truncate transfer length in case of short packet
       if(bcnt < xfer->max_size) {
@@ -925,7 +989,7 @@ static void handle_epout_ints(uint8_t rhport, USB_OTG_DeviceTypeDef * dev, USB_O
           // Schedule another packet to be received.
           edpt_schedule_packets(rhport, n, TUSB_DIR_OUT, 1, ep0_pending[TUSB_DIR_OUT]);
         } else {
-          dcd_event_xfer_complete(rhport, n, xfer->total_len, XFER_RESULT_SUCCESS, true);
+          dcd_event_xfer_complete(rhport, n, xfer->total_len, xfer->ff_overflow ? XFER_RESULT_FAILED : XFER_RESULT_SUCCESS, true);
         }
       }
     }
@@ -978,10 +1042,16 @@ static void handle_epin_ints(uint8_t rhport, USB_OTG_DeviceTypeDef * dev, USB_OT
           }
 
           // Push packet to Tx-FIFO
-          write_fifo_packet(rhport, n, xfer->buffer, packet_size);
-
-          // Increment pointer to xfer data
-          xfer->buffer += packet_size;
+          if(xfer->ff) {
+            // data is available since transfer length is limited to FIFO count when scheduled
+            usb_fifo_t tx_fifo = FIFO_BASE(rhport, n);
+            tu_fifo_read_n_const_addr(xfer->ff, (void *) tx_fifo, packet_size);
+          } else {
+            write_fifo_packet(rhport, n, xfer->buffer, packet_size);
+
+            // Increment pointer to xfer data
+            xfer->buffer += packet_size;
+          }
         }
 
         // Turn off TXFE if all bytes are written.
@@ -1047,13 +1117,11 @@ void dcd_int_handler(uint8_t rhport)
     usb_otg->GOTGINT = otg_int;
   }
 
-#if USE_SOF
-  if(int_status & USB_OTG_GINTSTS_SOF)
+  if((int_status & USB_OTG_GINTSTS_SOF) && (usb_otg->GINTMSK & USB_OTG_GINTMSK_SOFM))
   {
     usb_otg->GINTSTS = USB_OTG_GINTSTS_SOF;
     dcd_event_bus_signal(rhport, DCD_EVENT_SOF, true);
   }
-#endif
 
   // RxFIFO non-empty interrupt handling.
   if(int_status & USB_OTG_GINTSTS_RXFLVL)
@@ -60,6 +60,51 @@ bool tusb_inited(void)
   return _initialized;
 }
 
+/*------------------------------------------------------------------*/
+/* Trace
+ *------------------------------------------------------------------*/
+#if CFG_TUSB_TRACE
+
+TU_VERIFY_STATIC(CFG_TUSB_TRACE_DEPTH > 0 && CFG_TUSB_TRACE_DEPTH <= UINT16_MAX, "invalid trace depth");
+
+tu_trace_ring_t tu_trace_ring =
+{
+  .magic    = TU_TRACE_MAGIC,
+  .depth    = CFG_TUSB_TRACE_DEPTH,
+  .rec_size = sizeof(tu_trace_rec_t),
+};
+
+void tu_trace_write(uint8_t id, uint8_t rhport, uint8_t addr, uint8_t arg8, uint32_t arg32)
+{
+  // Claim the slot before filling it, an interrupt preempting us then writes the next slot
+  // instead of corrupting this one.
+#if defined(__GCC_ATOMIC_INT_LOCK_FREE) && (__GCC_ATOMIC_INT_LOCK_FREE == 2)
+  uint32_t const n = __atomic_fetch_add(&tu_trace_ring.wr_count, 1, __ATOMIC_RELAXED);
+#else
+  // No atomic increment (e.g Cortex-M0): a record can be lost if an interrupt
+  // writes its own between the read and the write back.
+  uint32_t const n = tu_trace_ring.wr_count;
+  tu_trace_ring.wr_count = n + 1;
+#endif
+
+  tu_trace_rec_t* rec = &tu_trace_ring.rec[n % CFG_TUSB_TRACE_DEPTH];
+
+  rec->timestamp = tusb_trace_timestamp_cb ? tusb_trace_timestamp_cb() : 0;
+  rec->id        = id;
+  rec->rhport    = rhport;
+  rec->addr      = addr;
+  rec->arg8      = arg8;
+  rec->arg32     = arg32;
+}
+
+void tu_trace_clear(void)
+{
+  tu_trace_ring.wr_count = 0;
+  tu_memclr(tu_trace_ring.rec, sizeof(tu_trace_ring.rec));
+}
+
+#endif
+
 /*------------------------------------------------------------------*/
 /* Debug
  *------------------------------------------------------------------*/
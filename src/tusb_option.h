@@ -122,6 +122,7 @@
 #define OPT_OS_CUSTOM     4  ///< Custom OS is implemented by application
 #define OPT_OS_PICO       5  ///< Raspberry Pi Pico SDK
 #define OPT_OS_RTTHREAD   6  ///< RT-Thread
+#define OPT_OS_POSIX      7  ///< POSIX threads, for hosted builds e.g Linux
 /** @} */
 
 
@@ -163,19 +164,25 @@
   #define CFG_TUSB_RHPORT1_MODE OPT_MODE_NONE
 #endif
 
-#if (((CFG_TUSB_RHPORT0_MODE) & OPT_MODE_HOST  ) && ((CFG_TUSB_RHPORT1_MODE) & OPT_MODE_HOST  )) || \
-    (((CFG_TUSB_RHPORT0_MODE) & OPT_MODE_DEVICE) && ((CFG_TUSB_RHPORT1_MODE) & OPT_MODE_DEVICE))
-  #error "TinyUSB currently does not support same modes on more than 1 roothub port"
+#if ((CFG_TUSB_RHPORT0_MODE) & OPT_MODE_HOST) && ((CFG_TUSB_RHPORT1_MODE) & OPT_MODE_HOST)
+  #error "TinyUSB currently does not support host mode on more than 1 roothub port"
 #endif
 
 // Which roothub port is configured as host
 #define TUH_OPT_RHPORT          ( ((CFG_TUSB_RHPORT0_MODE) & OPT_MODE_HOST) ? 0 : (((CFG_TUSB_RHPORT1_MODE) & OPT_MODE_HOST) ? 1 : -1) )
 #define TUSB_OPT_HOST_ENABLED   ( TUH_OPT_RHPORT >= 0 )
 
-// Which roothub port is configured as device
+// Which roothub port is configured as device, the first one if both are.
+// It is the port used by device API without rhport parameter e.g tud_mounted()
 #define TUD_OPT_RHPORT          ( ((CFG_TUSB_RHPORT0_MODE) & OPT_MODE_DEVICE) ? 0 : (((CFG_TUSB_RHPORT1_MODE) & OPT_MODE_DEVICE) ? 1 : -1) )
 
-#if TUD_OPT_RHPORT == 0
+// Number of roothub ports configured as device, each runs its own device stack
+#define TUD_OPT_RHPORT_COUNT    ( (((CFG_TUSB_RHPORT0_MODE) & OPT_MODE_DEVICE) ? 1 : 0) + (((CFG_TUSB_RHPORT1_MODE) & OPT_MODE_DEVICE) ? 1 : 0) )
+
+#if TUD_OPT_RHPORT_COUNT > 1
+// Class buffers are sized for the fastest device port
+#define TUD_OPT_HIGH_SPEED      ( ((CFG_TUSB_RHPORT0_MODE) | (CFG_TUSB_RHPORT1_MODE)) & OPT_MODE_HIGH_SPEED )
+#elif TUD_OPT_RHPORT == 0
 #define TUD_OPT_HIGH_SPEED      ( (CFG_TUSB_RHPORT0_MODE) & OPT_MODE_HIGH_SPEED )
 #else
 #define TUD_OPT_HIGH_SPEED      ( (CFG_TUSB_RHPORT1_MODE) & OPT_MODE_HIGH_SPEED )
@@ -213,6 +220,30 @@
   #define CFG_TUD_ENDPOINT0_SIZE  64
 #endif
 
+// Class drivers transfer between endpoints and their FIFOs with usbd_edpt_xfer_fifo() instead of
+// linear endpoint buffers. Requires a DCD implementing dcd_edpt_xfer_fifo() e.g stm32 synopsys.
+// CDC tx fifo is then never overwritable, data written while terminal is not connected is dropped.
+#ifndef CFG_TUD_EDPT_XFER_FIFO
+  #define CFG_TUD_EDPT_XFER_FIFO  0
+#endif
+
+// Keep per-endpoint statistics (bytes, transfers, stalls, latency, idle time), see tud_edpt_stats_get()
+#ifndef CFG_TUD_EDPT_STATS
+  #define CFG_TUD_EDPT_STATS      0
+#endif
+
+// Complete transfers of selected endpoints in dcd interrupt context instead of usbd task,
+// see usbd_edpt_set_isr_cb()
+#ifndef CFG_TUD_EDPT_ISR_CB
+  #define CFG_TUD_EDPT_ISR_CB     0
+#endif
+
+// Timers invoking callbacks from tud_task(), see tud_timer_start(). Requires tusb_hal_millis()
+// implemented by application.
+#ifndef CFG_TUD_TIMER
+  #define CFG_TUD_TIMER           0
+#endif
+
 #ifndef CFG_TUD_CDC
   #define CFG_TUD_CDC             0
 #endif
@@ -0,0 +1,627 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2021, Ha Thach (tinyusb.org)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ * This file is part of the TinyUSB stack.
+ */
+
+// tu_fifo host benchmark
+// - throughput of write_n/read_n/peek_at_n across item size, depth (power of two
+//   or not), chunk size, overwritable mode and wrap around position
+// - multi-channel interleave/deinterleave of PCM samples: per sample read_n/write_n
+//   loop (as formerly used by the audio driver) versus read_n/write_n_interleaved
+// - randomized producer/consumer stress with one writer and one reader thread,
+//   every item carries its sequence number and is verified by the reader
+//
+// usage: fifo_bench [--csv | --json] [--quick] [--stress-seconds N] [--seed N]
+// exit code is non-zero if the stress test detected an error
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <sched.h>
+#include <pthread.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define HAS_CYCLE_COUNTER   1
+#else
+#define HAS_CYCLE_COUNTER   0
+#endif
+
+#include "tusb_common.h"
+#include "osal/osal.h"
+#include "tusb_fifo.h"
+
+//--------------------------------------------------------------------+
+// Measurement
+//--------------------------------------------------------------------+
+typedef struct
+{
+  uint64_t ns;
+  uint64_t cycles;
+} stamp_t;
+
+static inline stamp_t stamp_now(void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+
+  stamp_t st =
+  {
+    .ns     = (uint64_t) ts.tv_sec * 1000000000ull + (uint64_t) ts.tv_nsec,
+#if HAS_CYCLE_COUNTER
+    .cycles = __rdtsc()
+#else
+    .cycles = 0
+#endif
+  };
+  return st;
+}
+
+static inline void stamp_accumulate(stamp_t* acc, stamp_t start)
+{
+  stamp_t const end = stamp_now();
+  acc->ns     += end.ns - start.ns;
+  acc->cycles += end.cycles - start.cycles;
+}
+
+//--------------------------------------------------------------------+
+// Reporting
+//--------------------------------------------------------------------+
+typedef enum
+{
+  FORMAT_CSV,
+  FORMAT_JSON
+} format_t;
+
+typedef struct
+{
+  char const* kind;     // "throughput", "interleave" or "stress"
+  char const* op;
+  uint16_t item_size;   // sample size for interleave
+  uint8_t channels;     // 1 except for interleave
+  uint32_t depth;       // 0 for randomized
+  uint32_t chunk;       // 0 for randomized
+  bool overwritable;
+  bool wrap;
+  uint64_t count;       // number of operations (throughput) or items (stress)
+  uint64_t bytes;
+  stamp_t elapsed;
+  bool ok;
+} result_t;
+
+static format_t _format = FORMAT_CSV;
+static uint32_t _result_count = 0;
+
+static void report_begin(void)
+{
+  if ( _format == FORMAT_CSV )
+  {
+    printf("kind,op,item_size,channels,depth,chunk,overwritable,wrap,count,ns_per_op,mbytes_per_s,bytes_per_cycle,spsc,wide_index,status\n");
+  }
+  else
+  {
+    printf("{\n  \"config\": { \"spsc\": %d, \"wide_index\": %d, \"cycle_counter\": %d },\n  \"results\": [\n",
+           CFG_TUSB_FIFO_SPSC, CFG_TUSB_FIFO_WIDE_INDEX, HAS_CYCLE_COUNTER);
+  }
+}
+
+static void report(result_t const* r)
+{
+  double const ns_per_op    = r->count ? (double) r->elapsed.ns / (double) r->count : 0;
+  double const mbytes_per_s = r->elapsed.ns ? (double) r->bytes * 1000.0 / (double) r->elapsed.ns : 0;
+  double const bytes_per_cy = (HAS_CYCLE_COUNTER && r->elapsed.cycles) ? (double) r->bytes / (double) r->elapsed.cycles : 0;
+
+  if ( _format == FORMAT_CSV )
+  {
+    printf("%s,%s,%u,%u,%u,%u,%d,%d,%llu,%.2f,%.1f,", r->kind, r->op, r->item_size, r->channels, r->depth, r->chunk,
+           r->overwritable, r->wrap, (unsigned long long) r->count, ns_per_op, mbytes_per_s);
+    if ( HAS_CYCLE_COUNTER ) printf("%.3f", bytes_per_cy);
+    printf(",%d,%d,%s\n", CFG_TUSB_FIFO_SPSC, CFG_TUSB_FIFO_WIDE_INDEX, r->ok ? "ok" : "fail");
+  }
+  else
+  {
+    printf("%s    { \"kind\": \"%s\", \"op\": \"%s\", \"item_size\": %u, \"channels\": %u, \"depth\": %u, \"chunk\": %u, "
+           "\"overwritable\": %s, \"wrap\": %s, \"count\": %llu, \"ns_per_op\": %.2f, \"mbytes_per_s\": %.1f, ",
+           _result_count ? ",\n" : "", r->kind, r->op, r->item_size, r->channels, r->depth, r->chunk,
+           r->overwritable ? "true" : "false", r->wrap ? "true" : "false", (unsigned long long) r->count,
+           ns_per_op, mbytes_per_s);
+    if ( HAS_CYCLE_COUNTER ) printf("\"bytes_per_cycle\": %.3f, ", bytes_per_cy);
+    else                     printf("\"bytes_per_cycle\": null, ");
+    printf("\"status\": \"%s\" }", r->ok ? "ok" : "fail");
+  }
+
+  _result_count++;
+  fflush(stdout);
+}
+
+static void report_end(void)
+{
+  if ( _format == FORMAT_JSON ) printf("\n  ]\n}\n");
+}
+
+//--------------------------------------------------------------------+
+// Throughput
+//--------------------------------------------------------------------+
+static uint64_t _min_ns = 20000000; // minimum measuring time per configuration
+
+// Each round fills the FIFO with write_n() in chunks, peeks every chunk with
+// peek_at_n() and drains it with read_n(). Without wrap, chunks line up with the
+// buffer end. With wrap, the FIFO starts half a chunk before the end so that one
+// chunk per round is split into linear and wrapped part.
+static void bench_throughput(uint16_t item_size, uint32_t depth, uint32_t chunk, bool overwritable, bool wrap)
+{
+  uint8_t* ff_buf = malloc(depth * item_size);
+  uint8_t* buf    = malloc(chunk * item_size);
+  memset(buf, 0xa5, chunk * item_size);
+
+  // zero so that no mutex is configured in OSAL=posix builds
+  tu_fifo_t ff;
+  memset(&ff, 0, sizeof(ff));
+  tu_fifo_config(&ff, ff_buf, (tu_fifo_idx_t) depth, item_size, overwritable);
+
+  uint32_t const nchunk = depth / chunk;
+  tu_fifo_idx_t const start = wrap ? (tu_fifo_idx_t) (depth - chunk/2) : 0;
+
+  stamp_t t_write = { 0, 0 }, t_read = { 0, 0 }, t_peek = { 0, 0 };
+  uint64_t ops = 0;
+  bool ok = true;
+
+  while ( t_write.ns + t_read.ns + t_peek.ns < _min_ns )
+  {
+    // place read/write pointers to start position
+    tu_fifo_clear(&ff);
+    tu_fifo_advance_write_pointer(&ff, start);
+    tu_fifo_advance_read_pointer(&ff, start);
+
+    stamp_t st = stamp_now();
+    for(uint32_t i=0; i < nchunk; i++) ok &= (tu_fifo_write_n(&ff, buf, (tu_fifo_idx_t) chunk) == chunk);
+    stamp_accumulate(&t_write, st);
+
+    st = stamp_now();
+    for(uint32_t i=0; i < nchunk; i++) ok &= (tu_fifo_peek_at_n(&ff, (tu_fifo_idx_t) (i*chunk), buf, (tu_fifo_idx_t) chunk) == chunk);
+    stamp_accumulate(&t_peek, st);
+
+    st = stamp_now();
+    for(uint32_t i=0; i < nchunk; i++) ok &= (tu_fifo_read_n(&ff, buf, (tu_fifo_idx_t) chunk) == chunk);
+    stamp_accumulate(&t_read, st);
+
+    ops += nchunk;
+  }
+
+  result_t r =
+  {
+    .kind = "throughput", .item_size = item_size, .channels = 1, .depth = depth, .chunk = chunk,
+    .overwritable = overwritable, .wrap = wrap, .count = ops, .bytes = ops * chunk * item_size, .ok = ok
+  };
+
+  r.op = "write_n";   r.elapsed = t_write; report(&r);
+  r.op = "peek_at_n"; r.elapsed = t_peek;  report(&r);
+  r.op = "read_n";    r.elapsed = t_read;  report(&r);
+
+  free(buf);
+  free(ff_buf);
+}
+
+static void run_throughput(void)
+{
+  static uint16_t const item_sizes[] = { 1, 2, 4, 8, 64 };
+  static uint32_t const depths[]     = { 256, 250 };
+  static uint32_t const chunks[]     = { 1, 16, 64 };
+
+  for(size_t s=0; s < TU_ARRAY_SIZE(item_sizes); s++)
+  {
+    for(size_t d=0; d < TU_ARRAY_SIZE(depths); d++)
+    {
+      for(size_t c=0; c < TU_ARRAY_SIZE(chunks); c++)
+      {
+        for(int ow=0; ow < 2; ow++)
+        {
+          for(int wrap=0; wrap < 2; wrap++)
+          {
+            // single item can't be split
+            if ( wrap && chunks[c] == 1 ) continue;
+            bench_throughput(item_sizes[s], depths[d], chunks[c], ow, wrap);
+          }
+        }
+      }
+    }
+  }
+}
+
+//--------------------------------------------------------------------+
+// Interleave
+//--------------------------------------------------------------------+
+#define IL_MAX_CHANNELS   8
+#define IL_FF_SIZE        1024
+
+// Former audio driver encoding: one read_n() per sample and channel
+static tu_fifo_idx_t interleave_loop(tu_fifo_t ff[], uint8_t n_ff, uint8_t* buf, tu_fifo_idx_t n_samples,
+                                     uint8_t ff_sample_size, uint8_t sample_size)
+{
+  uint32_t sample;
+
+  for(tu_fifo_idx_t i = 0; i < n_samples; i++)
+  {
+    for(uint8_t c = 0; c < n_ff; c++)
+    {
+      tu_fifo_read_n(&ff[c], &sample, ff_sample_size);
+      memcpy(buf, &sample, sample_size);
+      buf += sample_size;
+    }
+  }
+
+  return n_samples;
+}
+
+// Former audio driver decoding: one write_n() per sample and channel
+static tu_fifo_idx_t deinterleave_loop(tu_fifo_t ff[], uint8_t n_ff, uint8_t const* buf, tu_fifo_idx_t n_samples,
+                                       uint8_t ff_sample_size, uint8_t sample_size)
+{
+  uint32_t sample = 0;
+
+  for(tu_fifo_idx_t i = 0; i < n_samples; i++)
+  {
+    for(uint8_t c = 0; c < n_ff; c++)
+    {
+      memcpy(&sample, buf, sample_size);
+      tu_fifo_write_n(&ff[c], &sample, ff_sample_size);
+      buf += sample_size;
+    }
+  }
+
+  return n_samples;
+}
+
+// Each round deinterleaves packets of samples_per_packet frames into the channel
+// FIFOs until they are full and interleaves them back, the packet data is compared.
+static void bench_interleave(uint8_t channels, uint8_t sample_size, uint32_t samples_per_packet)
+{
+  static uint8_t ff_buf[IL_MAX_CHANNELS][IL_FF_SIZE];
+  tu_fifo_t ff[IL_MAX_CHANNELS];
+
+  uint8_t const ff_sample_size = (sample_size == 3) ? 4 : sample_size;
+  uint32_t const packet_size   = samples_per_packet * channels * sample_size;
+  uint32_t const npacket       = IL_FF_SIZE / (samples_per_packet * ff_sample_size);
+
+  uint8_t* packet = malloc(packet_size);
+  uint8_t* rd     = malloc(packet_size);
+  for(uint32_t i = 0; i < packet_size; i++) packet[i] = (uint8_t) rand();
+
+  memset(ff, 0, sizeof(ff));
+  for(uint8_t c = 0; c < channels; c++) tu_fifo_config(&ff[c], ff_buf[c], IL_FF_SIZE, 1, false);
+
+  for(int impl = 0; impl < 2; impl++)
+  {
+    stamp_t t_write = { 0, 0 }, t_read = { 0, 0 };
+    uint64_t ops = 0;
+    bool ok = true;
+
+    while ( t_write.ns + t_read.ns < _min_ns )
+    {
+      stamp_t st = stamp_now();
+      for(uint32_t i = 0; i < npacket; i++)
+      {
+        tu_fifo_idx_t const n = impl ? tu_fifo_write_n_interleaved(ff, channels, packet, (tu_fifo_idx_t) samples_per_packet, ff_sample_size, sample_size)
+                                     : deinterleave_loop(ff, channels, packet, (tu_fifo_idx_t) samples_per_packet, ff_sample_size, sample_size);
+        ok &= (n == samples_per_packet);
+      }
+      stamp_accumulate(&t_write, st);
+
+      for(uint32_t i = 0; i < npacket; i++)
+      {
+        memset(rd, 0, packet_size);
+
+        st = stamp_now();
+        tu_fifo_idx_t const n = impl ? tu_fifo_read_n_interleaved(ff, channels, rd, (tu_fifo_idx_t) samples_per_packet, ff_sample_size, sample_size)
+                                     : interleave_loop(ff, channels, rd, (tu_fifo_idx_t) samples_per_packet, ff_sample_size, sample_size);
+        stamp_accumulate(&t_read, st);
+
+        ok &= (n == samples_per_packet) && !memcmp(packet, rd, packet_size);
+      }
+
+      ops += npacket;
+    }
+
+    result_t r =
+    {
+      .kind = "interleave", .item_size = sample_size, .channels = channels, .depth = IL_FF_SIZE, .chunk = samples_per_packet,
+      .count = ops, .bytes = ops * packet_size, .ok = ok
+    };
+
+    r.op = impl ? "write_n_interleaved" : "write_n_loop"; r.elapsed = t_write; report(&r);
+    r.op = impl ? "read_n_interleaved"  : "read_n_loop";  r.elapsed = t_read;  report(&r);
+  }
+
+  free(rd);
+  free(packet);
+}
+
+static void run_interleave(void)
+{
+  static uint8_t const channels[]      = { 2, 8 };
+  static uint8_t const sample_sizes[]  = { 1, 2, 3, 4 };
+  static uint32_t const samples[]      = { 48, 12 }; // 1 ms at 48 kHz full speed, 125 us microframe high speed
+
+  for(size_t c=0; c < TU_ARRAY_SIZE(channels); c++)
+  {
+    for(size_t s=0; s < TU_ARRAY_SIZE(sample_sizes); s++)
+    {
+      for(size_t n=0; n < TU_ARRAY_SIZE(samples); n++)
+      {
+        bench_interleave(channels[c], sample_sizes[s], samples[n]);
+      }
+    }
+  }
+}
+
+//--------------------------------------------------------------------+
+// Stress
+//--------------------------------------------------------------------+
+#if CFG_TUSB_FIFO_SPSC || CFG_FIFO_MUTEX
+
+typedef struct
+{
+  tu_fifo_t ff;
+  uint16_t item_size;
+  uint32_t depth;
+  uint64_t items;
+  unsigned seed;
+  volatile bool error;
+} stress_t;
+
+// Content of item with sequence number seq: sequence bytes followed by a pattern
+static void item_fill(uint8_t* item, uint16_t item_size, uint64_t seq)
+{
+  for(uint16_t b=0; b < item_size; b++)
+  {
+    item[b] = (b < 8) ? (uint8_t) (seq >> (8*b)) : (uint8_t) (seq * 31 + b);
+  }
+}
+
+static bool item_check(uint8_t const* item, uint16_t item_size, uint64_t seq)
+{
+  uint8_t expected[16];
+  uint16_t const len = tu_min16(item_size, sizeof(expected));
+  item_fill(expected, len, seq);
+  return 0 == memcmp(item, expected, len);
+}
+
+static void* stress_producer(void* arg)
+{
+  stress_t* st = (stress_t*) arg;
+  uint16_t const sz = st->item_size;
+  uint8_t* buf = malloc(st->depth * sz);
+  unsigned seed = st->seed;
+  uint64_t seq = 0;
+
+  while ( seq < st->items && !st->error )
+  {
+    tu_fifo_idx_t n = (tu_fifo_idx_t) (1 + rand_r(&seed) % st->depth);
+    if ( n > st->items - seq ) n = (tu_fifo_idx_t) (st->items - seq);
+
+    tu_fifo_idx_t written;
+    switch ( rand_r(&seed) % 3 )
+    {
+      case 0:
+        for(tu_fifo_idx_t i=0; i < n; i++) item_fill(buf + i*sz, sz, seq + i);
+        written = tu_fifo_write_n(&st->ff, buf, n);
+      break;
+
+      case 1:
+        item_fill(buf, sz, seq);
+        written = tu_fifo_write(&st->ff, buf) ? 1 : 0;
+      break;
+
+      default:
+      {
+        // zero-copy
+        tu_fifo_buffer_info_t info;
+        tu_fifo_get_write_info(&st->ff, &info);
+
+        written = 0;
+        for(tu_fifo_idx_t i=0; i < info.len_lin && written < n; i++, written++)
+        {
+          item_fill((uint8_t*) info.ptr_lin + i*sz, sz, seq + written);
+        }
+        for(tu_fifo_idx_t i=0; i < info.len_wrap && written < n; i++, written++)
+        {
+          item_fill((uint8_t*) info.ptr_wrap + i*sz, sz, seq + written);
+        }
+        tu_fifo_advance_write_pointer(&st->ff, written);
+      }
+      break;
+    }
+
+    seq += written;
+    if ( written == 0 ) sched_yield();
+  }
+
+  free(buf);
+  return NULL;
+}
+
+static bool stress_consumer(stress_t* st)
+{
+  uint16_t const sz = st->item_size;
+  uint8_t* buf  = malloc(st->depth * sz);
+  uint8_t* peek = malloc(st->depth * sz);
+  unsigned seed = st->seed ^ 0x5a5a5a5a;
+  uint64_t seq = 0;
+
+  while ( seq < st->items && !st->error )
+  {
+    tu_fifo_idx_t const n = (tu_fifo_idx_t) (1 + rand_r(&seed) % st->depth);
+    tu_fifo_idx_t count;
+
+    switch ( rand_r(&seed) % 3 )
+    {
+      case 0:
+      {
+        // peek must see the same data as the following read
+        tu_fifo_idx_t const npeek = tu_fifo_peek_at_n(&st->ff, 0, peek, n);
+        count = tu_fifo_read_n(&st->ff, buf, n);
+        if ( count < npeek || memcmp(peek, buf, npeek * sz) ) st->error = true;
+
+        for(tu_fifo_idx_t i=0; i < count; i++)
+        {
+          if ( !item_check(buf + i*sz, sz, seq + i) ) st->error = true;
+        }
+      }
+      break;
+
+      case 1:
+        count = tu_fifo_read(&st->ff, buf) ? 1 : 0;
+        if ( count && !item_check(buf, sz, seq) ) st->error = true;
+      break;
+
+      default:
+      {
+        // zero-copy
+        tu_fifo_buffer_info_t info;
+        tu_fifo_get_read_info(&st->ff, &info);
+
+        count = 0;
+        for(tu_fifo_idx_t i=0; i < info.len_lin && count < n; i++, count++)
+        {
+          if ( !item_check((uint8_t*) info.ptr_lin + i*sz, sz, seq + count) ) st->error = true;
+        }
+        for(tu_fifo_idx_t i=0; i < info.len_wrap && count < n; i++, count++)
+        {
+          if ( !item_check((uint8_t*) info.ptr_wrap + i*sz, sz, seq + count) ) st->error = true;
+        }
+        tu_fifo_advance_read_pointer(&st->ff, count);
+      }
+      break;
+    }
+
+    seq += count;
+    if ( count == 0 ) sched_yield();
+  }
+
+  free(peek);
+  free(buf);
+
+  return !st->error && (seq == st->items) && tu_fifo_empty(&st->ff);
+}
+
+static bool run_stress(uint32_t seconds, unsigned seed)
+{
+  static uint16_t const item_sizes[] = { 1, 2, 3, 4, 8, 12, 64 };
+
+  uint64_t const end_ns = stamp_now().ns + (uint64_t) seconds * 1000000000ull;
+  bool all_ok = true;
+  uint32_t trial = 0;
+
+  do
+  {
+    stress_t st;
+    memset(&st, 0, sizeof(st));
+
+    st.seed      = seed + trial;
+    st.item_size = item_sizes[rand_r(&st.seed) % TU_ARRAY_SIZE(item_sizes)];
+    st.depth     = 1 + rand_r(&st.seed) % 300;
+    st.items     = 200000;
+
+    uint8_t* ff_buf = malloc(st.depth * st.item_size);
+    tu_fifo_config(&st.ff, ff_buf, (tu_fifo_idx_t) st.depth, st.item_size, false);
+
+#if CFG_FIFO_MUTEX
+    osal_mutex_def_t mutex_def;
+    tu_fifo_config_mutex(&st.ff, osal_mutex_create(&mutex_def));
+#endif
+
+    // producer in second thread, consumer in this one
+    stamp_t const start = stamp_now();
+    pthread_t producer;
+    pthread_create(&producer, NULL, stress_producer, &st);
+    bool const ok = stress_consumer(&st);
+    st.error = !ok; // stop producer in case of error
+    pthread_join(producer, NULL);
+
+    result_t r =
+    {
+      .kind = "stress", .op = CFG_FIFO_MUTEX ? "mutex" : "spsc", .item_size = st.item_size, .channels = 1, .depth = st.depth, .chunk = 0,
+      .overwritable = false, .wrap = true, .count = st.items, .bytes = st.items * st.item_size, .ok = ok
+    };
+    stamp_accumulate(&r.elapsed, start);
+    report(&r);
+
+    all_ok &= ok;
+    trial++;
+    free(ff_buf);
+  } while ( stamp_now().ns < end_ns );
+
+  return all_ok;
+}
+
+#endif
+
+//--------------------------------------------------------------------+
+// Main
+//--------------------------------------------------------------------+
+int main(int argc, char* argv[])
+{
+  uint32_t stress_seconds = 5;
+  unsigned seed = (unsigned) time(NULL);
+
+  for(int i=1; i < argc; i++)
+  {
+    if      ( !strcmp(argv[i], "--csv")  ) _format = FORMAT_CSV;
+    else if ( !strcmp(argv[i], "--json") ) _format = FORMAT_JSON;
+    else if ( !strcmp(argv[i], "--quick") )
+    {
+      _min_ns = 2000000;
+      stress_seconds = 1;
+    }
+    else if ( !strcmp(argv[i], "--stress-seconds") && i+1 < argc ) stress_seconds = (uint32_t) atoi(argv[++i]);
+    else if ( !strcmp(argv[i], "--seed") && i+1 < argc ) seed = (unsigned) strtoul(argv[++i], NULL, 0);
+    else
+    {
+      fprintf(stderr, "usage: %s [--csv | --json] [--quick] [--stress-seconds N] [--seed N]\n", argv[0]);
+      return 2;
+    }
+  }
+
+  report_begin();
+
+  run_throughput();
+  run_interleave();
+
+  bool ok = true;
+
+#if CFG_TUSB_FIFO_SPSC || CFG_FIFO_MUTEX
+  if ( stress_seconds ) ok = run_stress(stress_seconds, seed);
+#else
+  // without SPSC ordering or mutex, concurrent access is not supported
+  (void) seed;
+  if ( stress_seconds ) fprintf(stderr, "stress test skipped: build with SPSC=1 or OSAL=posix\n");
+#endif
+
+  report_end();
+
+  if ( !ok ) fprintf(stderr, "stress test FAILED, seed = %u\n", seed);
+
+  return ok ? 0 : 1;
+}
@@ -0,0 +1,432 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2021, Ha Thach (tinyusb.org)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ * This file is part of the TinyUSB stack.
+ */
+
+// OSAL host benchmark, built with CFG_TUSB_OS = OPT_OS_POSIX
+// - queue latency from an "ISR" thread posting with in_isr = true to a task thread
+//   blocked in osal_queue_receive(), as dcd_event_handler() and tud_task() do
+// - semaphore ping-pong round trip between two threads
+// - mutex lock/unlock with 1..N contending threads
+// - tu_fifo write_n/read_n with a mutex on both sides (SPSC=0)
+//
+// usage: osal_bench [--csv | --json] [--quick]
+// exit code is non-zero if any result is inconsistent
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <sched.h>
+#include <pthread.h>
+
+#include "tusb_common.h"
+#include "osal/osal.h"
+#include "tusb_fifo.h"
+
+#if CFG_TUSB_OS != OPT_OS_POSIX
+#error "osal_bench requires CFG_TUSB_OS = OPT_OS_POSIX"
+#endif
+
+//--------------------------------------------------------------------+
+// Measurement
+//--------------------------------------------------------------------+
+static inline uint64_t now_ns(void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t) ts.tv_sec * 1000000000ull + (uint64_t) ts.tv_nsec;
+}
+
+static int cmp_u64(void const* a, void const* b)
+{
+  uint64_t const x = *(uint64_t const*) a;
+  uint64_t const y = *(uint64_t const*) b;
+  return (x > y) - (x < y);
+}
+
+//--------------------------------------------------------------------+
+// Reporting
+//--------------------------------------------------------------------+
+typedef enum
+{
+  FORMAT_CSV,
+  FORMAT_JSON
+} format_t;
+
+typedef struct
+{
+  char const* kind;     // "queue", "semaphore", "mutex" or "fifo"
+  char const* op;
+  uint32_t threads;
+  uint32_t depth;       // queue/fifo depth, 0 otherwise
+  uint64_t count;       // number of operations
+  uint64_t elapsed_ns;
+  uint64_t* samples;    // per operation latency, NULL if not measured
+  bool ok;
+} result_t;
+
+static format_t _format = FORMAT_CSV;
+static uint32_t _result_count = 0;
+static uint32_t _iterations = 200000;
+static bool _all_ok = true;
+
+static void report_begin(void)
+{
+  if ( _format == FORMAT_CSV )
+  {
+    printf("kind,op,threads,depth,count,ns_per_op,min_ns,p50_ns,p99_ns,max_ns,fifo_mutex,status\n");
+  }
+  else
+  {
+    printf("{\n  \"config\": { \"os\": \"posix\", \"fifo_mutex\": %d },\n  \"results\": [\n", CFG_FIFO_MUTEX);
+  }
+}
+
+static void report(result_t const* r)
+{
+  double const ns_per_op = r->count ? (double) r->elapsed_ns / (double) r->count : 0;
+  uint64_t pct[4] = { 0, 0, 0, 0 }; // min, p50, p99, max
+
+  if ( r->samples && r->count )
+  {
+    qsort(r->samples, r->count, sizeof(uint64_t), cmp_u64);
+    pct[0] = r->samples[0];
+    pct[1] = r->samples[r->count / 2];
+    pct[2] = r->samples[(r->count * 99) / 100];
+    pct[3] = r->samples[r->count - 1];
+  }
+
+  if ( _format == FORMAT_CSV )
+  {
+    printf("%s,%s,%u,%u,%llu,%.1f,", r->kind, r->op, r->threads, r->depth, (unsigned long long) r->count, ns_per_op);
+    if ( r->samples ) printf("%llu,%llu,%llu,%llu", (unsigned long long) pct[0], (unsigned long long) pct[1],
+                             (unsigned long long) pct[2], (unsigned long long) pct[3]);
+    else              printf(",,,");
+    printf(",%d,%s\n", CFG_FIFO_MUTEX, r->ok ? "ok" : "fail");
+  }
+  else
+  {
+    printf("%s    { \"kind\": \"%s\", \"op\": \"%s\", \"threads\": %u, \"depth\": %u, \"count\": %llu, \"ns_per_op\": %.1f, ",
+           _result_count ? ",\n" : "", r->kind, r->op, r->threads, r->depth, (unsigned long long) r->count, ns_per_op);
+    if ( r->samples ) printf("\"min_ns\": %llu, \"p50_ns\": %llu, \"p99_ns\": %llu, \"max_ns\": %llu, ",
+                             (unsigned long long) pct[0], (unsigned long long) pct[1],
+                             (unsigned long long) pct[2], (unsigned long long) pct[3]);
+    else              printf("\"min_ns\": null, \"p50_ns\": null, \"p99_ns\": null, \"max_ns\": null, ");
+    printf("\"status\": \"%s\" }", r->ok ? "ok" : "fail");
+  }
+
+  _all_ok &= r->ok;
+  _result_count++;
+  fflush(stdout);
+}
+
+static void report_end(void)
+{
+  if ( _format == FORMAT_JSON ) printf("\n  ]\n}\n");
+}
+
+//--------------------------------------------------------------------+
+// Queue
+//--------------------------------------------------------------------+
+typedef struct
+{
+  uint64_t stamp; // send time
+  uint32_t seq;
+} q_event_t;
+
+#define QUEUE_DEPTH   16
+OSAL_QUEUE_DEF(OPT_MODE_DEVICE, _qdef, QUEUE_DEPTH, q_event_t);
+
+typedef struct
+{
+  osal_queue_t q;
+  uint32_t count;
+  uint32_t burst;   // events posted back to back before pausing
+  volatile uint32_t dropped;
+} q_bench_t;
+
+// Emulated ISR: never blocks, an event is dropped if the queue is full
+static void* queue_isr(void* arg)
+{
+  q_bench_t* qb = (q_bench_t*) arg;
+
+  for(uint32_t seq = 0; seq < qb->count; seq++)
+  {
+    q_event_t ev = { .stamp = now_ns(), .seq = seq };
+    if ( !osal_queue_send(qb->q, &ev, true) ) qb->dropped++;
+
+    if ( (seq + 1) % qb->burst == 0 ) sched_yield();
+  }
+
+  // terminate receiver, retry since this one must not be dropped
+  q_event_t const stop = { .stamp = 0, .seq = UINT32_MAX };
+  while ( !osal_queue_send(qb->q, &stop, true) ) sched_yield();
+
+  return NULL;
+}
+
+static void bench_queue(uint32_t burst)
+{
+  q_bench_t qb = { .q = osal_queue_create(&_qdef), .count = _iterations, .burst = burst, .dropped = 0 };
+  uint64_t* samples = malloc(qb.count * sizeof(uint64_t));
+  uint64_t received = 0;
+  uint32_t last_seq = 0;
+  bool ok = true;
+
+  uint64_t const start = now_ns();
+
+  pthread_t isr;
+  pthread_create(&isr, NULL, queue_isr, &qb);
+
+  // task: blocks in receive like tud_task() with an RTOS
+  while (1)
+  {
+    q_event_t ev;
+    osal_queue_receive(qb.q, &ev);
+    if ( ev.seq == UINT32_MAX ) break;
+
+    samples[received++] = now_ns() - ev.stamp;
+    if ( received > 1 && ev.seq <= last_seq ) ok = false; // must be in order
+    last_seq = ev.seq;
+  }
+
+  uint64_t const elapsed = now_ns() - start;
+  pthread_join(isr, NULL);
+
+  result_t r =
+  {
+    .kind = "queue", .op = (burst == 1) ? "isr_send_latency" : "isr_burst_latency", .threads = 2,
+    .depth = QUEUE_DEPTH, .count = received, .elapsed_ns = elapsed, .samples = samples,
+    .ok = ok && (received + qb.dropped == qb.count)
+  };
+  report(&r);
+
+  free(samples);
+}
+
+//--------------------------------------------------------------------+
+// Semaphore
+//--------------------------------------------------------------------+
+static osal_semaphore_def_t _ping_def, _pong_def;
+static osal_semaphore_t _ping, _pong;
+
+static void* sem_pong(void* arg)
+{
+  uint32_t const count = *(uint32_t const*) arg;
+
+  for(uint32_t i = 0; i < count; i++)
+  {
+    osal_semaphore_wait(_ping, OSAL_TIMEOUT_WAIT_FOREVER);
+    osal_semaphore_post(_pong, false);
+  }
+
+  return NULL;
+}
+
+static void bench_semaphore(void)
+{
+  uint32_t count = _iterations / 4;
+  uint64_t* samples = malloc(count * sizeof(uint64_t));
+  bool ok = true;
+
+  _ping = osal_semaphore_create(&_ping_def);
+  _pong = osal_semaphore_create(&_pong_def);
+
+  pthread_t thread;
+  pthread_create(&thread, NULL, sem_pong, &count);
+
+  uint64_t const start = now_ns();
+  for(uint32_t i = 0; i < count; i++)
+  {
+    uint64_t const t0 = now_ns();
+    osal_semaphore_post(_ping, false);
+    ok &= osal_semaphore_wait(_pong, 1000);
+    samples[i] = now_ns() - t0;
+  }
+  uint64_t const elapsed = now_ns() - start;
+
+  pthread_join(thread, NULL);
+
+  result_t r =
+  {
+    .kind = "semaphore", .op = "ping_pong", .threads = 2, .depth = 0,
+    .count = count, .elapsed_ns = elapsed, .samples = samples, .ok = ok
+  };
+  report(&r);
+
+  free(samples);
+}
+
+//--------------------------------------------------------------------+
+// Mutex
+//--------------------------------------------------------------------+
+static osal_mutex_def_t _mutex_def;
+static osal_mutex_t _mutex;
+static uint64_t _shared_counter;
+
+static void* mutex_worker(void* arg)
+{
+  uint32_t const count = *(uint32_t const*) arg;
+
+  for(uint32_t i = 0; i < count; i++)
+  {
+    osal_mutex_lock(_mutex, OSAL_TIMEOUT_WAIT_FOREVER);
+    _shared_counter++;
+    osal_mutex_unlock(_mutex);
+  }
+
+  return NULL;
+}
+
+static void bench_mutex(uint32_t threads)
+{
+  pthread_t workers[8];
+  uint32_t count = _iterations;
+
+  _mutex = osal_mutex_create(&_mutex_def);
+  _shared_counter = 0;
+
+  uint64_t const start = now_ns();
+  for(uint32_t t = 0; t < threads; t++) pthread_create(&workers[t], NULL, mutex_worker, &count);
+  for(uint32_t t = 0; t < threads; t++) pthread_join(workers[t], NULL);
+  uint64_t const elapsed = now_ns() - start;
+
+  result_t r =
+  {
+    .kind = "mutex", .op = "lock_unlock", .threads = threads, .depth = 0,
+    .count = (uint64_t) count * threads, .elapsed_ns = elapsed, .samples = NULL,
+    .ok = (_shared_counter == (uint64_t) count * threads)
+  };
+  report(&r);
+}
+
+//--------------------------------------------------------------------+
+// FIFO with mutex
+//--------------------------------------------------------------------+
+#if CFG_FIFO_MUTEX
+
+#define FIFO_DEPTH  256
+#define FIFO_CHUNK  16
+
+typedef struct
+{
+  tu_fifo_t ff;
+  uint64_t count;
+} fifo_bench_t;
+
+static void* fifo_writer(void* arg)
+{
+  fifo_bench_t* fb = (fifo_bench_t*) arg;
+  uint32_t buf[FIFO_CHUNK];
+  uint64_t seq = 0;
+
+  while ( seq < fb->count )
+  {
+    for(uint32_t i = 0; i < FIFO_CHUNK; i++) buf[i] = (uint32_t) (seq + i);
+
+    uint64_t const remaining = fb->count - seq;
+    tu_fifo_idx_t const n = tu_fifo_write_n(&fb->ff, buf, (tu_fifo_idx_t) (remaining < FIFO_CHUNK ? remaining : FIFO_CHUNK));
+    seq += n;
+    if ( n == 0 ) sched_yield();
+  }
+
+  return NULL;
+}
+
+static void bench_fifo_mutex(void)
+{
+  static uint32_t ff_buf[FIFO_DEPTH];
+  osal_mutex_def_t mutex_def;
+
+  fifo_bench_t fb = { .count = (uint64_t) _iterations * FIFO_CHUNK };
+  tu_fifo_config(&fb.ff, ff_buf, FIFO_DEPTH, sizeof(uint32_t), false);
+  tu_fifo_config_mutex(&fb.ff, osal_mutex_create(&mutex_def));
+
+  bool ok = true;
+  uint64_t seq = 0;
+
+  uint64_t const start = now_ns();
+
+  pthread_t writer;
+  pthread_create(&writer, NULL, fifo_writer, &fb);
+
+  while ( seq < fb.count )
+  {
+    uint32_t buf[FIFO_CHUNK];
+    tu_fifo_idx_t const n = tu_fifo_read_n(&fb.ff, buf, FIFO_CHUNK);
+
+    for(tu_fifo_idx_t i = 0; i < n; i++) ok &= (buf[i] == (uint32_t) (seq + i));
+    seq += n;
+    if ( n == 0 ) sched_yield();
+  }
+
+  pthread_join(writer, NULL);
+  uint64_t const elapsed = now_ns() - start;
+
+  result_t r =
+  {
+    .kind = "fifo", .op = "write_n_read_n", .threads = 2, .depth = FIFO_DEPTH,
+    .count = fb.count / FIFO_CHUNK, .elapsed_ns = elapsed, .samples = NULL, .ok = ok
+  };
+  report(&r);
+}
+
+#endif
+
+//--------------------------------------------------------------------+
+// Main
+//--------------------------------------------------------------------+
+int main(int argc, char* argv[])
+{
+  for(int i=1; i < argc; i++)
+  {
+    if      ( !strcmp(argv[i], "--csv")   ) _format = FORMAT_CSV;
+    else if ( !strcmp(argv[i], "--json")  ) _format = FORMAT_JSON;
+    else if ( !strcmp(argv[i], "--quick") ) _iterations = 20000;
+    else
+    {
+      fprintf(stderr, "usage: %s [--csv | --json] [--quick]\n", argv[0]);
+      return 2;
+    }
+  }
+
+  report_begin();
+
+  bench_queue(1);
+  bench_queue(QUEUE_DEPTH / 2);
+
+  bench_semaphore();
+
+  static uint32_t const threads[] = { 1, 2, 4, 8 };
+  for(uint32_t i = 0; i < TU_ARRAY_SIZE(threads); i++) bench_mutex(threads[i]);
+
+#if CFG_FIFO_MUTEX
+  bench_fifo_mutex();
+#endif
+
+  report_end();
+
+  return _all_ok ? 0 : 1;
+}
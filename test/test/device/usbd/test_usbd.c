@@ -28,6 +28,7 @@
 #include "tusb_fifo.h"
 #include "tusb.h"
 #include "usbd.h"
+#include "device/usbd_pvt.h"
 TEST_FILE("usbd_control.c")
 
 // Mock File
@@ -101,8 +102,12 @@ uint8_t const* desc_configuration;
 //--------------------------------------------------------------------+
 //
 //--------------------------------------------------------------------+
+static uint32_t func_call_count;
+static uint32_t desc_device_func_calls; // func_call_count when device descriptor is requested
+
 uint8_t const * tud_descriptor_device_cb(void)
 {
+  desc_device_func_calls = func_call_count;
   return desc_device;
 }
 
@@ -118,6 +123,40 @@ uint16_t const* tud_descriptor_string_cb(uint8_t index, uint16_t langid)
   return NULL;
 }
 
+//--------------------------------------------------------------------+
+// SOF callback
+//--------------------------------------------------------------------+
+static uint32_t sof_count;
+
+void tud_sof_cb(uint32_t count)
+{
+  sof_count += count;
+}
+
+//--------------------------------------------------------------------+
+// Endpoint statistics timestamp
+//--------------------------------------------------------------------+
+#if CFG_TUD_EDPT_STATS
+static uint32_t stats_time;
+
+uint32_t tud_edpt_stats_time_cb(void)
+{
+  return stats_time;
+}
+#endif
+
+//--------------------------------------------------------------------+
+// Timer tick
+//--------------------------------------------------------------------+
+#if CFG_TUD_TIMER
+static uint32_t millis;
+
+uint32_t tusb_hal_millis(void)
+{
+  return millis;
+}
+#endif
+
 void setUp(void)
 {
   dcd_int_disable_Ignore();
@@ -241,3 +280,742 @@ void test_usbd_control_in_zlp(void)
 
   tud_task();
 }
+
+//--------------------------------------------------------------------+
+// Event Queue
+//--------------------------------------------------------------------+
+static void count_func_call(void* param)
+{
+  // events must be processed in the order they are queued
+  TEST_ASSERT_EQUAL_UINT32(func_call_count, (uint32_t) (uintptr_t) param);
+  func_call_count++;
+}
+
+void test_usbd_event_queue_drain(void)
+{
+  func_call_count = 0;
+
+  // several rounds of more than half the queue depth to wrap around the queue buffer
+  for(uint32_t round = 0; round < 3; round++)
+  {
+    for(uint32_t i = 0; i < CFG_TUD_TASK_QUEUE_SZ/2 + 1; i++)
+    {
+      usbd_defer_func(rhport, count_func_call, (void*) (uintptr_t) (round*(CFG_TUD_TASK_QUEUE_SZ/2 + 1) + i), true);
+    }
+
+    TEST_ASSERT_TRUE(tud_task_event_ready());
+    tud_task();
+
+    TEST_ASSERT_FALSE(tud_task_event_ready());
+    TEST_ASSERT_EQUAL_UINT32((round+1)*(CFG_TUD_TASK_QUEUE_SZ/2 + 1), func_call_count);
+  }
+}
+
+void test_usbd_event_queue_budget(void)
+{
+  func_call_count = 0;
+
+  for(uint32_t i = 0; i < 7; i++) usbd_defer_func(rhport, count_func_call, (void*) (uintptr_t) i, true);
+
+  // returns after max_events even though more are pending
+  TEST_ASSERT_EQUAL_UINT32(3, tud_task_ext(3, 0));
+  TEST_ASSERT_EQUAL_UINT32(3, func_call_count);
+  TEST_ASSERT_TRUE(tud_task_event_ready());
+
+  TEST_ASSERT_EQUAL_UINT32(3, tud_task_ext(3, 0));
+  TEST_ASSERT_EQUAL_UINT32(1, tud_task_ext(3, 0));
+  TEST_ASSERT_EQUAL_UINT32(7, func_call_count);
+
+  TEST_ASSERT_FALSE(tud_task_event_ready());
+  TEST_ASSERT_EQUAL_UINT32(0, tud_task_ext(3, 0));
+}
+
+#if CFG_TUD_TASK_HIGH_QUEUE_SZ
+void test_usbd_event_queue_setup_priority(void)
+{
+  func_call_count = 0;
+  desc_device_func_calls = UINT32_MAX;
+
+  desc_device = (uint8_t const *) &data_desc_device;
+
+  // deferred function calls are queued before the control transfer, but it is in high priority lane
+  for(uint32_t i = 0; i < 8; i++) usbd_defer_func(rhport, count_func_call, (void*) (uintptr_t) i, true);
+  dcd_event_setup_received(rhport, (uint8_t*) &req_get_desc_device, false);
+
+  // data
+  dcd_edpt_xfer_ExpectWithArrayAndReturn(rhport, EDPT_CTRL_IN, (uint8_t*)&data_desc_device, sizeof(tusb_desc_device_t), sizeof(tusb_desc_device_t), true);
+  dcd_event_xfer_complete(rhport, EDPT_CTRL_IN, sizeof(tusb_desc_device_t), 0, false);
+
+  // status
+  dcd_edpt_xfer_ExpectAndReturn(rhport, EDPT_CTRL_OUT, NULL, 0, true);
+  dcd_event_xfer_complete(rhport, EDPT_CTRL_OUT, 0, 0, false);
+  dcd_edpt0_status_complete_ExpectWithArray(rhport, &req_get_desc_device, 1);
+
+  tud_task();
+
+  TEST_ASSERT_EQUAL_UINT32(0, desc_device_func_calls);
+  TEST_ASSERT_EQUAL_UINT32(8, func_call_count);
+}
+#endif
+
+void test_usbd_event_queue_stats(void)
+{
+  tud_task_event_stats_t stats;
+
+  func_call_count = 0;
+  tud_task_event_stats_reset();
+
+  for(uint32_t i = 0; i < 5; i++) usbd_defer_func(rhport, count_func_call, (void*) (uintptr_t) i, true);
+
+  tud_task_event_stats(&stats);
+  TEST_ASSERT_EQUAL_UINT32(5, stats.queued);
+  TEST_ASSERT_EQUAL_UINT32(0, stats.dropped);
+  TEST_ASSERT_EQUAL_UINT16(5, stats.peak_count);
+  TEST_ASSERT_EQUAL_UINT16(0, stats.peak_count_high);
+
+  tud_task();
+
+  // peak is kept after the queue is drained, and restarts from current count on reset
+  tud_task_event_stats(&stats);
+  TEST_ASSERT_EQUAL_UINT16(5, stats.peak_count);
+
+  tud_task_event_stats_reset();
+  tud_task_event_stats(&stats);
+  TEST_ASSERT_EQUAL_UINT32(0, stats.queued);
+  TEST_ASSERT_EQUAL_UINT16(0, stats.peak_count);
+
+  // overflow
+  for(uint32_t i = 0; i < CFG_TUD_TASK_QUEUE_SZ + 2; i++) usbd_defer_func(rhport, count_func_call, (void*) (uintptr_t) (5+i), true);
+
+  tud_task_event_stats(&stats);
+  TEST_ASSERT_EQUAL_UINT32(CFG_TUD_TASK_QUEUE_SZ, stats.queued);
+  TEST_ASSERT_EQUAL_UINT32(2, stats.dropped);
+  TEST_ASSERT_EQUAL_UINT16(CFG_TUD_TASK_QUEUE_SZ, stats.peak_count);
+
+  tud_task();
+  TEST_ASSERT_EQUAL_UINT32(5 + CFG_TUD_TASK_QUEUE_SZ, func_call_count);
+}
+
+void test_usbd_event_queue_sof_coalesce(void)
+{
+  tud_task_event_stats_t stats;
+
+  sof_count = 0;
+  tud_task_event_stats_reset();
+
+  dcd_sof_enable_Expect(rhport, true);
+  TEST_ASSERT_TRUE(tud_sof_cb_enable(true));
+
+  // SOFs are merged while one is pending
+  for(uint32_t i = 0; i < 5; i++) dcd_event_bus_signal(rhport, DCD_EVENT_SOF, true);
+
+  tud_task_event_stats(&stats);
+  TEST_ASSERT_EQUAL_UINT32(1, stats.queued);
+  TEST_ASSERT_EQUAL_UINT32(4, stats.coalesced);
+
+  tud_task();
+  TEST_ASSERT_EQUAL_UINT32(5, sof_count);
+
+  // next SOF is queued again
+  dcd_event_bus_signal(rhport, DCD_EVENT_SOF, true);
+  tud_task();
+  TEST_ASSERT_EQUAL_UINT32(6, sof_count);
+
+  tud_task_event_stats(&stats);
+  TEST_ASSERT_EQUAL_UINT32(2, stats.queued);
+#if CFG_TUD_TASK_HIGH_QUEUE_SZ
+  TEST_ASSERT_EQUAL_UINT16(1, stats.peak_count_high);
+#else
+  TEST_ASSERT_EQUAL_UINT16(1, stats.peak_count);
+#endif
+
+  dcd_sof_enable_Expect(rhport, false);
+  TEST_ASSERT_TRUE(tud_sof_cb_enable(false));
+}
+
+static uint32_t sub_count;
+static void sof_subscriber(uint8_t rhport, uint32_t count) { (void) rhport; sub_count += count; }
+
+void test_usbd_sof_subscribe(void)
+{
+  tud_task_event_stats_t stats;
+
+  sof_count = 0;
+  sub_count = 0;
+  tud_task_event_stats_reset();
+
+  // SOF is dropped without subscriber
+  dcd_event_bus_signal(rhport, DCD_EVENT_SOF, true);
+  tud_task_event_stats(&stats);
+  TEST_ASSERT_EQUAL_UINT32(0, stats.queued);
+
+  // SOF interrupt is enabled by first subscriber only
+  dcd_sof_enable_Expect(rhport, true);
+  TEST_ASSERT_TRUE(usbd_sof_subscribe(rhport, sof_subscriber));
+  TEST_ASSERT_TRUE(usbd_sof_subscribe(rhport, sof_subscriber));
+  TEST_ASSERT_TRUE(tud_sof_cb_enable(true));
+
+  dcd_event_bus_signal(rhport, DCD_EVENT_SOF, true);
+  tud_task();
+  TEST_ASSERT_EQUAL_UINT32(1, sub_count);
+  TEST_ASSERT_EQUAL_UINT32(1, sof_count);
+
+  // and disabled by the last one leaving
+  TEST_ASSERT_TRUE(tud_sof_cb_enable(false));
+
+  dcd_event_bus_signal(rhport, DCD_EVENT_SOF, true);
+  tud_task();
+  TEST_ASSERT_EQUAL_UINT32(2, sub_count);
+  TEST_ASSERT_EQUAL_UINT32(1, sof_count);
+
+  dcd_sof_enable_Expect(rhport, false);
+  usbd_sof_unsubscribe(rhport, sof_subscriber);
+
+  dcd_event_bus_signal(rhport, DCD_EVENT_SOF, true);
+  tud_task();
+  TEST_ASSERT_EQUAL_UINT32(2, sub_count);
+}
+
+//--------------------------------------------------------------------+
+// Timer
+//--------------------------------------------------------------------+
+#if CFG_TUD_TIMER
+static uint32_t timer_fired;
+static void timer_cb(void* param) { timer_fired += (uint32_t) (uintptr_t) param; }
+
+void test_usbd_timer_ms(void)
+{
+  tud_timer_t t1, t2;
+  timer_fired = 0;
+  millis = 0xFFFFFFF0; // deadline wraps around
+
+  TEST_ASSERT_TRUE(tud_timer_start(&t1, 20, false, timer_cb, (void*) 1));
+  TEST_ASSERT_TRUE(tud_timer_start(&t2, 10, false, timer_cb, (void*) 10));
+  TEST_ASSERT_TRUE(tud_timer_active(&t1));
+
+  tud_task();
+  TEST_ASSERT_EQUAL_UINT32(0, timer_fired);
+
+  millis += 10;
+  tud_task();
+  TEST_ASSERT_EQUAL_UINT32(10, timer_fired);
+  TEST_ASSERT_FALSE(tud_timer_active(&t2));
+
+  // restart pushes deadline, stop cancels it
+  TEST_ASSERT_TRUE(tud_timer_start(&t1, 20, false, timer_cb, (void*) 1));
+  TEST_ASSERT_TRUE(tud_timer_start(&t2, 5, false, timer_cb, (void*) 100));
+  tud_timer_stop(&t2);
+
+  millis += 15;
+  tud_task();
+  TEST_ASSERT_EQUAL_UINT32(10, timer_fired);
+
+  millis += 5;
+  tud_task_ext(0, 0);
+  TEST_ASSERT_EQUAL_UINT32(11, timer_fired);
+  TEST_ASSERT_FALSE(tud_timer_active(&t1));
+}
+
+void test_usbd_timer_sof(void)
+{
+  tud_timer_t t;
+  timer_fired = 0;
+
+  // SOF is enabled while there is a SOF timer
+  dcd_sof_enable_Expect(rhport, true);
+  TEST_ASSERT_TRUE(tud_timer_start(&t, 3, true, timer_cb, (void*) 1));
+
+  dcd_event_bus_signal(rhport, DCD_EVENT_SOF, true);
+  dcd_event_bus_signal(rhport, DCD_EVENT_SOF, true);
+  tud_task();
+  TEST_ASSERT_EQUAL_UINT32(0, timer_fired);
+
+  dcd_sof_enable_Expect(rhport, false);
+  dcd_event_bus_signal(rhport, DCD_EVENT_SOF, true);
+  tud_task();
+  TEST_ASSERT_EQUAL_UINT32(1, timer_fired);
+  TEST_ASSERT_FALSE(tud_timer_active(&t));
+}
+#endif
+
+//--------------------------------------------------------------------+
+// Endpoint transfer queue
+//--------------------------------------------------------------------+
+#if CFG_TUD_EDPT_XFER_QUEUE_SZ
+void test_usbd_edpt_xfer_queue(void)
+{
+  uint8_t const ep_addr = 0x81;
+  uint8_t buf[3][64];
+
+  // 1st transfer is started right away, the others are queued behind it
+  dcd_edpt_xfer_ExpectAndReturn(rhport, ep_addr, buf[0], 64, true);
+  TEST_ASSERT_TRUE(usbd_edpt_xfer(rhport, ep_addr, buf[0], 64));
+  TEST_ASSERT_TRUE(usbd_edpt_xfer(rhport, ep_addr, buf[1], 32));
+  TEST_ASSERT_TRUE(usbd_edpt_xfer(rhport, ep_addr, buf[2], 16));
+  TEST_ASSERT_EQUAL_UINT8(3, usbd_edpt_xfer_count(rhport, ep_addr));
+
+  // queue is full
+  TEST_ASSERT_FALSE(usbd_edpt_xfer(rhport, ep_addr, buf[0], 8));
+
+  // next transfer is started by the complete interrupt, without waiting for usbd task
+  dcd_edpt_xfer_ExpectAndReturn(rhport, ep_addr, buf[1], 32, true);
+  dcd_event_xfer_complete(rhport, ep_addr, 64, XFER_RESULT_SUCCESS, true);
+
+  dcd_edpt_xfer_ExpectAndReturn(rhport, ep_addr, buf[2], 16, true);
+  dcd_event_xfer_complete(rhport, ep_addr, 32, XFER_RESULT_SUCCESS, true);
+
+  // endpoint is busy until usbd task has processed all completions
+  TEST_ASSERT_TRUE(usbd_edpt_busy(rhport, ep_addr));
+  dcd_event_xfer_complete(rhport, ep_addr, 16, XFER_RESULT_SUCCESS, true);
+  TEST_ASSERT_TRUE(usbd_edpt_busy(rhport, ep_addr));
+
+  // completions are reported in submission order, endpoint maps to the first driver (msc) after init
+  mscd_xfer_cb_ExpectAndReturn(rhport, ep_addr, XFER_RESULT_SUCCESS, 64, true);
+  mscd_xfer_cb_ExpectAndReturn(rhport, ep_addr, XFER_RESULT_SUCCESS, 32, true);
+  mscd_xfer_cb_ExpectAndReturn(rhport, ep_addr, XFER_RESULT_SUCCESS, 16, true);
+  tud_task();
+  TEST_ASSERT_FALSE(usbd_edpt_busy(rhport, ep_addr));
+  TEST_ASSERT_EQUAL_UINT8(0, usbd_edpt_xfer_count(rhport, ep_addr));
+
+  // endpoint is idle again, transfer is started right away
+  dcd_edpt_xfer_ExpectAndReturn(rhport, ep_addr, buf[0], 64, true);
+  TEST_ASSERT_TRUE(usbd_edpt_xfer(rhport, ep_addr, buf[0], 64));
+  dcd_event_xfer_complete(rhport, ep_addr, 64, XFER_RESULT_SUCCESS, true);
+  mscd_xfer_cb_ExpectAndReturn(rhport, ep_addr, XFER_RESULT_SUCCESS, 64, true);
+  tud_task();
+  TEST_ASSERT_FALSE(usbd_edpt_busy(rhport, ep_addr));
+}
+#endif
+
+//--------------------------------------------------------------------+
+// Stall and close abort pending transfers
+//--------------------------------------------------------------------+
+void test_usbd_edpt_stall_abort(void)
+{
+  uint8_t const ep_addr = 0x86;
+  uint8_t buf[2][64];
+
+  dcd_edpt_xfer_ExpectAndReturn(rhport, ep_addr, buf[0], 64, true);
+  TEST_ASSERT_TRUE(usbd_edpt_xfer(rhport, ep_addr, buf[0], 64));
+#if CFG_TUD_EDPT_XFER_QUEUE_SZ
+  TEST_ASSERT_TRUE(usbd_edpt_xfer(rhport, ep_addr, buf[1], 64));
+#endif
+
+  // transfer in flight and queued ones are dropped
+  dcd_edpt_stall_Expect(rhport, ep_addr);
+  usbd_edpt_stall(rhport, ep_addr);
+  TEST_ASSERT_TRUE(usbd_edpt_stalled(rhport, ep_addr));
+  TEST_ASSERT_FALSE(usbd_edpt_xfer(rhport, ep_addr, buf[1], 64));
+
+  dcd_edpt_clear_stall_Expect(rhport, ep_addr);
+  usbd_edpt_clear_stall(rhport, ep_addr);
+  TEST_ASSERT_FALSE(usbd_edpt_busy(rhport, ep_addr));
+  TEST_ASSERT_EQUAL_UINT8(0, usbd_edpt_xfer_count(rhport, ep_addr));
+
+  // new transfer is started right away
+  dcd_edpt_xfer_ExpectAndReturn(rhport, ep_addr, buf[1], 32, true);
+  TEST_ASSERT_TRUE(usbd_edpt_xfer(rhport, ep_addr, buf[1], 32));
+
+  dcd_event_xfer_complete(rhport, ep_addr, 32, XFER_RESULT_SUCCESS, true);
+  mscd_xfer_cb_ExpectAndReturn(rhport, ep_addr, XFER_RESULT_SUCCESS, 32, true);
+  tud_task();
+  TEST_ASSERT_FALSE(usbd_edpt_busy(rhport, ep_addr));
+}
+
+void test_usbd_edpt_close_reopen(void)
+{
+  uint8_t const ep_addr = 0x07;
+  uint8_t buf[2][64];
+
+  tusb_desc_endpoint_t const desc_ep =
+  {
+    .bLength          = sizeof(tusb_desc_endpoint_t),
+    .bDescriptorType  = TUSB_DESC_ENDPOINT,
+    .bEndpointAddress = ep_addr,
+    .bmAttributes     = { .xfer = TUSB_XFER_BULK },
+    .wMaxPacketSize   = { .size = 64 },
+    .bInterval        = 0
+  };
+
+  dcd_edpt_xfer_ExpectAndReturn(rhport, ep_addr, buf[0], 64, true);
+  TEST_ASSERT_TRUE(usbd_edpt_xfer(rhport, ep_addr, buf[0], 64));
+#if CFG_TUD_EDPT_XFER_QUEUE_SZ
+  TEST_ASSERT_TRUE(usbd_edpt_xfer(rhport, ep_addr, buf[1], 64));
+#endif
+
+  dcd_edpt_close_Expect(rhport, ep_addr);
+  usbd_edpt_close(rhport, ep_addr);
+  TEST_ASSERT_FALSE(usbd_edpt_busy(rhport, ep_addr));
+  TEST_ASSERT_EQUAL_UINT8(0, usbd_edpt_xfer_count(rhport, ep_addr));
+
+  dcd_edpt_open_ExpectAndReturn(rhport, &desc_ep, true);
+  TEST_ASSERT_TRUE(usbd_edpt_open(rhport, &desc_ep));
+
+  // re-opened endpoint starts new transfer right away
+  dcd_edpt_xfer_ExpectAndReturn(rhport, ep_addr, buf[1], 16, true);
+  TEST_ASSERT_TRUE(usbd_edpt_xfer(rhport, ep_addr, buf[1], 16));
+
+  dcd_event_xfer_complete(rhport, ep_addr, 16, XFER_RESULT_SUCCESS, true);
+  mscd_xfer_cb_ExpectAndReturn(rhport, ep_addr, XFER_RESULT_SUCCESS, 16, true);
+  tud_task();
+  TEST_ASSERT_FALSE(usbd_edpt_busy(rhport, ep_addr));
+}
+
+void test_usbd_edpt_xfer_sg(void)
+{
+  uint8_t const ep_addr = 0x82;
+  uint8_t header[8];
+  uint8_t payload[100];
+
+  tusb_xfer_seg_t const segs[] =
+  {
+    { .buffer = header , .len = sizeof(header)  },
+    { .buffer = payload, .len = sizeof(payload) },
+  };
+
+  // single segment is a normal transfer
+  dcd_edpt_xfer_ExpectAndReturn(rhport, ep_addr, header, sizeof(header), true);
+  TEST_ASSERT_TRUE(usbd_edpt_xfer_sg(rhport, ep_addr, segs, 1));
+  dcd_event_xfer_complete(rhport, ep_addr, sizeof(header), XFER_RESULT_SUCCESS, true);
+  mscd_xfer_cb_ExpectAndReturn(rhport, ep_addr, XFER_RESULT_SUCCESS, sizeof(header), true);
+  tud_task();
+
+  // segments are passed to DCD as one transfer
+  dcd_edpt_xfer_sg_ExpectWithArrayAndReturn(rhport, ep_addr, segs, 2, 2, true);
+  TEST_ASSERT_TRUE(usbd_edpt_xfer_sg(rhport, ep_addr, segs, 2));
+  TEST_ASSERT_TRUE(usbd_edpt_busy(rhport, ep_addr));
+
+  // can not be queued behind a pending transfer
+  TEST_ASSERT_FALSE(usbd_edpt_xfer_sg(rhport, ep_addr, segs, 2));
+
+  dcd_event_xfer_complete(rhport, ep_addr, sizeof(header) + sizeof(payload), XFER_RESULT_SUCCESS, true);
+  mscd_xfer_cb_ExpectAndReturn(rhport, ep_addr, XFER_RESULT_SUCCESS, sizeof(header) + sizeof(payload), true);
+  tud_task();
+  TEST_ASSERT_FALSE(usbd_edpt_busy(rhport, ep_addr));
+
+  // total length is not limited to 16-bit
+  tusb_xfer_seg_t const big_segs[] =
+  {
+    { .buffer = payload, .len = 60000 },
+    { .buffer = payload, .len = 60000 },
+  };
+
+  dcd_edpt_xfer_sg_ExpectWithArrayAndReturn(rhport, ep_addr, big_segs, 2, 2, true);
+  TEST_ASSERT_TRUE(usbd_edpt_xfer_sg(rhport, ep_addr, big_segs, 2));
+
+  dcd_event_xfer_complete(rhport, ep_addr, 120000, XFER_RESULT_SUCCESS, true);
+  mscd_xfer_cb_ExpectAndReturn(rhport, ep_addr, XFER_RESULT_SUCCESS, 120000, true);
+  tud_task();
+  TEST_ASSERT_FALSE(usbd_edpt_busy(rhport, ep_addr));
+
+  // stalled endpoint does not take a transfer
+  dcd_edpt_stall_Expect(rhport, ep_addr);
+  usbd_edpt_stall(rhport, ep_addr);
+  TEST_ASSERT_FALSE(usbd_edpt_xfer_sg(rhport, ep_addr, segs, 2));
+
+  dcd_edpt_clear_stall_Expect(rhport, ep_addr);
+  usbd_edpt_clear_stall(rhport, ep_addr);
+  TEST_ASSERT_FALSE(usbd_edpt_busy(rhport, ep_addr));
+}
+
+//--------------------------------------------------------------------+
+// Transfer longer than CFG_TUD_EDPT_XFER_CHUNK_SIZE
+//--------------------------------------------------------------------+
+#if CFG_TUD_EDPT_XFER_CHUNK_SIZE == 512
+void test_usbd_edpt_xfer_split(void)
+{
+  uint8_t const ep_in  = 0x83;
+  uint8_t const ep_out = 0x03;
+  static uint8_t buf[1200];
+
+  // chunks are submitted by the complete interrupt, task is notified once
+  dcd_edpt_xfer_ExpectAndReturn(rhport, ep_in, buf, 512, true);
+  TEST_ASSERT_TRUE(usbd_edpt_xfer(rhport, ep_in, buf, sizeof(buf)));
+
+  dcd_edpt_xfer_ExpectAndReturn(rhport, ep_in, buf + 512, 512, true);
+  dcd_event_xfer_complete(rhport, ep_in, 512, XFER_RESULT_SUCCESS, true);
+
+  dcd_edpt_xfer_ExpectAndReturn(rhport, ep_in, buf + 1024, 176, true);
+  dcd_event_xfer_complete(rhport, ep_in, 512, XFER_RESULT_SUCCESS, true);
+  TEST_ASSERT_FALSE(tud_task_event_ready());
+
+  dcd_event_xfer_complete(rhport, ep_in, 176, XFER_RESULT_SUCCESS, true);
+  mscd_xfer_cb_ExpectAndReturn(rhport, ep_in, XFER_RESULT_SUCCESS, sizeof(buf), true);
+  tud_task();
+  TEST_ASSERT_FALSE(usbd_edpt_busy(rhport, ep_in));
+
+  // short packet ends the transfer early
+  dcd_edpt_xfer_ExpectAndReturn(rhport, ep_out, buf, 512, true);
+  TEST_ASSERT_TRUE(usbd_edpt_xfer(rhport, ep_out, buf, sizeof(buf)));
+
+  dcd_edpt_xfer_ExpectAndReturn(rhport, ep_out, buf + 512, 512, true);
+  dcd_event_xfer_complete(rhport, ep_out, 512, XFER_RESULT_SUCCESS, true);
+  dcd_event_xfer_complete(rhport, ep_out, 100, XFER_RESULT_SUCCESS, true);
+
+  mscd_xfer_cb_ExpectAndReturn(rhport, ep_out, XFER_RESULT_SUCCESS, 612, true);
+  tud_task();
+  TEST_ASSERT_FALSE(usbd_edpt_busy(rhport, ep_out));
+}
+#endif
+
+//--------------------------------------------------------------------+
+// FIFO transfer
+//--------------------------------------------------------------------+
+void test_usbd_edpt_xfer_fifo(void)
+{
+  uint8_t const ep_addr = 0x04;
+  uint8_t ff_buf[128];
+  tu_fifo_t ff;
+  tu_fifo_config(&ff, ff_buf, sizeof(ff_buf), 1, false);
+
+  dcd_edpt_xfer_fifo_ExpectAndReturn(rhport, ep_addr, &ff, 64, true);
+  TEST_ASSERT_TRUE(usbd_edpt_xfer_fifo(rhport, ep_addr, &ff, 64));
+  TEST_ASSERT_TRUE(usbd_edpt_busy(rhport, ep_addr));
+
+  // can not be queued behind a pending transfer
+  TEST_ASSERT_FALSE(usbd_edpt_xfer_fifo(rhport, ep_addr, &ff, 64));
+
+  dcd_event_xfer_complete(rhport, ep_addr, 10, XFER_RESULT_SUCCESS, true);
+  mscd_xfer_cb_ExpectAndReturn(rhport, ep_addr, XFER_RESULT_SUCCESS, 10, true);
+  tud_task();
+  TEST_ASSERT_FALSE(usbd_edpt_busy(rhport, ep_addr));
+
+  // DCD error releases the endpoint
+  dcd_edpt_xfer_fifo_ExpectAndReturn(rhport, ep_addr, &ff, 64, false);
+  TEST_ASSERT_FALSE(usbd_edpt_xfer_fifo(rhport, ep_addr, &ff, 64));
+  TEST_ASSERT_FALSE(usbd_edpt_busy(rhport, ep_addr));
+
+  // IN transfer is limited to data in the FIFO
+  uint8_t const data[10] = { 0 };
+  tu_fifo_write_n(&ff, data, sizeof(data));
+
+  dcd_edpt_xfer_fifo_ExpectAndReturn(rhport, 0x84, &ff, sizeof(data), true);
+  TEST_ASSERT_TRUE(usbd_edpt_xfer_fifo(rhport, 0x84, &ff, 64));
+
+  dcd_event_xfer_complete(rhport, 0x84, sizeof(data), XFER_RESULT_SUCCESS, true);
+  mscd_xfer_cb_ExpectAndReturn(rhport, 0x84, XFER_RESULT_SUCCESS, sizeof(data), true);
+  tud_task();
+  TEST_ASSERT_FALSE(usbd_edpt_busy(rhport, 0x84));
+}
+
+#if CFG_TUD_EDPT_XFER_CHUNK_SIZE == 512
+void test_usbd_edpt_xfer_fifo_split(void)
+{
+  uint8_t const ep_addr = 0x04;
+  static uint8_t ff_buf[256];
+  tu_fifo_t ff;
+  tu_fifo_config(&ff, ff_buf, sizeof(ff_buf), 1, false);
+
+  // transfer longer than a chunk keeps streaming into the same FIFO
+  dcd_edpt_xfer_fifo_ExpectAndReturn(rhport, ep_addr, &ff, 512, true);
+  TEST_ASSERT_TRUE(usbd_edpt_xfer_fifo(rhport, ep_addr, &ff, 70000));
+
+  for(uint32_t i = 1; i < 70000/512; i++)
+  {
+    dcd_edpt_xfer_fifo_ExpectAndReturn(rhport, ep_addr, &ff, 512, true);
+    dcd_event_xfer_complete(rhport, ep_addr, 512, XFER_RESULT_SUCCESS, true);
+  }
+
+  dcd_edpt_xfer_fifo_ExpectAndReturn(rhport, ep_addr, &ff, 70000 % 512, true);
+  dcd_event_xfer_complete(rhport, ep_addr, 512, XFER_RESULT_SUCCESS, true);
+  TEST_ASSERT_FALSE(tud_task_event_ready());
+
+  dcd_event_xfer_complete(rhport, ep_addr, 70000 % 512, XFER_RESULT_SUCCESS, true);
+  mscd_xfer_cb_ExpectAndReturn(rhport, ep_addr, XFER_RESULT_SUCCESS, 70000, true);
+  tud_task();
+  TEST_ASSERT_FALSE(usbd_edpt_busy(rhport, ep_addr));
+}
+#endif
+
+#if CFG_TUD_EDPT_STATS
+void test_usbd_edpt_stats(void)
+{
+  uint8_t const ep_addr = 0x85;
+  uint8_t buf[2][64];
+  tud_edpt_stats_t stats;
+
+  tud_edpt_stats_reset(ep_addr);
+
+  // 1st transfer has latency 3, 2nd queued one starts on completion of the 1st and has latency 100
+  stats_time = 10;
+  dcd_edpt_xfer_ExpectAndReturn(rhport, ep_addr, buf[0], 64, true);
+  TEST_ASSERT_TRUE(usbd_edpt_xfer(rhport, ep_addr, buf[0], 64));
+  TEST_ASSERT_TRUE(usbd_edpt_xfer(rhport, ep_addr, buf[1], 64));
+
+  stats_time = 13;
+  dcd_edpt_xfer_ExpectAndReturn(rhport, ep_addr, buf[1], 64, true);
+  dcd_event_xfer_complete(rhport, ep_addr, 64, XFER_RESULT_SUCCESS, true);
+
+  stats_time = 113;
+  dcd_event_xfer_complete(rhport, ep_addr, 20, XFER_RESULT_FAILED, true);
+
+  mscd_xfer_cb_ExpectAndReturn(rhport, ep_addr, XFER_RESULT_SUCCESS, 64, true);
+  mscd_xfer_cb_ExpectAndReturn(rhport, ep_addr, XFER_RESULT_FAILED, 20, true);
+  tud_task();
+
+  // endpoint sat idle for 50 until class driver submits next transfer
+  stats_time = 163;
+  dcd_edpt_xfer_ExpectAndReturn(rhport, ep_addr, buf[0], 64, true);
+  TEST_ASSERT_TRUE(usbd_edpt_xfer(rhport, ep_addr, buf[0], 64));
+  dcd_event_xfer_complete(rhport, ep_addr, 64, XFER_RESULT_SUCCESS, true);
+  mscd_xfer_cb_ExpectAndReturn(rhport, ep_addr, XFER_RESULT_SUCCESS, 64, true);
+  tud_task();
+
+  dcd_edpt_stall_Expect(rhport, ep_addr);
+  usbd_edpt_stall(rhport, ep_addr);
+  dcd_edpt_clear_stall_Expect(rhport, ep_addr);
+  usbd_edpt_clear_stall(rhport, ep_addr);
+
+  TEST_ASSERT_TRUE(tud_edpt_stats_get(ep_addr, &stats));
+  TEST_ASSERT_EQUAL_UINT32(148, stats.bytes);
+  TEST_ASSERT_EQUAL_UINT32(3, stats.xfers);
+  TEST_ASSERT_EQUAL_UINT32(1, stats.failed);
+  TEST_ASSERT_EQUAL_UINT32(1, stats.stalls);
+
+  // latency 0 -> bucket 0, 3 -> bucket 2, 100 -> last bucket
+  TEST_ASSERT_EQUAL_UINT32(1, stats.latency_hist[0]);
+  TEST_ASSERT_EQUAL_UINT32(1, stats.latency_hist[2]);
+  TEST_ASSERT_EQUAL_UINT32(1, stats.latency_hist[TUD_EDPT_STATS_HIST_COUNT-1]);
+  TEST_ASSERT_EQUAL_UINT32(100, stats.latency_max);
+
+  TEST_ASSERT_EQUAL_UINT32(1, stats.idle_count);
+  TEST_ASSERT_EQUAL_UINT32(50, stats.idle_total);
+  TEST_ASSERT_EQUAL_UINT32(50, stats.idle_max);
+
+  tud_edpt_stats_reset(ep_addr);
+  TEST_ASSERT_TRUE(tud_edpt_stats_get(ep_addr, &stats));
+  TEST_ASSERT_EQUAL_UINT32(0, stats.xfers);
+}
+#endif
+
+//--------------------------------------------------------------------+
+// ISR-direct completion
+//--------------------------------------------------------------------+
+#if CFG_TUD_EDPT_ISR_CB
+static uint8_t isr_buf[64];
+static uint32_t isr_cb_count;
+static uint32_t isr_cb_bytes;
+
+static void edpt_isr_cb(uint8_t rhport, uint8_t ep_addr, xfer_result_t result, uint32_t xferred_bytes)
+{
+  TEST_ASSERT_EQUAL(XFER_RESULT_SUCCESS, result);
+
+  isr_cb_count++;
+  isr_cb_bytes = xferred_bytes;
+
+  // re-arm once right from the completion interrupt
+  if ( isr_cb_count == 1 )
+  {
+    TEST_ASSERT_TRUE(usbd_edpt_xfer(rhport, ep_addr, isr_buf, sizeof(isr_buf)));
+  }
+}
+
+static uint32_t int_disable_count;
+static void count_int_disable(uint8_t rhport, int cmock_num_calls)
+{
+  (void) rhport;
+  (void) cmock_num_calls;
+  int_disable_count++;
+}
+
+void test_usbd_edpt_isr_cb(void)
+{
+  uint8_t const ep_addr = 0x86;
+
+  TEST_ASSERT_TRUE(usbd_edpt_set_isr_cb(rhport, ep_addr, edpt_isr_cb));
+
+  dcd_edpt_xfer_ExpectAndReturn(rhport, ep_addr, isr_buf, sizeof(isr_buf), true);
+  TEST_ASSERT_TRUE(usbd_edpt_xfer(rhport, ep_addr, isr_buf, sizeof(isr_buf)));
+
+  // mode can not be changed while transfer is pending
+  TEST_ASSERT_FALSE(usbd_edpt_set_isr_cb(rhport, ep_addr, NULL));
+
+  // callback is invoked without usbd task and submits the next transfer, dcd interrupt is
+  // not toggled since it is already running in it
+  dcd_int_disable_Stub(count_int_disable);
+  dcd_edpt_xfer_ExpectAndReturn(rhport, ep_addr, isr_buf, sizeof(isr_buf), true);
+  dcd_event_xfer_complete(rhport, ep_addr, 10, XFER_RESULT_SUCCESS, true);
+  TEST_ASSERT_EQUAL_UINT32(1, isr_cb_count);
+  TEST_ASSERT_EQUAL_UINT32(10, isr_cb_bytes);
+  TEST_ASSERT_TRUE(usbd_edpt_busy(rhport, ep_addr));
+
+  dcd_event_xfer_complete(rhport, ep_addr, 64, XFER_RESULT_SUCCESS, true);
+  TEST_ASSERT_EQUAL_UINT32(2, isr_cb_count);
+  TEST_ASSERT_EQUAL_UINT32(64, isr_cb_bytes);
+  TEST_ASSERT_FALSE(usbd_edpt_busy(rhport, ep_addr));
+  TEST_ASSERT_EQUAL_UINT32(0, int_disable_count);
+  dcd_int_disable_Ignore();
+
+  // nothing is queued, class driver's xfer_cb is not invoked
+  tud_task();
+
+  TEST_ASSERT_TRUE(usbd_edpt_set_isr_cb(rhport, ep_addr, NULL));
+}
+#endif
+
+//--------------------------------------------------------------------+
+// Configuration Index
+//--------------------------------------------------------------------+
+
+void test_usbd_config_index(void)
+{
+  enum { TOTAL_LEN = TUD_CONFIG_DESC_LEN + TUD_MSC_DESC_LEN + 9+7 + 9+7 };
+
+  uint8_t const desc_cfg[] =
+  {
+    TUD_CONFIG_DESCRIPTOR(1, 2, 0, TOTAL_LEN, TUSB_DESC_CONFIG_ATT_REMOTE_WAKEUP, 100),
+
+    // Interface 0 alternate 0 & 1
+    TUD_MSC_DESCRIPTOR(0, 0, 0x01, 0x81, 64),
+    9, TUSB_DESC_INTERFACE, 0, 1, 1, TUSB_CLASS_MSC, MSC_SUBCLASS_SCSI, MSC_PROTOCOL_BOT, 0,
+    7, TUSB_DESC_ENDPOINT, 0x82, TUSB_XFER_BULK, U16_TO_U8S_LE(64), 0,
+
+    // Interface 1
+    9, TUSB_DESC_INTERFACE, 1, 0, 1, TUSB_CLASS_VENDOR_SPECIFIC, 0, 0, 0,
+    7, TUSB_DESC_ENDPOINT, 0x03, TUSB_XFER_BULK, U16_TO_U8S_LE(64), 0,
+  };
+
+  tusb_control_request_t const req_set_config =
+  {
+    .bmRequestType = 0x00,
+    .bRequest = TUSB_REQ_SET_CONFIGURATION,
+    .wValue = 1,
+    .wIndex = 0x0000,
+    .wLength = 0
+  };
+
+  // start from a freshly enumerated device
+  dcd_event_bus_reset(rhport, TUSB_SPEED_FULL, false);
+  mscd_reset_Expect(rhport);
+
+  desc_configuration = desc_cfg;
+  dcd_event_setup_received(rhport, (uint8_t*) &req_set_config, false);
+
+  // msc driver claims both interfaces
+  mscd_open_ExpectAndReturn(rhport, (tusb_desc_interface_t const*) (desc_cfg + TUD_CONFIG_DESC_LEN),
+                            TOTAL_LEN - TUD_CONFIG_DESC_LEN, TOTAL_LEN - TUD_CONFIG_DESC_LEN);
+
+  // status
+  dcd_edpt_xfer_ExpectAndReturn(rhport, EDPT_CTRL_IN, NULL, 0, true);
+  dcd_event_xfer_complete(rhport, EDPT_CTRL_IN, 0, 0, false);
+  dcd_edpt0_status_complete_ExpectWithArray(rhport, &req_set_config, 1);
+
+  tud_task();
+
+  TEST_ASSERT_EQUAL_PTR(desc_cfg + TUD_CONFIG_DESC_LEN, usbd_itf_desc(rhport, 0));
+  TEST_ASSERT_EQUAL_UINT16(TUD_MSC_DESC_LEN + 9+7, usbd_itf_desc_len(rhport, 0));
+  TEST_ASSERT_EQUAL_UINT8(2, usbd_itf_alt_count(rhport, 0));
+
+  TEST_ASSERT_EQUAL_PTR(desc_cfg + TUD_CONFIG_DESC_LEN + TUD_MSC_DESC_LEN + 9+7, usbd_itf_desc(rhport, 1));
+  TEST_ASSERT_EQUAL_UINT16(9+7, usbd_itf_desc_len(rhport, 1));
+  TEST_ASSERT_EQUAL_UINT8(1, usbd_itf_alt_count(rhport, 1));
+
+  TEST_ASSERT_NULL(usbd_itf_desc(rhport, 2));
+  TEST_ASSERT_EQUAL_UINT8(0, usbd_itf_alt_count(rhport, 2));
+
+  TEST_ASSERT_EQUAL_UINT8(0, usbd_edpt_itf(rhport, 0x01));
+  TEST_ASSERT_EQUAL_UINT8(0, usbd_edpt_itf(rhport, 0x81));
+  TEST_ASSERT_EQUAL_UINT8(0, usbd_edpt_itf(rhport, 0x82));
+  TEST_ASSERT_EQUAL_UINT8(1, usbd_edpt_itf(rhport, 0x03));
+  TEST_ASSERT_EQUAL_UINT8(0xFF, usbd_edpt_itf(rhport, 0x04));
+}
@@ -0,0 +1,235 @@
+/* 
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2021, Ha Thach (tinyusb.org)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include "unity.h"
+
+// Files to test
+#include "tusb_fifo.h"
+#include "tusb.h"
+#include "usbd.h"
+#include "device/usbd_pvt.h"
+TEST_FILE("usbd_control.c")
+
+// Mock File
+#include "mock_dcd.h"
+#include "mock_msc_device.h"
+
+// Both roothub ports run in device mode (project.yml), each with its own event queue
+#if TUD_OPT_RHPORT_COUNT != 2
+#error this test requires two device ports
+#endif
+
+//--------------------------------------------------------------------+
+// MACRO TYPEDEF CONSTANT ENUM DECLARATION
+//--------------------------------------------------------------------+
+
+enum
+{
+  EDPT_CTRL_OUT = 0x00,
+  EDPT_CTRL_IN  = 0x80
+};
+
+enum { TOTAL_LEN = TUD_CONFIG_DESC_LEN + TUD_MSC_DESC_LEN };
+
+tusb_desc_device_t const data_desc_device =
+{
+    .bLength            = sizeof(tusb_desc_device_t),
+    .bDescriptorType    = TUSB_DESC_DEVICE,
+    .bcdUSB             = 0x0200,
+    .bDeviceClass       = 0x00,
+    .bDeviceSubClass    = 0x00,
+    .bDeviceProtocol    = 0x00,
+    .bMaxPacketSize0    = CFG_TUD_ENDPOINT0_SIZE,
+    .idVendor           = 0xCafe,
+    .idProduct          = 0xCafe,
+    .bcdDevice          = 0x0100,
+    .iManufacturer      = 0x00,
+    .iProduct           = 0x00,
+    .iSerialNumber      = 0x00,
+    .bNumConfigurations = 0x01
+};
+
+uint8_t const data_desc_configuration[] =
+{
+  TUD_CONFIG_DESCRIPTOR(1, 1, 0, TOTAL_LEN, 0x00, 100),
+  TUD_MSC_DESCRIPTOR(0, 0, 0x01, 0x81, 64),
+};
+
+tusb_control_request_t const req_get_desc_device =
+{
+  .bmRequestType = 0x80,
+  .bRequest = TUSB_REQ_GET_DESCRIPTOR,
+  .wValue = (TUSB_DESC_DEVICE << 8),
+  .wIndex = 0x0000,
+  .wLength = 64
+};
+
+tusb_control_request_t const req_set_config =
+{
+  .bmRequestType = 0x00,
+  .bRequest = TUSB_REQ_SET_CONFIGURATION,
+  .wValue = 1,
+  .wIndex = 0x0000,
+  .wLength = 0
+};
+
+uint8_t const * tud_descriptor_device_cb(void)
+{
+  return (uint8_t const *) &data_desc_device;
+}
+
+uint8_t const * tud_descriptor_configuration_cb(uint8_t index)
+{
+  return data_desc_configuration;
+}
+
+uint16_t const* tud_descriptor_string_cb(uint8_t index, uint16_t langid)
+{
+  (void) langid;
+
+  return NULL;
+}
+
+void setUp(void)
+{
+  dcd_int_disable_Ignore();
+  dcd_int_enable_Ignore();
+
+  if ( !tusb_inited() )
+  {
+    mscd_init_Expect();
+    dcd_init_Expect(0);
+    dcd_init_Expect(1);
+    tusb_init();
+  }
+}
+
+void tearDown(void)
+{
+}
+
+// enumerate port up to SET_CONFIGURATION
+static void port_mount(uint8_t rhport)
+{
+  dcd_event_bus_reset(rhport, TUSB_SPEED_FULL, false);
+  dcd_event_setup_received(rhport, (uint8_t*) &req_set_config, false);
+
+  mscd_open_ExpectAndReturn(rhport, (tusb_desc_interface_t const*) (data_desc_configuration + TUD_CONFIG_DESC_LEN),
+                            TOTAL_LEN - TUD_CONFIG_DESC_LEN, TOTAL_LEN - TUD_CONFIG_DESC_LEN);
+
+  dcd_edpt_xfer_ExpectAndReturn(rhport, EDPT_CTRL_IN, NULL, 0, true);
+  dcd_event_xfer_complete(rhport, EDPT_CTRL_IN, 0, 0, false);
+  dcd_edpt0_status_complete_ExpectWithArray(rhport, &req_set_config, 1);
+
+  TEST_ASSERT_EQUAL_UINT16(3, tud_task_ext_rhport(rhport, 0, 0));
+}
+
+//--------------------------------------------------------------------+
+// Deferred function calls
+//--------------------------------------------------------------------+
+static uint32_t func_call_count[2];
+
+static void count_func_call(void* param)
+{
+  func_call_count[(uintptr_t) param]++;
+}
+
+void test_usbd_multiport_defer_func(void)
+{
+  for(uint32_t i = 0; i < 3; i++) usbd_defer_func(1, count_func_call, (void*) (uintptr_t) 1, true);
+  for(uint32_t i = 0; i < 2; i++) usbd_defer_func(0, count_func_call, (void*) (uintptr_t) 0, true);
+
+  // each port only processes the events queued to it
+  TEST_ASSERT_EQUAL_UINT16(2, tud_task_ext_rhport(0, 0, 0));
+  TEST_ASSERT_EQUAL_UINT32(2, func_call_count[0]);
+  TEST_ASSERT_EQUAL_UINT32(0, func_call_count[1]);
+  TEST_ASSERT_TRUE(tud_task_event_ready());
+
+  TEST_ASSERT_EQUAL_UINT16(3, tud_task_ext_rhport(1, 0, 0));
+  TEST_ASSERT_EQUAL_UINT32(3, func_call_count[1]);
+  TEST_ASSERT_FALSE(tud_task_event_ready());
+
+  // tud_task_ext() services both ports
+  usbd_defer_func(0, count_func_call, (void*) (uintptr_t) 0, true);
+  usbd_defer_func(1, count_func_call, (void*) (uintptr_t) 1, true);
+
+  TEST_ASSERT_EQUAL_UINT32(2, tud_task_ext(0, 0));
+  TEST_ASSERT_EQUAL_UINT32(3, func_call_count[0]);
+  TEST_ASSERT_EQUAL_UINT32(4, func_call_count[1]);
+
+  // budget is shared by both ports, next call starts with the other port
+  for(uint32_t i = 0; i < 3; i++) usbd_defer_func(0, count_func_call, (void*) (uintptr_t) 0, true);
+  for(uint32_t i = 0; i < 3; i++) usbd_defer_func(1, count_func_call, (void*) (uintptr_t) 1, true);
+
+  TEST_ASSERT_EQUAL_UINT32(2, tud_task_ext(2, 0));
+  TEST_ASSERT_EQUAL_UINT32(2, tud_task_ext(2, 0));
+  TEST_ASSERT_EQUAL_UINT32(5, func_call_count[0]);
+  TEST_ASSERT_EQUAL_UINT32(6, func_call_count[1]);
+
+  TEST_ASSERT_EQUAL_UINT32(2, tud_task_ext(0, 0));
+  TEST_ASSERT_EQUAL_UINT32(6, func_call_count[0]);
+  TEST_ASSERT_EQUAL_UINT32(7, func_call_count[1]);
+}
+
+//--------------------------------------------------------------------+
+// Control transfer
+//--------------------------------------------------------------------+
+void test_usbd_multiport_control(void)
+{
+  // request on port 1 is answered on port 1 only
+  dcd_event_setup_received(1, (uint8_t*) &req_get_desc_device, false);
+
+  dcd_edpt_xfer_ExpectWithArrayAndReturn(1, EDPT_CTRL_IN, (uint8_t*)&data_desc_device, sizeof(tusb_desc_device_t), sizeof(tusb_desc_device_t), true);
+  dcd_event_xfer_complete(1, EDPT_CTRL_IN, sizeof(tusb_desc_device_t), 0, false);
+
+  dcd_edpt_xfer_ExpectAndReturn(1, EDPT_CTRL_OUT, NULL, 0, true);
+  dcd_event_xfer_complete(1, EDPT_CTRL_OUT, 0, 0, false);
+  dcd_edpt0_status_complete_ExpectWithArray(1, &req_get_desc_device, 1);
+
+  TEST_ASSERT_EQUAL_UINT16(0, tud_task_ext_rhport(0, 0, 0));
+  TEST_ASSERT_EQUAL_UINT16(3, tud_task_ext_rhport(1, 0, 0));
+}
+
+//--------------------------------------------------------------------+
+// Mount and bus reset
+//--------------------------------------------------------------------+
+void test_usbd_multiport_reset(void)
+{
+  port_mount(1);
+
+  TEST_ASSERT_TRUE (tud_mounted_rhport(1));
+  TEST_ASSERT_FALSE(tud_mounted_rhport(0));
+  TEST_ASSERT_EQUAL_PTR(data_desc_configuration + TUD_CONFIG_DESC_LEN, usbd_itf_desc(1, 0));
+  TEST_ASSERT_NULL(usbd_itf_desc(0, 0));
+
+  // bus reset of port 0 does not reset msc driver which only has interface on port 1
+  dcd_event_bus_reset(0, TUSB_SPEED_FULL, false);
+  TEST_ASSERT_EQUAL_UINT16(1, tud_task_ext_rhport(0, 0, 0));
+  TEST_ASSERT_TRUE(tud_mounted_rhport(1));
+
+  dcd_event_bus_reset(1, TUSB_SPEED_FULL, false);
+  mscd_reset_Expect(1);
+  TEST_ASSERT_EQUAL_UINT16(1, tud_task_ext_rhport(1, 0, 0));
+  TEST_ASSERT_FALSE(tud_mounted_rhport(1));
+}
@@ -0,0 +1,156 @@
+/* 
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2021, Ha Thach (tinyusb.org)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <pthread.h>
+#include <time.h>
+#include "unity.h"
+
+// Files to test
+#include "tusb.h"
+#include "usbd.h"
+#include "device/usbd_pvt.h"
+TEST_FILE("usbd_control.c")
+
+// Mock File
+#include "mock_dcd.h"
+#include "mock_msc_device.h"
+
+// Blocking behavior of the device task with an RTOS, CFG_TUSB_OS is OPT_OS_POSIX (project.yml)
+#if CFG_TUSB_OS != OPT_OS_POSIX
+#error this test requires the POSIX osal
+#endif
+
+uint8_t const rhport = 0;
+
+uint8_t const * tud_descriptor_device_cb(void)
+{
+  return NULL;
+}
+
+uint8_t const * tud_descriptor_configuration_cb(uint8_t index)
+{
+  return NULL;
+}
+
+uint16_t const* tud_descriptor_string_cb(uint8_t index, uint16_t langid)
+{
+  (void) langid;
+
+  return NULL;
+}
+
+static uint32_t now_ms(void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint32_t) (ts.tv_sec*1000 + ts.tv_nsec/1000000);
+}
+
+static uint32_t func_call_count;
+
+static void count_func_call(void* param)
+{
+  (void) param;
+  func_call_count++;
+}
+
+void setUp(void)
+{
+  dcd_int_disable_Ignore();
+  dcd_int_enable_Ignore();
+
+  if ( !tusb_inited() )
+  {
+    mscd_init_Expect();
+    dcd_init_Expect(rhport);
+    tusb_init();
+  }
+
+  func_call_count = 0;
+}
+
+void tearDown(void)
+{
+  // nothing left over for the next test
+  TEST_ASSERT_FALSE(tud_task_event_ready());
+}
+
+//--------------------------------------------------------------------+
+// Task timeout
+//--------------------------------------------------------------------+
+void test_usbd_posix_task_pending(void)
+{
+  for(uint32_t i = 0; i < 3; i++) usbd_defer_func(rhport, count_func_call, NULL, true);
+
+  // returns once queued events are processed without waiting for more
+  uint32_t const start = now_ms();
+  TEST_ASSERT_EQUAL_UINT32(3, tud_task_ext(0, 1000));
+  TEST_ASSERT_LESS_THAN_UINT32(500, now_ms() - start);
+  TEST_ASSERT_EQUAL_UINT32(3, func_call_count);
+}
+
+void test_usbd_posix_task_empty(void)
+{
+  // blocks up to timeout waiting for the first event
+  uint32_t const start = now_ms();
+  TEST_ASSERT_EQUAL_UINT32(0, tud_task_ext(0, 50));
+  TEST_ASSERT_GREATER_OR_EQUAL_UINT32(40, now_ms() - start);
+}
+
+void test_usbd_posix_task_budget(void)
+{
+  for(uint32_t i = 0; i < 5; i++) usbd_defer_func(rhport, count_func_call, NULL, true);
+
+  TEST_ASSERT_EQUAL_UINT32(2, tud_task_ext(2, 1000));
+  TEST_ASSERT_EQUAL_UINT32(2, func_call_count);
+
+  TEST_ASSERT_EQUAL_UINT32(3, tud_task_ext(0, 1000));
+  TEST_ASSERT_EQUAL_UINT32(5, func_call_count);
+}
+
+static void* defer_thread(void* arg)
+{
+  (void) arg;
+
+  struct timespec const ts = { .tv_sec = 0, .tv_nsec = 20*1000*1000 };
+  nanosleep(&ts, NULL);
+
+  usbd_defer_func(rhport, count_func_call, NULL, false);
+
+  return NULL;
+}
+
+void test_usbd_posix_task_wakeup(void)
+{
+  pthread_t thread;
+  TEST_ASSERT_EQUAL(0, pthread_create(&thread, NULL, defer_thread, NULL));
+
+  // blocked task is woken up by an event queued from another thread
+  uint32_t const start = now_ms();
+  TEST_ASSERT_EQUAL_UINT32(1, tud_task_ext(0, 1000));
+  TEST_ASSERT_LESS_THAN_UINT32(500, now_ms() - start);
+  TEST_ASSERT_EQUAL_UINT32(1, func_call_count);
+
+  pthread_join(thread, NULL);
+}
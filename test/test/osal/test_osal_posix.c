@@ -0,0 +1,205 @@
+/* 
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2019 Ha Thach (tinyusb.org)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ * This file is part of the TinyUSB stack.
+ */
+
+// exercise the POSIX port, independent of the OS configured for other tests
+#define CFG_TUSB_OS   OPT_OS_POSIX
+
+#include <string.h>
+#include <pthread.h>
+#include "unity.h"
+#include "tusb_option.h"
+#include "tusb_common.h"
+#include "osal/osal.h"
+
+static uint32_t now_ms(void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint32_t) (ts.tv_sec*1000 + ts.tv_nsec/1000000);
+}
+
+static osal_semaphore_def_t _semdef;
+static osal_semaphore_t _sem;
+
+static osal_mutex_def_t _mutexdef;
+static osal_mutex_t _mutex;
+
+#define QUEUE_DEPTH 4
+OSAL_QUEUE_DEF(OPT_MODE_DEVICE, _qdef, QUEUE_DEPTH, uint32_t);
+static osal_queue_t _queue;
+
+void setUp(void)
+{
+  _sem   = osal_semaphore_create(&_semdef);
+  _mutex = osal_mutex_create(&_mutexdef);
+  _queue = osal_queue_create(&_qdef);
+}
+
+void tearDown(void)
+{
+}
+
+//--------------------------------------------------------------------+
+// Semaphore
+//--------------------------------------------------------------------+
+static void* post_after_delay(void* arg)
+{
+  (void) arg;
+  osal_task_delay(10);
+  osal_semaphore_post(_sem, true);
+  return NULL;
+}
+
+void test_semaphore_timeout(void)
+{
+  TEST_ASSERT_FALSE(osal_semaphore_wait(_sem, OSAL_TIMEOUT_NOTIMEOUT));
+
+  uint32_t const start = now_ms();
+  TEST_ASSERT_FALSE(osal_semaphore_wait(_sem, 20));
+  TEST_ASSERT_GREATER_OR_EQUAL_UINT32(20, now_ms() - start);
+}
+
+void test_semaphore_post_wait(void)
+{
+  // binary: multiple posts are taken by one wait
+  osal_semaphore_post(_sem, false);
+  osal_semaphore_post(_sem, false);
+  TEST_ASSERT_TRUE(osal_semaphore_wait(_sem, OSAL_TIMEOUT_NOTIMEOUT));
+  TEST_ASSERT_FALSE(osal_semaphore_wait(_sem, OSAL_TIMEOUT_NOTIMEOUT));
+
+  osal_semaphore_post(_sem, false);
+  osal_semaphore_reset(_sem);
+  TEST_ASSERT_FALSE(osal_semaphore_wait(_sem, OSAL_TIMEOUT_NOTIMEOUT));
+
+  // posted by other thread while waiting
+  pthread_t thread;
+  pthread_create(&thread, NULL, post_after_delay, NULL);
+  TEST_ASSERT_TRUE(osal_semaphore_wait(_sem, OSAL_TIMEOUT_WAIT_FOREVER));
+  pthread_join(thread, NULL);
+
+  pthread_create(&thread, NULL, post_after_delay, NULL);
+  TEST_ASSERT_TRUE(osal_semaphore_wait(_sem, 1000));
+  pthread_join(thread, NULL);
+}
+
+//--------------------------------------------------------------------+
+// Mutex
+//--------------------------------------------------------------------+
+static void* lock_with_timeout(void* arg)
+{
+  bool* locked = (bool*) arg;
+
+  *locked = osal_mutex_lock(_mutex, 20);
+  if ( *locked ) osal_mutex_unlock(_mutex);
+
+  return NULL;
+}
+
+void test_mutex_timeout(void)
+{
+  bool locked = true;
+  pthread_t thread;
+
+  TEST_ASSERT_TRUE(osal_mutex_lock(_mutex, OSAL_TIMEOUT_WAIT_FOREVER));
+
+  // held by this thread
+  pthread_create(&thread, NULL, lock_with_timeout, &locked);
+  pthread_join(thread, NULL);
+  TEST_ASSERT_FALSE(locked);
+
+  TEST_ASSERT_TRUE(osal_mutex_unlock(_mutex));
+
+  pthread_create(&thread, NULL, lock_with_timeout, &locked);
+  pthread_join(thread, NULL);
+  TEST_ASSERT_TRUE(locked);
+}
+
+//--------------------------------------------------------------------+
+// Queue
+//--------------------------------------------------------------------+
+#define QUEUE_ITEMS 1000
+
+static void* queue_producer(void* arg)
+{
+  (void) arg;
+
+  // blocks while queue is full
+  for(uint32_t i = 0; i < QUEUE_ITEMS; i++) osal_queue_send(_queue, &i, false);
+
+  return NULL;
+}
+
+void test_queue_isr_full(void)
+{
+  TEST_ASSERT_TRUE(osal_queue_empty(_queue));
+
+  for(uint32_t i = 0; i < QUEUE_DEPTH; i++) TEST_ASSERT_TRUE(osal_queue_send(_queue, &i, true));
+
+  // ISR must not block on a full queue
+  uint32_t item = 0xff;
+  TEST_ASSERT_FALSE(osal_queue_send(_queue, &item, true));
+  TEST_ASSERT_FALSE(osal_queue_empty(_queue));
+
+  for(uint32_t i = 0; i < QUEUE_DEPTH; i++)
+  {
+    TEST_ASSERT_TRUE(osal_queue_receive(_queue, &item));
+    TEST_ASSERT_EQUAL_UINT32(i, item);
+  }
+
+  TEST_ASSERT_TRUE(osal_queue_empty(_queue));
+}
+
+void test_queue_receive_timeout(void)
+{
+  uint32_t item;
+  TEST_ASSERT_FALSE(osal_queue_receive_timeout(_queue, &item, OSAL_TIMEOUT_NOTIMEOUT));
+
+  uint32_t const start = now_ms();
+  TEST_ASSERT_FALSE(osal_queue_receive_timeout(_queue, &item, 20));
+  TEST_ASSERT_GREATER_OR_EQUAL_UINT32(20, now_ms() - start);
+
+  item = 0x55;
+  TEST_ASSERT_TRUE(osal_queue_send(_queue, &item, true));
+  item = 0;
+  TEST_ASSERT_TRUE(osal_queue_receive_timeout(_queue, &item, 20));
+  TEST_ASSERT_EQUAL_UINT32(0x55, item);
+}
+
+void test_queue_producer_consumer(void)
+{
+  pthread_t thread;
+  pthread_create(&thread, NULL, queue_producer, NULL);
+
+  for(uint32_t i = 0; i < QUEUE_ITEMS; i++)
+  {
+    uint32_t item;
+    TEST_ASSERT_TRUE(osal_queue_receive(_queue, &item));
+    TEST_ASSERT_EQUAL_UINT32(i, item);
+  }
+
+  pthread_join(thread, NULL);
+  TEST_ASSERT_TRUE(osal_queue_empty(_queue));
+}
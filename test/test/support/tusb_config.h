@@ -47,7 +47,14 @@
 #define CFG_TUSB_RHPORT0_MODE    (OPT_MODE_DEVICE | OPT_MODE_HIGH_SPEED)
 #endif
 
+// can be overridden by a test e.g OPT_OS_POSIX for osal tests
+#ifndef CFG_TUSB_OS
 #define CFG_TUSB_OS              OPT_OS_NONE
+#endif
+
+// Optional features (FIFO SPSC/stats/taps, transfer queue, timers ...) are left at their
+// defaults here as in shipping builds. Tests covering them enable them with per-test
+// defines in project.yml, other tests run the default configuration.
 
 // CFG_TUSB_DEBUG is defined by compiler in DEBUG build
 #ifndef CFG_TUSB_DEBUG
@@ -24,7 +24,10 @@
  * This file is part of the TinyUSB stack.
  */
 
+#include <string.h>
+#include <pthread.h>
 #include "unity.h"
+#include "tusb_common.h"
 #include "tusb_fifo.h"
 
 #define FIFO_SIZE 10
@@ -171,3 +174,718 @@ void test_full(void)
 
   TEST_ASSERT_TRUE(tu_fifo_full(&ff));
 }
+
+void test_get_read_info_when_no_wrap(void)
+{
+  uint8_t ch = 1;
+
+  // write 6 items
+  for(uint8_t i=0; i < 6; i++) tu_fifo_write(&ff, &ch);
+
+  // read 2 items
+  tu_fifo_read(&ff, &ch);
+  tu_fifo_read(&ff, &ch);
+
+  tu_fifo_buffer_info_t info;
+  tu_fifo_get_read_info(&ff, &info);
+
+  TEST_ASSERT_EQUAL(4, info.len_lin);
+  TEST_ASSERT_EQUAL(0, info.len_wrap);
+
+  TEST_ASSERT_EQUAL_PTR(ff.buffer+2, info.ptr_lin);
+  TEST_ASSERT_NULL(info.ptr_wrap);
+}
+
+void test_get_read_info_when_wrapped(void)
+{
+  uint8_t ch = 1;
+
+  // make fifo full
+  for(uint8_t i=0; i < FIFO_SIZE; i++) tu_fifo_write(&ff, &ch);
+
+  // read 6 items
+  for(uint8_t i=0; i < 6; i++) tu_fifo_read(&ff, &ch);
+
+  // write 2 items
+  tu_fifo_write(&ff, &ch);
+  tu_fifo_write(&ff, &ch);
+
+  tu_fifo_buffer_info_t info;
+  tu_fifo_get_read_info(&ff, &info);
+
+  TEST_ASSERT_EQUAL(FIFO_SIZE-6, info.len_lin);
+  TEST_ASSERT_EQUAL(2, info.len_wrap);
+
+  TEST_ASSERT_EQUAL_PTR(ff.buffer+6, info.ptr_lin);
+  TEST_ASSERT_EQUAL_PTR(ff.buffer, info.ptr_wrap);
+}
+
+void test_get_write_info_when_no_wrap(void)
+{
+  uint8_t ch = 1;
+  tu_fifo_write(&ff, &ch);
+  tu_fifo_write(&ff, &ch);
+
+  tu_fifo_buffer_info_t info;
+  tu_fifo_get_write_info(&ff, &info);
+
+  TEST_ASSERT_EQUAL(FIFO_SIZE-2, info.len_lin);
+  TEST_ASSERT_EQUAL(0, info.len_wrap);
+
+  TEST_ASSERT_EQUAL_PTR(ff.buffer+2, info.ptr_lin);
+  TEST_ASSERT_NULL(info.ptr_wrap);
+}
+
+void test_get_write_info_when_wrapped(void)
+{
+  uint8_t ch = 1;
+  uint8_t data[FIFO_SIZE];
+
+  // make fifo full, then read 4 items
+  for(uint8_t i=0; i < FIFO_SIZE; i++) tu_fifo_write(&ff, &ch);
+  tu_fifo_read_n(&ff, data, 4);
+
+  tu_fifo_buffer_info_t info;
+  tu_fifo_get_write_info(&ff, &info);
+
+  // write pointer is at the end of buffer, free space is at the beginning
+  TEST_ASSERT_EQUAL(4, info.len_lin);
+  TEST_ASSERT_EQUAL(0, info.len_wrap);
+  TEST_ASSERT_EQUAL_PTR(ff.buffer, info.ptr_lin);
+
+  // move write pointer to the middle, read everything
+  tu_fifo_write_n(&ff, data, 2);
+  tu_fifo_read_n(&ff, data, FIFO_SIZE);
+
+  tu_fifo_get_write_info(&ff, &info);
+
+  TEST_ASSERT_EQUAL(FIFO_SIZE-2, info.len_lin);
+  TEST_ASSERT_EQUAL(2, info.len_wrap);
+  TEST_ASSERT_EQUAL_PTR(ff.buffer+2, info.ptr_lin);
+  TEST_ASSERT_EQUAL_PTR(ff.buffer, info.ptr_wrap);
+}
+
+void test_get_info_when_full_or_empty(void)
+{
+  tu_fifo_buffer_info_t info;
+
+  // empty: nothing to read
+  tu_fifo_get_read_info(&ff, &info);
+  TEST_ASSERT_EQUAL(0, info.len_lin);
+  TEST_ASSERT_EQUAL(0, info.len_wrap);
+
+  // full: nothing to write
+  for(uint8_t i=0; i < FIFO_SIZE; i++) tu_fifo_write(&ff, &i);
+
+  tu_fifo_get_write_info(&ff, &info);
+  TEST_ASSERT_EQUAL(0, info.len_lin);
+  TEST_ASSERT_EQUAL(0, info.len_wrap);
+}
+
+void test_get_info_commit(void)
+{
+  uint8_t data[FIFO_SIZE];
+  uint8_t rd[FIFO_SIZE];
+  for(uint8_t i=0; i < FIFO_SIZE; i++) data[i] = i;
+
+  // place write pointer near the end
+  tu_fifo_write_n(&ff, data, 7);
+  tu_fifo_read_n(&ff, rd, 7);
+
+  // produce data in place as a DMA would do
+  tu_fifo_buffer_info_t info;
+  tu_fifo_get_write_info(&ff, &info);
+  TEST_ASSERT_EQUAL(FIFO_SIZE, info.len_lin + info.len_wrap);
+
+  memcpy(info.ptr_lin, data, info.len_lin);
+  memcpy(info.ptr_wrap, data + info.len_lin, 5 - info.len_lin);
+  tu_fifo_advance_write_pointer(&ff, 5);
+
+  TEST_ASSERT_EQUAL(5, tu_fifo_count(&ff));
+  TEST_ASSERT_EQUAL(5, tu_fifo_read_n(&ff, rd, FIFO_SIZE));
+  TEST_ASSERT_EQUAL_MEMORY(data, rd, 5);
+
+  // consume data in place
+  tu_fifo_write_n(&ff, data, 6);
+  tu_fifo_get_read_info(&ff, &info);
+  TEST_ASSERT_EQUAL(6, info.len_lin + info.len_wrap);
+
+  memcpy(rd, info.ptr_lin, info.len_lin);
+  memcpy(rd + info.len_lin, info.ptr_wrap, info.len_wrap);
+  tu_fifo_advance_read_pointer(&ff, 6);
+
+  TEST_ASSERT_TRUE(tu_fifo_empty(&ff));
+  TEST_ASSERT_EQUAL_MEMORY(data, rd, 6);
+}
+
+void test_depth_limit(void)
+{
+  uint8_t buf[4];
+  tu_fifo_t f;
+
+  TEST_ASSERT_TRUE(tu_fifo_config(&f, buf, TU_FIFO_DEPTH_MAX, 1, false));
+  TEST_ASSERT_EQUAL(TU_FIFO_DEPTH_MAX, tu_fifo_depth(&f));
+  TEST_ASSERT_EQUAL(TU_FIFO_IDX_MAX, f.max_pointer_idx);
+  TEST_ASSERT_EQUAL(0, f.non_used_index_space);
+
+#if !CFG_TUSB_FIFO_WIDE_INDEX
+  // index type can't hold a larger depth in 32-bit mode
+  TEST_ASSERT_FALSE(tu_fifo_config(&f, buf, TU_FIFO_DEPTH_MAX+1, 1, false));
+#endif
+}
+
+void test_overflow_correction_non_power_of_two(void)
+{
+  uint8_t data[5] = { 1, 2, 3, 4, 5 };
+  uint8_t rd[5];
+
+  TU_FIFO_DEF(ff5, 5, uint8_t, false);
+
+  // pretend a DMA filled the FIFO, then consume it
+  tu_fifo_advance_write_pointer(&ff5, 5);
+  tu_fifo_advance_read_pointer(&ff5, 5);
+
+  // DMA overflows by 3 items, write pointer rolls over the index space
+  tu_fifo_advance_write_pointer(&ff5, 8);
+  TEST_ASSERT_TRUE(tu_fifo_overflowed(&ff5));
+
+  tu_fifo_correct_read_pointer(&ff5);
+  TEST_ASSERT_FALSE(tu_fifo_overflowed(&ff5));
+  TEST_ASSERT_EQUAL(5, tu_fifo_count(&ff5));
+
+  TEST_ASSERT_EQUAL(5, tu_fifo_read_n(&ff5, rd, 5));
+  TEST_ASSERT_TRUE(tu_fifo_empty(&ff5));
+
+  // still working normally afterwards
+  TEST_ASSERT_EQUAL(5, tu_fifo_write_n(&ff5, data, 5));
+  TEST_ASSERT_EQUAL(5, tu_fifo_read_n(&ff5, rd, 5));
+  TEST_ASSERT_EQUAL_MEMORY(data, rd, 5);
+}
+
+#if CFG_TUSB_FIFO_STATS
+void test_stats(void)
+{
+  uint8_t data[8] = { 1, 2, 3, 4, 5, 6, 7, 8 };
+  uint8_t rd[8];
+  tu_fifo_stats_t stats;
+
+  TU_FIFO_DEF(ff4, 4, uint8_t, false);
+
+  TEST_ASSERT_EQUAL(3, tu_fifo_write_n(&ff4, data, 3));
+  TEST_ASSERT_EQUAL(2, tu_fifo_read_n(&ff4, rd, 2));
+
+  // only 3 out of 5 fit
+  TEST_ASSERT_EQUAL(3, tu_fifo_write_n(&ff4, data, 5));
+  TEST_ASSERT_FALSE(tu_fifo_write(&ff4, data));
+
+  tu_fifo_get_stats(&ff4, &stats);
+  TEST_ASSERT_EQUAL(4, stats.peak_count);
+  TEST_ASSERT_EQUAL(6, stats.written);
+  TEST_ASSERT_EQUAL(2, stats.read);
+  TEST_ASSERT_EQUAL(2, stats.rejected);
+  TEST_ASSERT_EQUAL(0, stats.overflows);
+
+  // peak restarts from current level
+  TEST_ASSERT_EQUAL(3, tu_fifo_read_n(&ff4, rd, 3));
+  tu_fifo_reset_stats(&ff4);
+  tu_fifo_get_stats(&ff4, &stats);
+  TEST_ASSERT_EQUAL(1, stats.peak_count);
+  TEST_ASSERT_EQUAL(0, stats.written);
+  TEST_ASSERT_EQUAL(0, stats.read);
+  TEST_ASSERT_EQUAL(0, stats.rejected);
+
+  // overwritable FIFO counts overwritten data as overflow
+  tu_fifo_set_overwritable(&ff4, true);
+  TEST_ASSERT_EQUAL(4, tu_fifo_write_n(&ff4, data, 4));
+  TEST_ASSERT_TRUE(tu_fifo_write(&ff4, data));
+
+  tu_fifo_get_stats(&ff4, &stats);
+  TEST_ASSERT_EQUAL(4, stats.peak_count);
+  TEST_ASSERT_EQUAL(5, stats.written);
+  TEST_ASSERT_EQUAL(2, stats.overflows);
+}
+#endif
+
+//--------------------------------------------------------------------+
+// Taps
+//--------------------------------------------------------------------+
+#if CFG_TUSB_FIFO_TAP
+void test_tap_mirror(void)
+{
+  uint8_t data[3] = { 1, 2, 3 };
+  uint8_t rd[4];
+  tu_fifo_tap_t tap;
+
+  TU_FIFO_DEF(ff4, 4, uint8_t, false);
+
+  tu_fifo_tap_attach(&tap, &ff4);
+  TEST_ASSERT_EQUAL(0, tu_fifo_tap_count(&tap));
+
+  tu_fifo_write_n(&ff4, data, 3);
+  TEST_ASSERT_EQUAL(3, tu_fifo_tap_count(&tap));
+
+  // tap does not consume items of the primary reader and vice versa
+  TEST_ASSERT_EQUAL(2, tu_fifo_tap_read_n(&tap, rd, 2));
+  TEST_ASSERT_EQUAL_MEMORY(data, rd, 2);
+  TEST_ASSERT_EQUAL(3, tu_fifo_count(&ff4));
+
+  TEST_ASSERT_EQUAL(3, tu_fifo_read_n(&ff4, rd, 4));
+  TEST_ASSERT_EQUAL_MEMORY(data, rd, 3);
+  TEST_ASSERT_EQUAL(1, tu_fifo_tap_count(&tap));
+
+  // tap may lag behind the primary reader as long as items are not overwritten
+  TEST_ASSERT_EQUAL(1, tu_fifo_tap_read_n(&tap, rd, 4));
+  TEST_ASSERT_EQUAL(3, rd[0]);
+  TEST_ASSERT_EQUAL(0, tu_fifo_tap_lost(&tap));
+
+  // tap follows a cleared FIFO
+  tu_fifo_write_n(&ff4, data, 3);
+  tu_fifo_clear(&ff4);
+  tu_fifo_write_n(&ff4, data+1, 2);
+  TEST_ASSERT_EQUAL(2, tu_fifo_tap_read_n(&tap, rd, 4));
+  TEST_ASSERT_EQUAL_MEMORY(data+1, rd, 2);
+}
+
+void test_tap_overwritten(void)
+{
+  uint8_t data[6] = { 1, 2, 3, 4, 5, 6 };
+  uint8_t rd[4];
+  tu_fifo_tap_t tap;
+
+  TU_FIFO_DEF(ff4, 4, uint8_t, false);
+  tu_fifo_tap_attach(&tap, &ff4);
+
+  // writer is not blocked by the tap, which loses the 2 oldest items
+  tu_fifo_write_n(&ff4, data, 4);
+  tu_fifo_read_n(&ff4, rd, 4);
+  tu_fifo_write_n(&ff4, data+4, 2);
+
+  TEST_ASSERT_EQUAL(4, tu_fifo_tap_count(&tap));
+  TEST_ASSERT_EQUAL(4, tu_fifo_tap_read_n(&tap, rd, 4));
+  TEST_ASSERT_EQUAL_MEMORY(data+2, rd, 4);
+  TEST_ASSERT_EQUAL(2, tu_fifo_tap_lost(&tap));
+}
+
+void test_tap_claimed(void)
+{
+  uint8_t data[4] = { 1, 2, 3, 4 };
+  uint8_t rd[4];
+  tu_fifo_tap_t tap;
+  tu_fifo_buffer_info_t info;
+
+  TU_FIFO_DEF(ff4, 4, uint8_t, false);
+  tu_fifo_tap_attach(&tap, &ff4);
+
+  tu_fifo_write_n(&ff4, data, 4);
+  tu_fifo_read_n(&ff4, rd, 2);
+
+  // e.g a DMA may write the 2 free slots from now on, their old items are invalid for the tap
+  tu_fifo_get_write_info(&ff4, &info);
+  TEST_ASSERT_EQUAL(2, info.len_lin + info.len_wrap);
+
+  TEST_ASSERT_EQUAL(2, tu_fifo_tap_read_n(&tap, rd, 4));
+  TEST_ASSERT_EQUAL_MEMORY(data+2, rd, 2);
+  TEST_ASSERT_EQUAL(2, tu_fifo_tap_lost(&tap));
+}
+#endif
+
+//--------------------------------------------------------------------+
+// Multi-channel interleaving
+//--------------------------------------------------------------------+
+// two channels of 24-bit samples stored as 32-bit in byte FIFOs of 10 bytes,
+// i.e samples straddle the wrap around
+static uint8_t ch_buf[2][10];
+static tu_fifo_t ch_ff[2];
+
+static void ch_ff_setup(tu_fifo_idx_t start)
+{
+  for(uint8_t c = 0; c < 2; c++)
+  {
+    tu_fifo_config(&ch_ff[c], ch_buf[c], 10, 1, false);
+    tu_fifo_advance_write_pointer(&ch_ff[c], start);
+    tu_fifo_advance_read_pointer(&ch_ff[c], start);
+  }
+}
+
+void test_write_n_interleaved(void)
+{
+  uint8_t const frames[] = { 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16, 17, 18 };
+  uint8_t const ch0[] = { 1, 2, 3, 0, 7, 8, 9, 0 };
+  uint8_t const ch1[] = { 4, 5, 6, 0, 10, 11, 12, 0 };
+  uint8_t rd[8];
+
+  ch_ff_setup(7);
+
+  // only 2 samples fit
+  TEST_ASSERT_EQUAL(2, tu_fifo_write_n_interleaved(ch_ff, 2, frames, 3, 4, 3));
+  TEST_ASSERT_EQUAL(8, tu_fifo_count(&ch_ff[0]));
+  TEST_ASSERT_EQUAL(8, tu_fifo_count(&ch_ff[1]));
+
+  TEST_ASSERT_EQUAL(8, tu_fifo_read_n(&ch_ff[0], rd, 8));
+  TEST_ASSERT_EQUAL_MEMORY(ch0, rd, 8);
+  TEST_ASSERT_EQUAL(8, tu_fifo_read_n(&ch_ff[1], rd, 8));
+  TEST_ASSERT_EQUAL_MEMORY(ch1, rd, 8);
+}
+
+void test_read_n_interleaved(void)
+{
+  uint8_t const ch0[] = { 1, 2, 3, 0xff, 7, 8, 9, 0xff, 13, 14, 15, 0xff };
+  uint8_t const ch1[] = { 4, 5, 6, 0xff, 10, 11, 12, 0xff };
+  uint8_t const frames[] = { 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12 };
+  uint8_t rd[18];
+
+  ch_ff_setup(5);
+  tu_fifo_write_n(&ch_ff[0], ch0, 8);
+  tu_fifo_write_n(&ch_ff[1], ch1, 8);
+
+  // channel 1 has only 2 samples, channels are kept in sync
+  memset(rd, 0, sizeof(rd));
+  TEST_ASSERT_EQUAL(2, tu_fifo_read_n_interleaved(ch_ff, 2, rd, 3, 4, 3));
+  TEST_ASSERT_EQUAL_MEMORY(frames, rd, sizeof(frames));
+  TEST_ASSERT_TRUE(tu_fifo_empty(&ch_ff[0]));
+  TEST_ASSERT_TRUE(tu_fifo_empty(&ch_ff[1]));
+
+  TEST_ASSERT_EQUAL(0, tu_fifo_read_n_interleaved(ch_ff, 2, rd, 3, 4, 3));
+}
+
+void test_interleaved_round_trip(void)
+{
+  uint8_t frames[4*3*2];
+  uint8_t rd[sizeof(frames)];
+
+  for(uint8_t i = 0; i < sizeof(frames); i++) frames[i] = i;
+
+  TU_FIFO_DEF(ff_l, 13, uint16_t, false);
+  TU_FIFO_DEF(ff_r, 13, uint16_t, false);
+  tu_fifo_t chs[2];
+
+  // sample sizes 1 to 4 bytes in 32-bit samples of 16-bit items
+  for(uint8_t size = 1; size <= 4; size++)
+  {
+    chs[0] = ff_l;
+    chs[1] = ff_r;
+
+    for(uint8_t round = 0; round < 5; round++)
+    {
+      TEST_ASSERT_EQUAL(3, tu_fifo_write_n_interleaved(chs, 2, frames, 3, 4, size));
+      TEST_ASSERT_EQUAL(6, tu_fifo_count(&chs[0]));
+
+      memset(rd, 0, sizeof(rd));
+      TEST_ASSERT_EQUAL(3, tu_fifo_read_n_interleaved(chs, 2, rd, 4, 4, size));
+      TEST_ASSERT_EQUAL_MEMORY(frames, rd, 3*2*size);
+    }
+  }
+}
+
+//--------------------------------------------------------------------+
+// Fixed address (hardware FIFO register) access
+//--------------------------------------------------------------------+
+// A simulated register always returns the same word, the byte stream is therefore
+// periodic which shows if words are split correctly at wrap around and tails.
+static uint8_t const reg_bytes[4] = { 0x11, 0x22, 0x33, 0x44 };
+
+void test_write_n_const_addr(void)
+{
+  volatile uint32_t reg;
+  uint8_t rd[FIFO_SIZE];
+  memcpy((void*) &reg, reg_bytes, 4);
+
+  for(uint8_t offset=0; offset < FIFO_SIZE; offset++)
+  {
+    for(uint8_t len=1; len <= FIFO_SIZE; len++)
+    {
+      tu_fifo_clear(&ff);
+      tu_fifo_advance_write_pointer(&ff, offset);
+      tu_fifo_advance_read_pointer(&ff, offset);
+
+      TEST_ASSERT_EQUAL(len, tu_fifo_write_n_const_addr(&ff, (void const*) &reg, len));
+      TEST_ASSERT_EQUAL(len, tu_fifo_read_n(&ff, rd, FIFO_SIZE));
+
+      for(uint8_t i=0; i < len; i++) TEST_ASSERT_EQUAL_HEX8(reg_bytes[i % 4], rd[i]);
+    }
+  }
+
+  // not overwritable: limited to free space
+  tu_fifo_clear(&ff);
+  TEST_ASSERT_EQUAL(FIFO_SIZE, tu_fifo_write_n_const_addr(&ff, (void const*) &reg, FIFO_SIZE+3));
+}
+
+void test_write_n_const_addr_overwritable(void)
+{
+  volatile uint32_t reg;
+  uint8_t rd[FIFO_SIZE];
+  memcpy((void*) &reg, reg_bytes, 4);
+
+  tu_fifo_set_overwritable(&ff, true);
+
+  // first 3 bytes are drained from the register and dropped
+  TEST_ASSERT_EQUAL(FIFO_SIZE, tu_fifo_write_n_const_addr(&ff, (void const*) &reg, FIFO_SIZE+3));
+  TEST_ASSERT_EQUAL(FIFO_SIZE, tu_fifo_read_n(&ff, rd, FIFO_SIZE));
+
+  for(uint8_t i=0; i < FIFO_SIZE; i++) TEST_ASSERT_EQUAL_HEX8(reg_bytes[(i+3) % 4], rd[i]);
+
+  tu_fifo_set_overwritable(&ff, false);
+}
+
+void test_read_n_const_addr(void)
+{
+  volatile uint32_t reg;
+  uint8_t data[FIFO_SIZE];
+  for(uint8_t i=0; i < FIFO_SIZE; i++) data[i] = i+1;
+
+  // The register keeps the last word written: checking it for every length from
+  // every start position covers all words of the stream
+  for(uint8_t offset=0; offset < FIFO_SIZE; offset++)
+  {
+    for(uint8_t len=1; len <= FIFO_SIZE; len++)
+    {
+      tu_fifo_clear(&ff);
+      tu_fifo_advance_write_pointer(&ff, offset);
+      tu_fifo_advance_read_pointer(&ff, offset);
+      tu_fifo_write_n(&ff, data, len);
+
+      reg = 0xdeadbeef;
+      TEST_ASSERT_EQUAL(len, tu_fifo_read_n_const_addr(&ff, (void*) &reg, FIFO_SIZE));
+      TEST_ASSERT_TRUE(tu_fifo_empty(&ff));
+
+      // last word is zero padded
+      uint8_t const last = ((len-1) / 4) * 4;
+      uint32_t expected = 0;
+      memcpy(&expected, data + last, len - last);
+      TEST_ASSERT_EQUAL_HEX32(expected, reg);
+    }
+  }
+}
+
+void test_const_addr_item_size(void)
+{
+  TU_FIFO_DEF(ff4, 5, uint16_t, false);
+
+  volatile uint32_t reg;
+  uint16_t rd[5];
+  memcpy((void*) &reg, reg_bytes, 4);
+
+  tu_fifo_advance_write_pointer(&ff4, 4);
+  tu_fifo_advance_read_pointer(&ff4, 4);
+
+  // 3 items = 6 bytes: 1 item linear, 2 wrapped, 2 words read
+  TEST_ASSERT_EQUAL(3, tu_fifo_write_n_const_addr(&ff4, (void const*) &reg, 3));
+  TEST_ASSERT_EQUAL(3, tu_fifo_read_n(&ff4, rd, 5));
+  TEST_ASSERT_EQUAL_MEMORY(reg_bytes, &rd[0], 4);
+  TEST_ASSERT_EQUAL_MEMORY(reg_bytes, &rd[2], 2);
+}
+
+//--------------------------------------------------------------------+
+// Single producer / single consumer stress
+//--------------------------------------------------------------------+
+#if CFG_TUSB_FIFO_SPSC
+#define STRESS_ITEMS   1000000u
+
+TU_FIFO_DEF(ff_spsc, 37, uint32_t, false); // non power of two on purpose
+
+static void* spsc_producer(void* arg)
+{
+  (void) arg;
+  uint32_t buf[16];
+  uint32_t seq = 0;
+
+  while ( seq < STRESS_ITEMS )
+  {
+    // vary chunk size to hit all wrap positions
+    uint32_t const n = tu_min32(1 + (seq % 16), STRESS_ITEMS - seq);
+    for(uint32_t i=0; i < n; i++) buf[i] = seq + i;
+
+    uint32_t const written = tu_fifo_write_n(&ff_spsc, buf, n);
+    seq += written;
+    if ( written == 0 ) sched_yield();
+  }
+
+  return NULL;
+}
+
+void test_spsc_threaded_stress(void)
+{
+  pthread_t producer;
+  uint32_t buf[23];
+  uint32_t expected = 0;
+  bool ok = true;
+
+  tu_fifo_clear(&ff_spsc);
+  TEST_ASSERT_EQUAL(0, pthread_create(&producer, NULL, spsc_producer, NULL));
+
+  while ( expected < STRESS_ITEMS && ok )
+  {
+    uint32_t const n = tu_fifo_read_n(&ff_spsc, buf, 1 + (expected % TU_ARRAY_SIZE(buf)));
+    for(uint32_t i=0; i < n; i++)
+    {
+      if ( buf[i] != expected++ ) ok = false;
+    }
+    if ( n == 0 ) sched_yield();
+  }
+
+  pthread_join(producer, NULL);
+
+  TEST_ASSERT_TRUE(ok);
+  TEST_ASSERT_EQUAL(STRESS_ITEMS, expected);
+  TEST_ASSERT_TRUE(tu_fifo_empty(&ff_spsc));
+  TEST_ASSERT_FALSE(tu_fifo_overflowed(&ff_spsc));
+}
+#endif
+
+//--------------------------------------------------------------------+
+// Typed FIFO
+//--------------------------------------------------------------------+
+typedef struct
+{
+  uint8_t  id;
+  uint32_t value;
+} test_item_t;
+
+TU_FIFO_TYPED_DEF(tff, test_item_t, 8, false);
+TU_FIFO_TYPED_DEF(tff_ow, uint32_t, 4, true);
+
+void test_typed_normal(void)
+{
+  tff_clear(&tff);
+  TEST_ASSERT_TRUE(tff_empty(&tff));
+
+  for(uint8_t i=0; i < 8; i++)
+  {
+    test_item_t item = { .id = i, .value = 1000u + i };
+    TEST_ASSERT_TRUE(tff_write(&tff, &item));
+  }
+
+  TEST_ASSERT_TRUE(tff_full(&tff));
+  TEST_ASSERT_EQUAL(0, tff_remaining(&tff));
+
+  // not overwritable
+  test_item_t item = { .id = 0xff };
+  TEST_ASSERT_FALSE(tff_write(&tff, &item));
+
+  TEST_ASSERT_TRUE(tff_peek_at(&tff, 3, &item));
+  TEST_ASSERT_EQUAL(3, item.id);
+
+  for(uint8_t i=0; i < 8; i++)
+  {
+    TEST_ASSERT_TRUE(tff_read(&tff, &item));
+    TEST_ASSERT_EQUAL(i, item.id);
+    TEST_ASSERT_EQUAL(1000u + i, item.value);
+  }
+
+  TEST_ASSERT_FALSE(tff_read(&tff, &item));
+}
+
+void test_typed_n_wrap_around(void)
+{
+  test_item_t wr[8], rd[8];
+  for(uint8_t i=0; i < 8; i++) { wr[i].id = i; wr[i].value = i*3u; }
+
+  tff_clear(&tff);
+
+  // move indices close to the rollover to exercise the masking
+  tff.wr_idx = tff.rd_idx = TU_FIFO_IDX_MAX - 2;
+
+  TEST_ASSERT_EQUAL(5, tff_write_n(&tff, wr, 5));
+  TEST_ASSERT_EQUAL(3, tff_read_n(&tff, rd, 3));
+  TEST_ASSERT_EQUAL_MEMORY(wr, rd, 3*sizeof(test_item_t));
+
+  // only 6 slots remaining
+  TEST_ASSERT_EQUAL(6, tff_write_n(&tff, wr, 8));
+  TEST_ASSERT_EQUAL(8, tff_count(&tff));
+
+  TEST_ASSERT_EQUAL(8, tff_read_n(&tff, rd, 8));
+  TEST_ASSERT_EQUAL_MEMORY(wr+3, rd, 2*sizeof(test_item_t));
+  TEST_ASSERT_EQUAL_MEMORY(wr, rd+2, 6*sizeof(test_item_t));
+  TEST_ASSERT_TRUE(tff_empty(&tff));
+}
+
+void test_typed_overwritable(void)
+{
+  uint32_t data[10] = { 0, 1, 2, 3, 4, 5, 6, 7, 8, 9 };
+  uint32_t rd[4];
+
+  tff_ow_clear(&tff_ow);
+
+  // overflow with single writes, oldest items are overwritten
+  for(uint8_t i=0; i < 6; i++) TEST_ASSERT_TRUE(tff_ow_write(&tff_ow, &data[i]));
+
+  TEST_ASSERT_EQUAL(4, tff_ow_read_n(&tff_ow, rd, 4));
+  TEST_ASSERT_EQUAL_UINT32_ARRAY(data+2, rd, 4);
+
+  // write more than depth at once, only last part is kept
+  TEST_ASSERT_EQUAL(4, tff_ow_write_n(&tff_ow, data, 10));
+  TEST_ASSERT_EQUAL(4, tff_ow_read_n(&tff_ow, rd, 4));
+  TEST_ASSERT_EQUAL_UINT32_ARRAY(data+6, rd, 4);
+}
+
+void test_typed_same_as_generic(void)
+{
+  TU_FIFO_DEF(gff, 4, uint32_t, false);
+  tu_fifo_clear(&gff);
+  tff_ow_clear(&tff_ow);
+  tff_ow.overwritable = false;
+
+  uint32_t data[32];
+  for(uint32_t i=0; i < 32; i++) data[i] = i;
+
+  uint32_t rd_g[8], rd_t[8];
+  uint32_t offset = 0;
+
+  // same sequence of partial writes/reads must give same result
+  for(uint32_t i=0; i < 20; i++)
+  {
+    uint16_t const nw = (i % 5) + 1;
+    uint16_t const nr = (i % 3) + 1;
+
+    TEST_ASSERT_EQUAL(tu_fifo_write_n(&gff, data + (offset % 16), nw), tff_ow_write_n(&tff_ow, data + (offset % 16), nw));
+    offset += nw;
+
+    uint16_t const cnt = tu_fifo_read_n(&gff, rd_g, nr);
+    TEST_ASSERT_EQUAL(cnt, tff_ow_read_n(&tff_ow, rd_t, nr));
+    TEST_ASSERT_EQUAL_UINT32_ARRAY(rd_g, rd_t, cnt);
+    TEST_ASSERT_EQUAL(tu_fifo_count(&gff), tff_ow_count(&tff_ow));
+  }
+
+  tff_ow.overwritable = true;
+}
+
+#if CFG_TUSB_FIFO_STATS
+void test_typed_stats(void)
+{
+  uint32_t data[5] = { 1, 2, 3, 4, 5 };
+  uint32_t rd[4];
+  tu_fifo_stats_t stats;
+
+  tff_ow_clear(&tff_ow);
+  tff_ow.overwritable = false;
+  tff_ow_reset_stats(&tff_ow);
+
+  // same sequence as test_stats() must give same counters
+  TEST_ASSERT_EQUAL(3, tff_ow_write_n(&tff_ow, data, 3));
+  TEST_ASSERT_EQUAL(2, tff_ow_read_n(&tff_ow, rd, 2));
+  TEST_ASSERT_EQUAL(3, tff_ow_write_n(&tff_ow, data, 5));
+  TEST_ASSERT_FALSE(tff_ow_write(&tff_ow, data));
+
+  tff_ow_get_stats(&tff_ow, &stats);
+  TEST_ASSERT_EQUAL(4, stats.peak_count);
+  TEST_ASSERT_EQUAL(6, stats.written);
+  TEST_ASSERT_EQUAL(2, stats.read);
+  TEST_ASSERT_EQUAL(2, stats.rejected);
+  TEST_ASSERT_EQUAL(0, stats.overflows);
+
+  TEST_ASSERT_EQUAL(3, tff_ow_read_n(&tff_ow, rd, 3));
+  tff_ow_reset_stats(&tff_ow);
+  tff_ow_get_stats(&tff_ow, &stats);
+  TEST_ASSERT_EQUAL(1, stats.peak_count);
+  TEST_ASSERT_EQUAL(0, stats.written);
+
+  tff_ow.overwritable = true;
+  TEST_ASSERT_EQUAL(4, tff_ow_write_n(&tff_ow, data, 4));
+  TEST_ASSERT_TRUE(tff_ow_write(&tff_ow, data));
+
+  tff_ow_get_stats(&tff_ow, &stats);
+  TEST_ASSERT_EQUAL(4, stats.peak_count);
+  TEST_ASSERT_EQUAL(5, stats.written);
+  TEST_ASSERT_EQUAL(2, stats.overflows);
+}
+#endif
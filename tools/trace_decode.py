@@ -0,0 +1,212 @@
+#!/usr/bin/env python3
+"""
+Decode a TinyUSB binary trace ring (CFG_TUSB_TRACE) into a timeline and per-endpoint latency statistics.
+
+The ring is the tu_trace_ring variable, dump it from target e.g with gdb
+    dump binary memory trace.bin &tu_trace_ring ((char*)&tu_trace_ring)+sizeof(tu_trace_ring)
+or save a larger RAM region, the ring is located by its magic.
+
+Usage: trace_decode.py trace.bin [--clock-hz 48000000] [--no-timeline] [--no-stats]
+"""
+
+import argparse
+import struct
+import sys
+
+TRACE_MAGIC = 0x52545554
+HEADER_FMT = '<IHHI'  # magic, depth, rec_size, wr_count
+RECORD_FMT = '<IBBBBI'  # timestamp, id, rhport, addr, arg8, arg32
+
+# Keep in sync with src/common/tusb_trace.h
+TRACE_ID = ['NONE', 'EVENT_ISR', 'EVENT_TASK', 'XFER_SUBMIT', 'XFER_CB_DONE', 'CONTROL_STAGE', 'USER']
+EVENT_ISR, EVENT_TASK, XFER_SUBMIT, XFER_CB_DONE, CONTROL_STAGE = 1, 2, 3, 4, 5
+
+# src/device/dcd.h
+EVENT_NAME = ['INVALID', 'BUS_RESET', 'UNPLUGGED', 'SOF', 'SUSPEND', 'RESUME', 'SETUP_RECEIVED', 'XFER_COMPLETE',
+              'FUNC_CALL']
+EVENT_SETUP_RECEIVED, EVENT_XFER_COMPLETE = 6, 7
+
+XFER_KIND = ['buffer', 'sg', 'fifo']
+XFER_RESULT = ['SUCCESS', 'FAILED', 'STALLED']
+CONTROL_STAGE_NAME = ['IDLE', 'SETUP', 'DATA', 'ACK']
+
+
+def name_of(table, idx):
+    return table[idx] if idx < len(table) else str(idx)
+
+
+def find_ring(data):
+    """Return offset of the ring header, header must be 4-byte aligned"""
+    magic = struct.pack('<I', TRACE_MAGIC)
+    pos = data.find(magic)
+    while pos >= 0:
+        if pos % 4 == 0 and pos + struct.calcsize(HEADER_FMT) <= len(data):
+            _, depth, rec_size, _ = struct.unpack_from(HEADER_FMT, data, pos)
+            if depth and rec_size == struct.calcsize(RECORD_FMT):
+                return pos
+        pos = data.find(magic, pos + 1)
+    return -1
+
+
+def parse_ring(data):
+    """Return records as list of dict, oldest first"""
+    pos = find_ring(data)
+    if pos < 0:
+        sys.exit('trace ring not found (magic 0x{:08X})'.format(TRACE_MAGIC))
+
+    _, depth, rec_size, wr_count = struct.unpack_from(HEADER_FMT, data, pos)
+    pos += struct.calcsize(HEADER_FMT)
+
+    if pos + depth * rec_size > len(data):
+        sys.exit('dump is truncated: ring has {} records of {} bytes'.format(depth, rec_size))
+
+    count = min(wr_count, depth)
+    first = wr_count - count
+    records = []
+    for seq in range(first, wr_count):
+        ts, rid, rhport, addr, arg8, arg32 = struct.unpack_from(RECORD_FMT, data, pos + (seq % depth) * rec_size)
+        records.append({'seq': seq, 'ts': ts, 'id': rid, 'rhport': rhport, 'addr': addr, 'arg8': arg8,
+                        'arg32': arg32})
+
+    return records, wr_count, depth
+
+
+def describe(rec):
+    rid, addr, arg8, arg32 = rec['id'], rec['addr'], rec['arg8'], rec['arg32']
+
+    if rid in (EVENT_ISR, EVENT_TASK):
+        if arg8 == EVENT_XFER_COMPLETE:
+            return '{} EP {:02X} {} bytes'.format(name_of(EVENT_NAME, arg8), addr, arg32)
+        if arg8 == EVENT_SETUP_RECEIVED:
+            return '{} bRequest {} wLength {}'.format(name_of(EVENT_NAME, arg8), addr, arg32)
+        return name_of(EVENT_NAME, arg8)
+    if rid == XFER_SUBMIT:
+        return 'EP {:02X} {} bytes ({})'.format(addr, arg32, name_of(XFER_KIND, arg8))
+    if rid == XFER_CB_DONE:
+        return 'EP {:02X} {} bytes {}'.format(addr, arg32, name_of(XFER_RESULT, arg8))
+    if rid == CONTROL_STAGE:
+        return '{} bRequest {} {} bytes'.format(name_of(CONTROL_STAGE_NAME, arg8), addr, arg32)
+    return 'addr {:02X} arg8 {} arg32 {}'.format(addr, arg8, arg32)
+
+
+class Stat:
+    def __init__(self):
+        self.values = []
+
+    def add(self, v):
+        self.values.append(v)
+
+    def row(self, scale):
+        if not self.values:
+            return ['-'] * 4
+        v = [x * scale for x in self.values]
+        return [str(len(v)), '{:.2f}'.format(min(v)), '{:.2f}'.format(sum(v) / len(v)), '{:.2f}'.format(max(v))]
+
+
+class EndpointStats:
+    """Latency of each stage of a transfer, matched in order per endpoint"""
+    STAGES = [('submit -> complete', 'xfer'), ('complete -> task', 'dispatch'), ('task -> cb done', 'callback'),
+              ('cb done -> submit', 'gap')]
+
+    def __init__(self):
+        self.submit = []
+        self.isr = []
+        self.task = []
+        self.last_cb_done = None
+        self.bytes = 0
+        self.stats = {key: Stat() for _, key in self.STAGES}
+
+
+def tick_diff(a, b):
+    # timestamp is a wrapping 32-bit counter
+    return (b - a) & 0xFFFFFFFF
+
+
+def compute_stats(records):
+    eps = {}
+
+    for rec in records:
+        rid = rec['id']
+        if rid == XFER_SUBMIT:
+            key = (rec['rhport'], rec['addr'])
+        elif rid in (EVENT_ISR, EVENT_TASK) and rec['arg8'] == EVENT_XFER_COMPLETE:
+            key = (rec['rhport'], rec['addr'])
+        elif rid == XFER_CB_DONE:
+            key = (rec['rhport'], rec['addr'])
+        else:
+            continue
+
+        # control endpoint is covered by control stages
+        if key[1] & 0x7F == 0:
+            continue
+
+        ep = eps.setdefault(key, EndpointStats())
+        ts = rec['ts']
+
+        if rid == XFER_SUBMIT:
+            if ep.last_cb_done is not None:
+                ep.stats['gap'].add(tick_diff(ep.last_cb_done, ts))
+                ep.last_cb_done = None
+            ep.submit.append(ts)
+        elif rid == EVENT_ISR:
+            # submit can be older than the ring
+            if ep.submit:
+                ep.stats['xfer'].add(tick_diff(ep.submit.pop(0), ts))
+            ep.isr.append(ts)
+            ep.bytes += rec['arg32']
+        elif rid == EVENT_TASK:
+            if ep.isr:
+                ep.stats['dispatch'].add(tick_diff(ep.isr.pop(0), ts))
+            ep.task.append(ts)
+        elif rid == XFER_CB_DONE:
+            if ep.task:
+                ep.stats['callback'].add(tick_diff(ep.task.pop(0), ts))
+            ep.last_cb_done = ts
+
+    return eps
+
+
+def main():
+    parser = argparse.ArgumentParser(description='Decode TinyUSB binary trace ring')
+    parser.add_argument('dump', help='binary dump containing tu_trace_ring')
+    parser.add_argument('--clock-hz', type=float, default=0,
+                        help='timestamp clock, times are shown in us instead of ticks if specified')
+    parser.add_argument('--no-timeline', action='store_true', help='do not print the timeline')
+    parser.add_argument('--no-stats', action='store_true', help='do not print per-endpoint statistics')
+    args = parser.parse_args()
+
+    with open(args.dump, 'rb') as f:
+        data = f.read()
+
+    records, wr_count, depth = parse_ring(data)
+
+    scale = 1e6 / args.clock_hz if args.clock_hz else 1
+    unit = 'us' if args.clock_hz else 'ticks'
+
+    print('{} records written, {} kept (depth {})'.format(wr_count, len(records), depth))
+
+    if not args.no_timeline and records:
+        print()
+        print('{:>8} {:>14} {:>14} {:>5} {:14} {}'.format('seq', 'time ' + unit, 'delta', 'port', 'id', 'detail'))
+        t0 = prev = records[0]['ts']
+        for rec in records:
+            print('{:>8} {:>14.2f} {:>14.2f} {:>5} {:14} {}'.format(
+                rec['seq'], tick_diff(t0, rec['ts']) * scale, tick_diff(prev, rec['ts']) * scale, rec['rhport'],
+                name_of(TRACE_ID, rec['id']), describe(rec)))
+            prev = rec['ts']
+
+    if not args.no_stats:
+        eps = compute_stats(records)
+        print()
+        print('Per-endpoint latency ({})'.format(unit))
+        print('{:>4} {:>4} {:>10} {:20} {:>7} {:>10} {:>10} {:>10}'.format(
+            'port', 'ep', 'bytes', 'stage', 'count', 'min', 'avg', 'max'))
+        for (rhport, ep_addr) in sorted(eps):
+            ep = eps[(rhport, ep_addr)]
+            for label, key in EndpointStats.STAGES:
+                print('{:>4} {:>4} {:>10} {:20} {:>7} {:>10} {:>10} {:>10}'.format(
+                    rhport, '{:02X}'.format(ep_addr), ep.bytes, label, *ep.stats[key].row(scale)))
+
+
+if __name__ == '__main__':
+    main()